@@ -1,38 +1,58 @@
 
 #include <iostream>
 #include <QApplication>
+#include <QDebug>
 #include <QThread>
+#include <QTimer>
 
 #include "commandetrain.h"
 #include "mainwindow.h"
+#include "trainsimsettings.h"
 
 
 
-static MainWindow *mainwindow;
-static SimView* simView;
-
-
-
-
-
-CommandeTrain::CommandeTrain()
+CommandeTrain::CommandeTrain(bool principale)
+    : principale(principale)
 {
     command = "";
     mutex = new QMutex();
     VarCond = new QWaitCondition();
     waitingOn=false;
+    rejoueur = nullptr;
+
+    // Les réglages de l'interface ne s'appliquent qu'au contexte par défaut
+    if (principale)
+        reglages = TrainSimSettings::getInstance();
+    else
+        reglages = new TrainSimSettings(*TrainSimSettings::getInstance());
 }
 
 CommandeTrain* CommandeTrain::getInstance()
 {
-    static CommandeTrain instance;
-    return &instance;
+    return &contexteDefaut()->commande;
+}
+
+TrainContext* CommandeTrain::contexteDefaut()
+{
+    static TrainContext contexte(true);
+    return &contexte;
 }
 
 void CommandeTrain::init_maquette(void)
 {
-    mainwindow=new MainWindow();
-    mainwindow->show();
+    if (rejoueur != nullptr)
+    {
+        // Pas de simulateur : le rejoueur fournit les activations de contacts.
+        rejoueur->start();
+        QTimer::singleShot(10, this, SLOT(timerTrigger()));
+        return;
+    }
+
+    mainwindow=new MainWindow(this, reglages);
+    if (mesures.estActif())
+        reglages->setModeRapide(true);
+    else if (principale)
+        mainwindow->show();
 
     simView = mainwindow->getSimView();
 
@@ -42,12 +62,22 @@ void CommandeTrain::init_maquette(void)
     CONNECT(this, SIGNAL(reverseLoco(int)), simView, SLOT(reverseLoco(int)));
     CONNECT(this, SIGNAL(setVitesseProgressiveLoco(int,int)), simView, SLOT(setVitesseProgressiveLoco(int,int)));
     CONNECT(this, SIGNAL(setVoieVariable(int,int)), simView, SLOT(setVoieVariable(int,int)));
+    CONNECT(this, SIGNAL(setDestinationLoco(int,int)), simView, SLOT(setDestinationLoco(int,int)));
+    CONNECT(this, SIGNAL(setProfilVitesseLoco(int,int,int)), simView, SLOT(setProfilVitesseLoco(int,int,int)));
     CONNECT(this, SIGNAL(addLoco(int)),mainwindow,SLOT(addLoco(int)));
     CONNECT(this, SIGNAL(selectMaquette(QString)),mainwindow,SLOT(selectionMaquette(QString)));
     CONNECT(this, SIGNAL(afficheMessage(QString)),mainwindow,SLOT(afficherMessage(QString)));
     CONNECT(this, SIGNAL(afficheMessageLoco(int,QString)),mainwindow,SLOT(afficherMessageLoco(int,QString)));
+    CONNECT(simView, SIGNAL(contactActive(int)), this, SLOT(contactActive(int)));
+
+    if (periodeImages >= 0)
+        simView->setExportImages(&exportImages, periodeImages);
+    if (mesures.estActif())
+        simView->setMesures(&mesures);
 
-    QTimer::singleShot(10, this, SLOT(timerTrigger()));
+    // Les autres contextes sont pilotés par le programme qui les a créés
+    if (principale)
+        QTimer::singleShot(10, this, SLOT(timerTrigger()));
 }
 
 
@@ -79,8 +109,6 @@ protected:
     }
 };
 
-static UserThread *userThread = nullptr;
-
 CommandeTrain::~CommandeTrain()
 {
     if (userThread != nullptr) {
@@ -88,23 +116,105 @@ CommandeTrain::~CommandeTrain()
         userThread->wait();
         delete userThread;
     }
+    if (rejoueur != nullptr) {
+        rejoueur->interrompre();
+        rejoueur->wait();
+        delete rejoueur;
+    }
+    enregistreur.arreter();
+    exportImages.arreter();
+
+    // La fenêtre du contexte par défaut est détruite avec l'application
+    if (!principale) {
+        delete mainwindow;
+        delete reglages;
+    }
+}
+
+bool CommandeTrain::enregistrer_trace(QString fichier)
+{
+    return enregistreur.demarrer(fichier);
+}
+
+bool CommandeTrain::exporter_images(QString dossier, int periode, bool brut)
+{
+    if (!exportImages.demarrer(dossier, brut ? ExportImages::BRUT : ExportImages::PNG))
+        return false;
+    periodeImages = qMax(periode, 0);
+    return true;
+}
+
+void CommandeTrain::executer_batch(QString fichier, qint64 duree)
+{
+    mesures.demarrer(fichier, duree);
+}
+
+void CommandeTrain::demarrer_simulation(void)
+{
+    // Avec une fenêtre, la simulation est démarrée par l'utilisateur
+    if ((principale && !mesures.estActif()) || simView == nullptr)
+        return;
+    QMetaObject::invokeMethod(simView, "animationStart", Qt::QueuedConnection);
+}
+
+void CommandeTrain::debut_mesure(const char *nom, int no_loco)
+{
+    if (!mesures.estActif() || simView == nullptr)
+        return;
+    mesures.debutMesure(QString::fromLocal8Bit(nom), no_loco, simView->getTempsSimulation());
+}
+
+void CommandeTrain::fin_mesure(const char *nom, int no_loco)
+{
+    if (!mesures.estActif() || simView == nullptr)
+        return;
+    mesures.finMesure(QString::fromLocal8Bit(nom), no_loco, simView->getTempsSimulation());
+}
+
+bool CommandeTrain::rejouer_trace(QString fichier)
+{
+    TraceRejoueur *r = new TraceRejoueur();
+    if (!r->charger(fichier))
+    {
+        delete r;
+        return false;
+    }
+    rejoueur = r;
+    return true;
+}
+
+bool CommandeTrain::intercepter(quint8 type, int numero, int a, int b, int c)
+{
+    if (rejoueur != nullptr)
+    {
+        rejoueur->commande(type, numero, a, b, c);
+        return true;
+    }
+    enregistreur.enregistrer(simView != nullptr ? simView->getTempsSimulation() : 0, type, numero, a, b, c);
+    return false;
+}
+
+void CommandeTrain::contactActive(int numContact)
+{
+    enregistreur.enregistrer(simView->getTempsSimulation(), EvenementTrace::ACTIVATION_CONTACT, numContact);
 }
 
 void CommandeTrain::timerTrigger()
 {
 
 
-    userThread=new UserThread();
-    if (!userThread->initialize()) {
+    UserThread *thread = new UserThread();
+    if (!thread->initialize()) {
         exit(0);
     }
+    userThread = thread;
     userThread->start();
 
 }
 
 void CommandeTrain::mettre_maquette_hors_service(void)
 {
-
+    enregistreur.arreter();
 }
 
 void CommandeTrain::mettre_maquette_en_service(void)
@@ -119,11 +229,20 @@ void CommandeTrain::ajouter_loco(int no_loco)
 
 void CommandeTrain::diriger_aiguillage(int no_aiguillage, int direction, int /*temps_alim*/)
 {
+    if (intercepter(EvenementTrace::AIGUILLAGE, no_aiguillage, direction))
+        return;
     emit setVoieVariable(no_aiguillage, direction);
 }
 
 void CommandeTrain::attendre_contact(int no_contact)
 {
+    if (rejoueur != nullptr)
+    {
+        rejoueur->attendreContact(no_contact);
+        return;
+    }
+    enregistreur.enregistrer(simView->getTempsSimulation(), EvenementTrace::ATTENTE_CONTACT, no_contact);
+
     Contact *c=simView->getContact(no_contact);
     if (c == nullptr)
     {
@@ -133,16 +252,202 @@ void CommandeTrain::attendre_contact(int no_contact)
         c->attendContact();
 }
 
+void CommandeTrain::attendre_contact_async(int no_contact, void (*rappel)(int, void *), void *donnees)
+{
+    if (rejoueur != nullptr)
+    {
+        rejoueur->attendreContactAsync(no_contact, rappel, donnees);
+        return;
+    }
+    enregistreur.enregistrer(simView->getTempsSimulation(), EvenementTrace::ATTENTE_CONTACT, no_contact);
+
+    Contact *c=simView->getContact(no_contact);
+    if (c == nullptr)
+    {
+        qWarning() << QString("Attention, le numéro de contact %1 n'est pas valide").arg(no_contact);
+    }
+    else
+        c->ajouterRappel(rappel, donnees);
+}
+
+void CommandeTrain::attendre_delai_async(int delai_ms, void (*rappel)(void *), void *donnees)
+{
+    if (rejoueur != nullptr)
+    {
+        // Le rejeu n'a pas de temps simulé : le rappel est immédiat
+        rappel(donnees);
+        return;
+    }
+
+    // Le délai s'écoule en temps simulé, compté par le simulateur dans son thread
+    QMetaObject::invokeMethod(simView, [this, delai_ms, rappel, donnees]() {
+        simView->ajouterDelai(delai_ms, [rappel, donnees]() { rappel(donnees); });
+    }, Qt::QueuedConnection);
+}
+
+void CommandeTrain::activer_canton_mobile(int actif, void (*rappel)(int, int, void *), void *donnees)
+{
+    // Le rejeu n'a pas de simulateur pour calculer les réservations
+    if (rejoueur != nullptr)
+        return;
+
+    QMetaObject::invokeMethod(simView, [this, actif, rappel, donnees]() {
+        simView->setCantonMobile(actif != 0, rappel, donnees);
+    }, Qt::QueuedConnection);
+}
+
+int CommandeTrain::calculer_itineraire(int contact_precedent, int contact_depart, int contact_arrivee,
+                                       int *contacts, int max_contacts,
+                                       int *aiguillages, int *directions, int max_aiguillages,
+                                       int *nb_aiguillages)
+{
+    QVector<int> parcours;
+    QVector<QPair<int, int> > positions;
+    *nb_aiguillages = 0;
+
+    if (rejoueur != nullptr)
+    {
+        rejoueur->itineraire(contact_precedent, contact_depart, contact_arrivee, parcours, positions);
+    }
+    else
+    {
+        // Le réseau de voies appartient au thread du simulateur
+        QMetaObject::invokeMethod(simView, [&]() {
+            simView->calculerItineraire(contact_precedent, contact_depart, contact_arrivee, parcours, positions);
+        }, Qt::BlockingQueuedConnection);
+
+        // Le résultat est enregistré à la suite de l'appel, pour le rejeu
+        QVector<EvenementTrace> evenements;
+        evenements.append(EvenementTrace{0, EvenementTrace::ITINERAIRE, quint8(contact_depart),
+                                         qint16(contact_arrivee), qint16(contact_precedent), 0});
+        for (int c : parcours)
+            evenements.append(EvenementTrace{0, EvenementTrace::ITINERAIRE_CONTACT, quint8(c), 0, 0, 0});
+        for (const auto& a : positions)
+            evenements.append(EvenementTrace{0, EvenementTrace::ITINERAIRE_AIGUILLAGE, quint8(a.first), qint16(a.second), 0, 0});
+        enregistreur.enregistrer(simView->getTempsSimulation(), evenements);
+    }
+
+    if (parcours.size() > max_contacts || positions.size() > max_aiguillages)
+        return 0;
+
+    for (int i = 0; i < parcours.size(); i++)
+        contacts[i] = parcours.at(i);
+    for (int i = 0; i < positions.size(); i++)
+    {
+        aiguillages[i] = positions.at(i).first;
+        directions[i] = positions.at(i).second;
+    }
+    *nb_aiguillages = positions.size();
+    return parcours.size();
+}
+
+void CommandeTrain::diriger_loco_vers(int no_loco, int contact_arrivee)
+{
+    if (intercepter(EvenementTrace::DESTINATION, no_loco, contact_arrivee))
+        return;
+    emit setDestinationLoco(no_loco, contact_arrivee);
+}
+
+int CommandeTrain::lire_position_loco(int no_loco, position_loco *position)
+{
+    // Le rejeu n'a pas de simulateur, donc pas de locos
+    if (rejoueur != nullptr || simView == nullptr || no_loco < 0 || no_loco > MAX_LOCOS)
+        return 0;
+
+    InstantaneSimulation etat;
+    simView->getEtat().lire(etat);
+    const PositionLoco& p = etat.locos[no_loco];
+    if (!p.presente)
+        return 0;
+
+    position->voie = p.voie;
+    position->segment = p.segment;
+    position->contact_arriere = p.contactArriere;
+    position->contact_avant = p.contactAvant;
+    position->vitesse = p.vitesse;
+    position->distance_contact = qRound(p.distanceContact);
+    return 1;
+}
+
+int CommandeTrain::lire_occupation_segments(unsigned char *occupation, int taille)
+{
+    if (rejoueur != nullptr || simView == nullptr)
+        return 0;
+
+    InstantaneSimulation etat;
+    simView->getEtat().lire(etat);
+    for (int i = 0; i < taille; i++)
+        occupation[i] = 0;
+    for (int s = 0; s < etat.nbreSegments && s / 8 < taille; s++)
+    {
+        if (etat.occupation[s / 64] & (quint64(1) << (s % 64)))
+            occupation[s / 8] |= 1 << (s % 8);
+    }
+    return etat.nbreSegments;
+}
+
+int CommandeTrain::lire_contacts_segment(int no_segment, int *contact_a, int *contact_b)
+{
+    if (rejoueur != nullptr || simView == nullptr)
+        return 0;
+
+    InstantaneSimulation etat;
+    simView->getEtat().lire(etat);
+    if (no_segment < 0 || no_segment >= etat.nbreSegments)
+        return 0;
+    *contact_a = etat.contactsSegments[no_segment][0];
+    *contact_b = etat.contactsSegments[no_segment][1];
+    return 1;
+}
+
+int CommandeTrain::sauver_etat(const char *nom_fichier)
+{
+    if (rejoueur != nullptr || simView == nullptr)
+        return 0;
+
+    // L'état appartient au thread du simulateur
+    bool ok = false;
+    QString nom = QString::fromLocal8Bit(nom_fichier);
+    QMetaObject::invokeMethod(simView, [&]() {
+        ok = simView->sauverEtat(nom);
+    }, Qt::BlockingQueuedConnection);
+    return ok ? 1 : 0;
+}
+
+int CommandeTrain::charger_etat(const char *nom_fichier)
+{
+    if (rejoueur != nullptr || simView == nullptr)
+        return 0;
+
+    bool ok = false;
+    QString nom = QString::fromLocal8Bit(nom_fichier);
+    QMetaObject::invokeMethod(simView, [&]() {
+        ok = simView->chargerEtat(nom);
+    }, Qt::BlockingQueuedConnection);
+    return ok ? 1 : 0;
+}
+
 void CommandeTrain::arreter_loco(int no_loco)
 {
+    if (intercepter(EvenementTrace::ARRET, no_loco))
+        return;
     emit setVitesseLoco(no_loco, 0);
 }
 
 void CommandeTrain::mettre_vitesse_progressive(int no_loco, int vitesse_future)
 {
+    if (intercepter(EvenementTrace::VITESSE_PROGRESSIVE, no_loco, vitesse_future))
+        return;
     emit setVitesseProgressiveLoco(no_loco, vitesse_future);
 }
 
+void CommandeTrain::mettre_vitesse_au_contact(int no_loco, int vitesse, int no_contact)
+{
+    if (intercepter(EvenementTrace::VITESSE_CONTACT, no_loco, vitesse, no_contact))
+        return;
+    emit setProfilVitesseLoco(no_loco, vitesse, no_contact);
+}
+
 void CommandeTrain::mettre_fonction_loco(int /*no_loco*/, char /*etat*/)
 {
     //sans effets sur le simulateur.
@@ -150,11 +455,15 @@ void CommandeTrain::mettre_fonction_loco(int /*no_loco*/, char /*etat*/)
 
 void CommandeTrain::inverser_sens_loco(int no_loco)
 {
+    if (intercepter(EvenementTrace::INVERSION, no_loco))
+        return;
     emit reverseLoco(no_loco);
 }
 
 void CommandeTrain::mettre_vitesse_loco(int no_loco, int vitesse)
 {
+    if (intercepter(EvenementTrace::VITESSE, no_loco, vitesse))
+        return;
     emit setVitesseLoco(no_loco, vitesse);
 }
 
@@ -165,12 +474,16 @@ void CommandeTrain::demander_loco(int contact_a, int contact_b, int */*no_loco*/
 
 void CommandeTrain::assigner_loco(int contact_a,int contact_b,int no_loco,int vitesse)
 {
+    if (intercepter(EvenementTrace::ASSIGNATION, no_loco, contact_a, contact_b, vitesse))
+        return;
     emit addLoco(no_loco);
     emit setLoco(contact_a, contact_b, no_loco, vitesse);
 }
 
 void CommandeTrain::selection_maquette(QString maquette)
 {
+    if (rejoueur != nullptr)
+        return;
     emit selectMaquette(maquette);
     mainwindow->semWaitMaquette.acquire();
     mainwindow->maquetteFinie.acquire();
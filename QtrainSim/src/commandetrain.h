@@ -5,8 +5,18 @@
 #include <QString>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QByteArray>
 
 #include "general.h"
+#include "ctrain_handler.h"
+#include "simtrace.h"
+#include "exportimages.h"
+#include "mesuresbatch.h"
+
+class MainWindow;
+class SimView;
+class QThread;
+class TrainSimSettings;
 
 /**
   Toutes les methodes de cette classe doivent être reentrantes!!!!!!!
@@ -14,25 +24,32 @@
 class CommandeTrain : public QObject
 {
     Q_OBJECT
-protected:
+public:
     /**
-      Constructeur vide.
-      */
-    CommandeTrain();
+     * Constructeur.
+     * \param principale Vrai pour la commande du contexte par défaut : elle affiche
+     * sa fenêtre, partage les réglages de l'interface et lance cmain(). Les autres
+     * simulent sans fenêtre, avec une copie des réglages.
+     */
+    explicit CommandeTrain(bool principale = false);
 
     /**
       Destructeur
       */
     ~CommandeTrain();
 
-public:
-
     /**
-     * Retourne l'unique instance de la commande de train.
-     * Si le singleton n'a pas encore ete cree il l'est de maniere automatique.
+     * Retourne la commande de train du contexte par défaut.
+     * Si elle n'a pas encore ete creee elle l'est de maniere automatique.
      */
     static CommandeTrain *getInstance();
 
+    /**
+     * Retourne le contexte par défaut, celui des fonctions de ctrain_handler.h
+     * sans contexte.
+     */
+    static TrainContext *contexteDefaut();
+
 
 
     /**
@@ -76,6 +93,89 @@ public:
      */
     void attendre_contact(int no_contact);
 
+    /**
+     * Méthode non bloquante : la fonction rappel sera appelée une fois, lors de
+     * la prochaine activation du contact voulu.
+     * \param no_contact  Numéro du contact dont on attend l'activation.
+     * \param rappel      Fonction appelée depuis le thread du simulateur.
+     * \param donnees     Pointeur transmis à la fonction rappel.
+     */
+    void attendre_contact_async(int no_contact, void (*rappel)(int, void *), void *donnees);
+
+    /**
+     * Méthode non bloquante : la fonction rappel sera appelée par la boucle
+     * d'événements du simulateur après le délai donné.
+     * \param delai_ms  Délai en millisecondes.
+     * \param rappel    Fonction à appeler.
+     * \param donnees   Pointeur transmis à la fonction rappel.
+     * Remarque : en mode rejeu, le rappel est appelé immédiatement.
+     */
+    void attendre_delai_async(int delai_ms, void (*rappel)(void *), void *donnees);
+
+    /**
+     * Active ou désactive l'espacement des locos par canton mobile, voir ctrain_handler.h.
+     * \param actif     Non nul pour activer le canton mobile.
+     * \param rappel    Fonction appelée depuis le thread du simulateur à chaque
+     *                  changement de limitation, ou nullptr.
+     * \param donnees   Pointeur transmis à la fonction rappel.
+     * Remarque : sans effet en mode rejeu.
+     */
+    void activer_canton_mobile(int actif, void (*rappel)(int, int, void *), void *donnees);
+
+    /**
+     * Calcule l'itinéraire le plus court entre deux contacts, voir ctrain_handler.h.
+     * Le calcul est fait par le thread du simulateur ; en mode rejeu, le résultat
+     * est lu dans la trace.
+     * \return le nombre de contacts de l'itinéraire, 0 s'il n'y en a pas.
+     */
+    int calculer_itineraire(int contact_precedent, int contact_depart, int contact_arrivee,
+                            int *contacts, int max_contacts,
+                            int *aiguillages, int *directions, int max_aiguillages,
+                            int *nb_aiguillages);
+
+    /**
+     * Confie au simulateur le choix du chemin d'une loco, voir ctrain_handler.h.
+     * \param no_loco         Numéro de la loco.
+     * \param contact_arrivee Contact à atteindre, 0 pour arrêter le routage.
+     */
+    void diriger_loco_vers(int no_loco, int contact_arrivee);
+
+    /**
+     * Lit la position d'une loco dans l'état publié par le simulateur, sans verrou.
+     * \param no_loco   Numéro de la loco.
+     * \param position  Position à remplir.
+     * \return 1 si la loco est sur la maquette, 0 sinon.
+     */
+    int lire_position_loco(int no_loco, position_loco *position);
+
+    /**
+     * Lit l'occupation des segments dans l'état publié par le simulateur, sans verrou.
+     * \param occupation  Un bit par segment, à remplir.
+     * \param taille      Taille du tableau en octets.
+     * \return le nombre de segments.
+     */
+    int lire_occupation_segments(unsigned char *occupation, int taille);
+
+    /**
+     * Lit les contacts aux extrémités d'un segment.
+     * \return 1 si le segment existe, 0 sinon.
+     */
+    int lire_contacts_segment(int no_segment, int *contact_a, int *contact_b);
+
+    /**
+     * Enregistre l'état complet de la simulation, voir SimView::sauverEtat().
+     * \param nom_fichier  Fichier à créer.
+     * \return 1 si l'état a été enregistré, 0 sinon.
+     */
+    int sauver_etat(const char *nom_fichier);
+
+    /**
+     * Restaure un état enregistré, voir SimView::chargerEtat().
+     * \param nom_fichier  Fichier à lire.
+     * \return 1 si l'état a été restauré, 0 sinon.
+     */
+    int charger_etat(const char *nom_fichier);
+
     /**
      * Arrete une locomotive (met sa vitesse à  VITESSE_NULLE).
      * \param no_loco  Numéro de la loco à  stopper.
@@ -93,6 +193,15 @@ public:
      */
     void mettre_vitesse_progressive(int no_loco, int vitesse_future);
 
+    /**
+     * Fait ralentir une loco pour qu'elle franchisse un contact à la vitesse donnée,
+     * voir ctrain_handler.h.
+     * \param no_loco    Numéro de la loco.
+     * \param vitesse    Vitesse au passage du contact.
+     * \param no_contact Contact devant la loco.
+     */
+    void mettre_vitesse_au_contact(int no_loco, int vitesse, int no_contact);
+
     /**
      * Permettre d'allumer ou d'eteindre les phares de la locomotive.
      * \param no_loco  No de la loco a controler.
@@ -154,9 +263,69 @@ public:
 
     QString getCommand();
 
+    /**
+     * Enregistre toutes les commandes et les activations de contacts, horodatées
+     * en temps simulé, dans une trace binaire.
+     * \param fichier Fichier de trace à créer.
+     * \return vrai si le fichier a pu être créé.
+     */
+    bool enregistrer_trace(QString fichier);
+
+    /**
+     * Rejoue une trace enregistrée au lieu de lancer le simulateur : les contacts
+     * sont activés dans l'ordre enregistré, aussi vite que possible.
+     * A appeler avant init_maquette().
+     * \param fichier Fichier de trace à rejouer.
+     * \return vrai si la trace a pu être chargée.
+     */
+    bool rejouer_trace(QString fichier);
+
+    /**
+     * Exporte des images de la simulation pendant son déroulement, pour analyser
+     * une collision ou produire une vidéo. A appeler avant init_maquette().
+     * \param dossier Dossier où écrire les images.
+     * \param periode Nombre de pas de simulation entre deux images ; 0 pour
+     * n'exporter qu'en cas de collision.
+     * \param brut Vrai pour des pixels RGBA non compressés, faux pour du PNG.
+     * \return vrai si le dossier est utilisable.
+     */
+    bool exporter_images(QString dossier, int periode, bool brut);
+
+    /**
+     * Lance le simulateur sans interface, pour qtrainsim_batch : la fenêtre n'est
+     * pas affichée, la simulation va aussi vite que possible et l'application se
+     * termine une fois la durée écoulée, en écrivant ses mesures.
+     * A appeler avant init_maquette().
+     * \param fichier Fichier JSON où écrire les mesures.
+     * \param duree Durée de la simulation, en millisecondes de temps simulé.
+     */
+    void executer_batch(QString fichier, qint64 duree);
+
+    /**
+     * Démarre une simulation sans fenêtre : exécution en batch ou contexte créé
+     * par creer_contexte(). Sans effet avec l'interface, d'où la simulation est
+     * démarrée par l'utilisateur.
+     */
+    void demarrer_simulation(void);
+
+    /**
+     * Commence ou termine une durée mesurée en temps simulé, par exemple l'attente
+     * d'une section partagée. Sans effet hors de l'exécution en batch.
+     * \param nom  Nom de la mesure.
+     * \param no_loco  Numéro de la loco mesurée.
+     */
+    void debut_mesure(const char *nom, int no_loco);
+    void fin_mesure(const char *nom, int no_loco);
+
 public slots:
     void commandSent(QString command);
 
+    /**
+     * Reçoit l'activation d'un contact par une loco, pour l'enregistrement.
+     * \param numContact Numéro du contact activé.
+     */
+    void contactActive(int numContact);
+
 protected slots:
     void timerTrigger();
 
@@ -169,15 +338,47 @@ signals:
     void setVitesseProgressiveLoco(int numLoco, int vitesseLoco);
     void stopLoco(int numLoco);
     void setVoieVariable(int numVoieVariable, int direction);
+    void setDestinationLoco(int numLoco, int contact);
+    void setProfilVitesseLoco(int numLoco, int vitesseLoco, int numContact);
     void selectMaquette(QString maquette);
     void afficheMessage(QString message);
     void afficheMessageLoco(int numLoco,QString message);
 
 private:
+    /**
+     * Transmet la commande au rejoueur en mode rejeu, ou l'enregistre sinon.
+     * \return vrai si la commande a été traitée par le rejoueur.
+     */
+    bool intercepter(quint8 type, int numero, int a = 0, int b = 0, int c = 0);
+
+    TraceEnregistreur enregistreur;
+    TraceRejoueur* rejoueur;
+    ExportImages exportImages;
+    int periodeImages{-1};      //!< -1 si l'export d'images n'est pas demandé
+    MesuresBatch mesures;
+
+    bool principale;
+    TrainSimSettings* reglages;
+    MainWindow* mainwindow{nullptr};
+    SimView* simView{nullptr};
+    QThread* userThread{nullptr};
+
     QString command;
     QWaitCondition* VarCond;
     QMutex* mutex;
     bool waitingOn;
 };
 
+/**
+ * Contexte d'une simulation, opaque pour l'interface C (voir ctrain_handler.h) :
+ * sa commande de train et ce que les fonctions C doivent garder entre deux appels.
+ */
+struct TrainContext
+{
+    explicit TrainContext(bool principal = false) : commande(principal) {}
+
+    CommandeTrain commande;
+    QByteArray derniereCommande;    //!< chaîne retournée par getCommand_ctx()
+};
+
 #endif // COMMANDETRAIN_H
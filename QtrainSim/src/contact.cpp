@@ -16,6 +16,12 @@ Contact::Contact(int numContact, int numVoiePorteuse, QObject *parent) :
     VarCond = new QWaitCondition();
     setZValue(ZVAL_CONTACT);
     waitingOn=false;
+    setAngle(0.0);
+
+    // Le texte du numéro ne change pas : sa mise en page est calculée une fois.
+    etiquette.setText(QString::number(numContact));
+    etiquette.setTextFormat(Qt::PlainText);
+    etiquette.prepare(QTransform(), FONTE_CONTACT);
 }
 
 int Contact::getNumContact()
@@ -28,16 +34,57 @@ void Contact::attendContact()
 {
     mutex->lock();
     waitingOn=true;
+    attentes++;
     update();
     VarCond->wait(mutex);
+    attentes--;
     waitingOn=false;
     update();
     mutex->unlock();
 }
 
+void Contact::ajouterRappel(void (*rappel)(int, void *), void *donnees)
+{
+    mutex->lock();
+    rappels.append(qMakePair(rappel, donnees));
+    if (!waitingOn)
+    {
+        waitingOn=true;
+        update();
+    }
+    mutex->unlock();
+}
+
 void Contact::active()
 {
+    // Les rappels sont à usage unique. Ils sont retirés avant d'être appelés,
+    // un rappel pouvant se réenregistrer sur le même contact.
+    mutex->lock();
+    QList<QPair<void (*)(int, void *), void *> > aAppeler;
+    aAppeler.swap(rappels);
+    if (!aAppeler.isEmpty())
+    {
+        waitingOn=false;
+        update();
+    }
+
+    // L'activation est signalée (et enregistrée dans la trace) avant de réveiller
+    // les threads en attente : une commande envoyée juste après attendre_contact()
+    // ne peut ainsi pas la précéder dans la trace.
+    emit activation(numContact);
+    mutex->unlock();
+
     VarCond->wakeAll();
+    for (const auto& rappel : aAppeler)
+        rappel.first(numContact, rappel.second);
+}
+
+int Contact::getNbreAttentes()
+{
+    mutex->lock();
+    int n = attentes + rappels.size();
+    mutex->unlock();
+    return n;
 }
 
 int Contact::getNumVoiePorteuse()
@@ -48,6 +95,14 @@ int Contact::getNumVoiePorteuse()
 void Contact::setAngle(qreal angle)
 {
     this->angle = angle;
+
+    qreal theangle=angle;
+    while (theangle>PI)
+         theangle-=PI;
+    while (theangle<0.0)
+         theangle+=PI;
+    positionEtiquette = QPointF(TRANSLATION_NUM_CONTACT * cos(theangle),
+                                TRANSLATION_NUM_CONTACT * sin(theangle));
 }
 
 QRectF Contact::boundingRect() const
@@ -57,7 +112,7 @@ QRectF Contact::boundingRect() const
 
 #include <QGraphicsScene>
 
-void Contact::paint(QPainter *painter, const QStyleOptionGraphicsItem */*option*/, QWidget */*widget*/)
+void Contact::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget */*widget*/)
 {
     if (waitingOn)
     {
@@ -71,46 +126,21 @@ void Contact::paint(QPainter *painter, const QStyleOptionGraphicsItem */*option*
     }
     painter->drawEllipse(QPointF(0.0,0.0),TAILLE_CONTACT, TAILLE_CONTACT);
 
+    // Vue de loin, l'étiquette serait illisible.
+    if (option->levelOfDetailFromTransform(painter->worldTransform()) < LOD_DETAILS)
+        return;
+
     if (TrainSimSettings::getInstance()->getViewContactNumber())
     {
-        QString t;
-        t.setNum(numContact);
-
         if (waitingOn)
-        {
             painter->setPen(COULEUR_CONTACT_WAITING);
-            painter->setFont(FONTE_CONTACT);
-        }
         else
-        {
             painter->setPen(COULEUR_FONTE_CONTACT);
-            painter->setFont(FONTE_CONTACT);
-        }
-        qreal theangle=angle;
-        while (theangle>PI)
-             theangle-=PI;
-        while (theangle<0.0)
-             theangle+=PI;
-
-        QRectF r=QRectF(TRANSLATION_NUM_CONTACT * cos(theangle) - 3.0 * TAILLE_CONTACT,
-                        TRANSLATION_NUM_CONTACT * sin(theangle) - 3.0 * TAILLE_CONTACT,
-                        6.0 * TAILLE_CONTACT,
-                        6.0 * TAILLE_CONTACT);
-/*
-        r.translate(this->scenePos());
-        if (this->scene()->items(r,Qt::IntersectsItemShape,Qt::AscendingOrder).size()>=2) {
-            theangle+=PI;
-            r=QRectF(TRANSLATION_NUM_CONTACT * cos(theangle) - 3.0 * TAILLE_CONTACT,
-                                    TRANSLATION_NUM_CONTACT * sin(theangle) - 3.0 * TAILLE_CONTACT,
-                                    6.0 * TAILLE_CONTACT,
-                                    6.0 * TAILLE_CONTACT);
-        }
-        else
-            r.translate(-this->scenePos());
-  */
-        painter->drawText(r,
-                          t,
-                          QTextOption(Qt::AlignHCenter|Qt::AlignVCenter));
-        painter->drawLine(QPointF(0.0,0.0), QPointF(TRANSLATION_NUM_CONTACT * cos(theangle) / 2.0, TRANSLATION_NUM_CONTACT * sin(theangle) / 2.0));
+        painter->setFont(FONTE_CONTACT);
+
+        painter->drawStaticText(positionEtiquette - QPointF(etiquette.size().width() / 2.0,
+                                                            etiquette.size().height() / 2.0),
+                                etiquette);
+        painter->drawLine(QPointF(0.0,0.0), positionEtiquette / 2.0);
     }
 }
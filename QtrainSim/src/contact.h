@@ -5,7 +5,11 @@
 #include <QAbstractGraphicsShapeItem>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QList>
+#include <QPair>
 #include <QPainter>
+#include <QStaticText>
+#include <QStyleOptionGraphicsItem>
 #include <QDebug>
 #include <math.h>
 
@@ -26,11 +30,23 @@ public:
       */
     void attendContact();
 
+    /** Méthode non bloquante : la fonction rappel sera appelée une seule fois,
+      * à la prochaine activation du contact, depuis le thread du simulateur.
+      * \param rappel la fonction à appeler avec le numéro du contact.
+      * \param donnees le pointeur transmis à la fonction.
+      */
+    void ajouterRappel(void (*rappel)(int, void *), void *donnees);
+
     /** Méthode appelée quand une loco passe sur le contact.
       * Libère les threads en attente.
       */
     void active();
 
+    /** retourne le nombre d'attentes en cours sur le contact, bloquantes ou non.
+      * \return le nombre de threads et de rappels en attente.
+      */
+    int getNbreAttentes();
+
     /** retourne le numéro de la voie porteuse.
       * \return le numéro de la voie porteuse.
       */
@@ -57,6 +73,11 @@ public:
     int getNumContact();
 signals:
 
+    /** Signale le passage d'une loco sur le contact.
+      * \param numContact le numéro du contact.
+      */
+    void activation(int numContact);
+
 public slots:
 
 private:
@@ -65,7 +86,11 @@ private:
     QWaitCondition* VarCond;
     QMutex* mutex;
     qreal angle;
+    QPointF positionEtiquette;  //!< centre du numéro du contact, selon l'angle
+    QStaticText etiquette;
     bool waitingOn;
+    int attentes{0};    //!< threads bloqués dans attendContact()
+    QList<QPair<void (*)(int, void *), void *> > rappels;
 };
 
 #endif // CONTACT_H
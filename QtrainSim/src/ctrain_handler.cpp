@@ -9,10 +9,49 @@
  * Revision         : 27.3.2009 (CEZ)
  */
  
+#include <QCoreApplication>
+#include <QThread>
+
 #include "ctrain_handler.h"
 #include "commandetrain.h"
 
-#define CMD_TRAIN CommandeTrain::getInstance()
+#define COMMANDE(contexte) (&(contexte)->commande)
+
+/*
+ * Execute f dans le thread de l'interface, ou vivent les simulateurs.
+ */
+template<typename F>
+static void dansThreadInterface(F f)
+{
+    if (QThread::currentThread() == QCoreApplication::instance()->thread())
+        f();
+    else
+        QMetaObject::invokeMethod(QCoreApplication::instance(), f, Qt::BlockingQueuedConnection);
+}
+
+TrainContext *contexte_defaut(void)
+{
+    return CommandeTrain::contexteDefaut();
+}
+
+TrainContext *creer_contexte(void)
+{
+    TrainContext *contexte = nullptr;
+    dansThreadInterface([&contexte]() {
+        contexte = new TrainContext();
+        contexte->commande.init_maquette();
+    });
+    return contexte;
+}
+
+void detruire_contexte(TrainContext *contexte)
+{
+    if (contexte == nullptr || contexte == contexte_defaut())
+        return;
+    dansThreadInterface([contexte]() {
+        delete contexte;
+    });
+}
 
 #ifndef MAQUETTE
 /*
@@ -20,23 +59,23 @@
  * A appeler au debut du programme client.
  */
 void init_maquette(void) {
-    CMD_TRAIN->init_maquette();
+    COMMANDE(contexte_defaut())->init_maquette();
 }
 
 /*
  * Met fin a la simulation, donc de stopper toute activite sur la maquette. A appeler a
  * la fin du programme client.
  */
-void mettre_maquette_hors_service(void) {
-    CMD_TRAIN->mettre_maquette_hors_service();
+void mettre_maquette_hors_service_ctx(TrainContext *contexte) {
+    COMMANDE(contexte)->mettre_maquette_hors_service();
 }
 
 /*
  * Permet de retablir l'alimentation de la maquette, donc de reactive toute la maquette.
  * Elle n'a pas besoin d'etre appelee apres "init_maquette".
  */
-void mettre_maquette_en_service(void) {
-    CMD_TRAIN->mettre_maquette_en_service();
+void mettre_maquette_en_service_ctx(TrainContext *contexte) {
+    COMMANDE(contexte)->mettre_maquette_en_service();
 }
 
 /*
@@ -45,24 +84,49 @@ void mettre_maquette_en_service(void) {
  *   direction     : Nouvelle direction. (DEVIE ou TOUT_DROIT)
  *   temps_alim    : Temps l'alimentation minimal du bobinage de l'aiguillage.
  */
-void diriger_aiguillage(int no_aiguillage, int direction, int temps_alim) {
-    CMD_TRAIN->diriger_aiguillage(no_aiguillage,direction,temps_alim);
+void diriger_aiguillage_ctx(TrainContext *contexte, int no_aiguillage, int direction, int temps_alim) {
+    COMMANDE(contexte)->diriger_aiguillage(no_aiguillage,direction,temps_alim);
 }
 
 /*
  * Attend l'activation du contact donne.
  *   no_contact : No du contact dont on attend l'activation.
  */
-void attendre_contact(int no_contact) {
-    CMD_TRAIN->attendre_contact(no_contact);
+void attendre_contact_ctx(TrainContext *contexte, int no_contact) {
+    COMMANDE(contexte)->attendre_contact(no_contact);
+}
+
+/*
+ * Demande l'appel de rappel(no_contact, donnees) a la prochaine activation du contact.
+ *   no_contact : No du contact dont on attend l'activation.
+ *   rappel     : Fonction a appeler, depuis le thread du simulateur.
+ *   donnees    : Pointeur transmis a la fonction rappel.
+ */
+void attendre_contact_async_ctx(TrainContext *contexte, int no_contact, rappel_contact rappel, void *donnees) {
+    COMMANDE(contexte)->attendre_contact_async(no_contact, rappel, donnees);
+}
+
+/*
+ * Demande l'appel de rappel(donnees) apres delai_ms millisecondes.
+ *   delai_ms : Delai en millisecondes.
+ *   rappel   : Fonction a appeler, depuis le thread du simulateur.
+ *   donnees  : Pointeur transmis a la fonction rappel.
+ */
+void attendre_delai_async_ctx(TrainContext *contexte, int delai_ms, rappel_delai rappel, void *donnees) {
+    COMMANDE(contexte)->attendre_delai_async(delai_ms, rappel, donnees);
+}
+
+void activer_canton_mobile_ctx(TrainContext *contexte, int actif, rappel_canton rappel, void *donnees)
+{
+    COMMANDE(contexte)->activer_canton_mobile(actif, rappel, donnees);
 }
 
 /*
  * Arrete une locomotive (met sa vitesse a VITESSE_NULLE).
  *   no_loco : No de la loco a arreter.
  */
-void arreter_loco(int no_loco) {
-    CMD_TRAIN->arreter_loco(no_loco);
+void arreter_loco_ctx(TrainContext *contexte, int no_loco) {
+    COMMANDE(contexte)->arreter_loco(no_loco);
 }
 
 /*
@@ -73,8 +137,13 @@ void arreter_loco(int no_loco) {
  *            "mettre_vitesse_loco". C'est-a-dire que l'acceleration est immediate
  *            (de la vitesse actuelle a la vitesse specifiee).
  */
-void mettre_vitesse_progressive(int no_loco, int vitesse_future) {
-    CMD_TRAIN->mettre_vitesse_progressive(no_loco,vitesse_future);
+void mettre_vitesse_progressive_ctx(TrainContext *contexte, int no_loco, int vitesse_future) {
+    COMMANDE(contexte)->mettre_vitesse_progressive(no_loco,vitesse_future);
+}
+
+void mettre_vitesse_au_contact_ctx(TrainContext *contexte, int no_loco, int vitesse, int no_contact)
+{
+    COMMANDE(contexte)->mettre_vitesse_au_contact(no_loco, vitesse, no_contact);
 }
 
 /*
@@ -86,16 +155,16 @@ void mettre_vitesse_progressive(int no_loco, int vitesse_future) {
  *            indiquant le sens de deplacement. L'utilisation des phares n'est donc
  *            plus utile.
  */
-void mettre_fonction_loco(int no_loco, char etat) {
-    CMD_TRAIN->mettre_fonction_loco(no_loco,etat);
+void mettre_fonction_loco_ctx(TrainContext *contexte, int no_loco, char etat) {
+    COMMANDE(contexte)->mettre_fonction_loco(no_loco,etat);
 }
 
 /*
  * Inverse le sens d'une locomotive, en conservant sa vitesse.
  *   no_loco : No de la loco a inverser.
  */
-void inverser_sens_loco(int no_loco) {
-    CMD_TRAIN->inverser_sens_loco(no_loco);
+void inverser_sens_loco_ctx(TrainContext *contexte, int no_loco) {
+    COMMANDE(contexte)->inverser_sens_loco(no_loco);
 }
 
 /*
@@ -103,8 +172,8 @@ void inverser_sens_loco(int no_loco) {
  *   no_loco : No de la loco a controler.
  *   vitesse : Nouvelle vitesse.
  */
-void mettre_vitesse_loco(int no_loco, int vitesse) {
-    CMD_TRAIN->mettre_vitesse_loco(no_loco,vitesse);
+void mettre_vitesse_loco_ctx(TrainContext *contexte, int no_loco, int vitesse) {
+    COMMANDE(contexte)->mettre_vitesse_loco(no_loco,vitesse);
 }
 
 /*
@@ -116,8 +185,128 @@ void mettre_vitesse_loco(int no_loco, int vitesse) {
  *   numero_loco : Numero de loco choisi par l'utilisateur.
  *   vitesse     : Vitesse choisie par l'utilisateur.
  */
+void demander_loco_ctx(TrainContext *contexte, int contact_a, int contact_b, int *no_loco, int *vitesse) {
+    COMMANDE(contexte)->demander_loco(contact_a,contact_b,no_loco,vitesse);
+}
+
+/*
+ * Fonctions sans contexte : le contexte par defaut.
+ */
+void mettre_maquette_hors_service(void) {
+    mettre_maquette_hors_service_ctx(contexte_defaut());
+}
+
+void mettre_maquette_en_service(void) {
+    mettre_maquette_en_service_ctx(contexte_defaut());
+}
+
+void diriger_aiguillage(int no_aiguillage, int direction, int temps_alim) {
+    diriger_aiguillage_ctx(contexte_defaut(), no_aiguillage, direction, temps_alim);
+}
+
+void attendre_contact(int no_contact) {
+    attendre_contact_ctx(contexte_defaut(), no_contact);
+}
+
+void attendre_contact_async(int no_contact, rappel_contact rappel, void *donnees) {
+    attendre_contact_async_ctx(contexte_defaut(), no_contact, rappel, donnees);
+}
+
+void attendre_delai_async(int delai_ms, rappel_delai rappel, void *donnees) {
+    attendre_delai_async_ctx(contexte_defaut(), delai_ms, rappel, donnees);
+}
+
+void activer_canton_mobile(int actif, rappel_canton rappel, void *donnees) {
+    activer_canton_mobile_ctx(contexte_defaut(), actif, rappel, donnees);
+}
+
+void arreter_loco(int no_loco) {
+    arreter_loco_ctx(contexte_defaut(), no_loco);
+}
+
+void mettre_vitesse_progressive(int no_loco, int vitesse_future) {
+    mettre_vitesse_progressive_ctx(contexte_defaut(), no_loco, vitesse_future);
+}
+
+void mettre_vitesse_au_contact(int no_loco, int vitesse, int no_contact) {
+    mettre_vitesse_au_contact_ctx(contexte_defaut(), no_loco, vitesse, no_contact);
+}
+
+void mettre_fonction_loco(int no_loco, char etat) {
+    mettre_fonction_loco_ctx(contexte_defaut(), no_loco, etat);
+}
+
+void inverser_sens_loco(int no_loco) {
+    inverser_sens_loco_ctx(contexte_defaut(), no_loco);
+}
+
+void mettre_vitesse_loco(int no_loco, int vitesse) {
+    mettre_vitesse_loco_ctx(contexte_defaut(), no_loco, vitesse);
+}
+
 void demander_loco(int contact_a, int contact_b, int *no_loco, int *vitesse) {
-    CMD_TRAIN->demander_loco(contact_a,contact_b,no_loco,vitesse);
+    demander_loco_ctx(contexte_defaut(), contact_a, contact_b, no_loco, vitesse);
+}
+
+#else // MAQUETTE
+
+/*
+ * La maquette reelle est unique : ses fonctions ignorent le contexte.
+ */
+void mettre_maquette_hors_service_ctx(TrainContext *) {
+    mettre_maquette_hors_service();
+}
+
+void mettre_maquette_en_service_ctx(TrainContext *) {
+    mettre_maquette_en_service();
+}
+
+void diriger_aiguillage_ctx(TrainContext *, int no_aiguillage, int direction, int temps_alim) {
+    diriger_aiguillage(no_aiguillage, direction, temps_alim);
+}
+
+void attendre_contact_ctx(TrainContext *, int no_contact) {
+    attendre_contact(no_contact);
+}
+
+void attendre_contact_async_ctx(TrainContext *, int no_contact, rappel_contact rappel, void *donnees) {
+    attendre_contact_async(no_contact, rappel, donnees);
+}
+
+void attendre_delai_async_ctx(TrainContext *, int delai_ms, rappel_delai rappel, void *donnees) {
+    attendre_delai_async(delai_ms, rappel, donnees);
+}
+
+void activer_canton_mobile_ctx(TrainContext *, int actif, rappel_canton rappel, void *donnees) {
+    activer_canton_mobile(actif, rappel, donnees);
+}
+
+void arreter_loco_ctx(TrainContext *, int no_loco) {
+    arreter_loco(no_loco);
+}
+
+void mettre_vitesse_progressive_ctx(TrainContext *, int no_loco, int vitesse_future) {
+    mettre_vitesse_progressive(no_loco, vitesse_future);
+}
+
+void mettre_vitesse_au_contact_ctx(TrainContext *, int no_loco, int vitesse, int no_contact) {
+    mettre_vitesse_au_contact(no_loco, vitesse, no_contact);
+}
+
+void mettre_fonction_loco_ctx(TrainContext *, int no_loco, char etat) {
+    mettre_fonction_loco(no_loco, etat);
+}
+
+void inverser_sens_loco_ctx(TrainContext *, int no_loco) {
+    inverser_sens_loco(no_loco);
+}
+
+void mettre_vitesse_loco_ctx(TrainContext *, int no_loco, int vitesse) {
+    mettre_vitesse_loco(no_loco, vitesse);
+}
+
+void demander_loco_ctx(TrainContext *, int contact_a, int contact_b, int *no_loco, int *vitesse) {
+    demander_loco(contact_a, contact_b, no_loco, vitesse);
 }
 
 #endif // MAQUETTE
@@ -131,38 +320,165 @@ void demander_loco(int contact_a, int contact_b, int *no_loco, int *vitesse) {
  *   numero_loco : Numero de loco choisi par l'utilisateur.
  *   vitesse     : Vitesse choisie par l'utilisateur.
  */
-void assigner_loco(int contact_a, int contact_b, int no_loco, int vitesse) {
-    CMD_TRAIN->assigner_loco(contact_a,contact_b,no_loco,vitesse);
+void assigner_loco_ctx(TrainContext *contexte, int contact_a, int contact_b, int no_loco, int vitesse) {
+    COMMANDE(contexte)->assigner_loco(contact_a,contact_b,no_loco,vitesse);
+}
+
+
+void selection_maquette_ctx(TrainContext *contexte, const char *maquette)
+{
+    COMMANDE(contexte)->selection_maquette(maquette);
+}
+
+int calculer_itineraire_ctx(TrainContext *contexte,
+                            int contact_precedent, int contact_depart, int contact_arrivee,
+                            int *contacts, int max_contacts,
+                            int *aiguillages, int *directions, int max_aiguillages,
+                            int *nb_aiguillages)
+{
+    return COMMANDE(contexte)->calculer_itineraire(contact_precedent, contact_depart, contact_arrivee,
+                                                    contacts, max_contacts,
+                                                    aiguillages, directions, max_aiguillages,
+                                                    nb_aiguillages);
+}
+
+void diriger_loco_vers_ctx(TrainContext *contexte, int no_loco, int contact_arrivee)
+{
+    COMMANDE(contexte)->diriger_loco_vers(no_loco, contact_arrivee);
 }
 
+int lire_position_loco_ctx(TrainContext *contexte, int no_loco, position_loco *position)
+{
+    return COMMANDE(contexte)->lire_position_loco(no_loco, position);
+}
 
-void selection_maquette(const char *maquette)
+int lire_occupation_segments_ctx(TrainContext *contexte, unsigned char *occupation, int taille)
 {
-    CMD_TRAIN->selection_maquette(maquette);
+    return COMMANDE(contexte)->lire_occupation_segments(occupation, taille);
 }
 
-void afficher_message(const char *message)
+int lire_contacts_segment_ctx(TrainContext *contexte, int no_segment, int *contact_a, int *contact_b)
 {
-    CMD_TRAIN->afficher_message(message);
+    return COMMANDE(contexte)->lire_contacts_segment(no_segment, contact_a, contact_b);
 }
 
+int sauver_etat_ctx(TrainContext *contexte, const char *nom_fichier)
+{
+    return COMMANDE(contexte)->sauver_etat(nom_fichier);
+}
 
-void afficher_message_loco(int numLoco,const char* message)
+int charger_etat_ctx(TrainContext *contexte, const char *nom_fichier)
 {
-    CMD_TRAIN->afficher_message_loco(numLoco,message);
+    return COMMANDE(contexte)->charger_etat(nom_fichier);
 }
 
-const char *getCommand()
+void demarrer_simulation_ctx(TrainContext *contexte)
 {
-    static QByteArray cmd;
+    COMMANDE(contexte)->demarrer_simulation();
+}
 
-    cmd = CMD_TRAIN->getCommand().toLocal8Bit();
-    return cmd.data();
+void debut_mesure_ctx(TrainContext *contexte, const char *nom, int no_loco)
+{
+    COMMANDE(contexte)->debut_mesure(nom, no_loco);
 }
 
-void getCommandInArray(char *commande, int taille)
+void fin_mesure_ctx(TrainContext *contexte, const char *nom, int no_loco)
 {
-    QByteArray cmd(CMD_TRAIN->getCommand().toLocal8Bit());
+    COMMANDE(contexte)->fin_mesure(nom, no_loco);
+}
+
+void afficher_message_ctx(TrainContext *contexte, const char *message)
+{
+    COMMANDE(contexte)->afficher_message(message);
+}
+
+
+void afficher_message_loco_ctx(TrainContext *contexte, int numLoco, const char* message)
+{
+    COMMANDE(contexte)->afficher_message_loco(numLoco,message);
+}
+
+const char *getCommand_ctx(TrainContext *contexte)
+{
+    contexte->derniereCommande = COMMANDE(contexte)->getCommand().toLocal8Bit();
+    return contexte->derniereCommande.data();
+}
+
+void getCommandInArray_ctx(TrainContext *contexte, char *commande, int taille)
+{
+    QByteArray cmd(COMMANDE(contexte)->getCommand().toLocal8Bit());
     strncpy(commande, cmd.data(), taille - 1);
     commande[taille - 1] = '\0';
 }
+
+/*
+ * Fonctions sans contexte : le contexte par defaut.
+ */
+void assigner_loco(int contact_a, int contact_b, int no_loco, int vitesse) {
+    assigner_loco_ctx(contexte_defaut(), contact_a, contact_b, no_loco, vitesse);
+}
+
+void selection_maquette(const char *maquette) {
+    selection_maquette_ctx(contexte_defaut(), maquette);
+}
+
+int calculer_itineraire(int contact_precedent, int contact_depart, int contact_arrivee,
+                        int *contacts, int max_contacts,
+                        int *aiguillages, int *directions, int max_aiguillages,
+                        int *nb_aiguillages) {
+    return calculer_itineraire_ctx(contexte_defaut(), contact_precedent, contact_depart, contact_arrivee,
+                                   contacts, max_contacts, aiguillages, directions, max_aiguillages,
+                                   nb_aiguillages);
+}
+
+void diriger_loco_vers(int no_loco, int contact_arrivee) {
+    diriger_loco_vers_ctx(contexte_defaut(), no_loco, contact_arrivee);
+}
+
+int lire_position_loco(int no_loco, position_loco *position) {
+    return lire_position_loco_ctx(contexte_defaut(), no_loco, position);
+}
+
+int lire_occupation_segments(unsigned char *occupation, int taille) {
+    return lire_occupation_segments_ctx(contexte_defaut(), occupation, taille);
+}
+
+int lire_contacts_segment(int no_segment, int *contact_a, int *contact_b) {
+    return lire_contacts_segment_ctx(contexte_defaut(), no_segment, contact_a, contact_b);
+}
+
+int sauver_etat(const char *nom_fichier) {
+    return sauver_etat_ctx(contexte_defaut(), nom_fichier);
+}
+
+int charger_etat(const char *nom_fichier) {
+    return charger_etat_ctx(contexte_defaut(), nom_fichier);
+}
+
+void demarrer_simulation(void) {
+    demarrer_simulation_ctx(contexte_defaut());
+}
+
+void debut_mesure(const char *nom, int no_loco) {
+    debut_mesure_ctx(contexte_defaut(), nom, no_loco);
+}
+
+void fin_mesure(const char *nom, int no_loco) {
+    fin_mesure_ctx(contexte_defaut(), nom, no_loco);
+}
+
+void afficher_message(const char *message) {
+    afficher_message_ctx(contexte_defaut(), message);
+}
+
+void afficher_message_loco(int numLoco, const char* message) {
+    afficher_message_loco_ctx(contexte_defaut(), numLoco, message);
+}
+
+const char *getCommand() {
+    return getCommand_ctx(contexte_defaut());
+}
+
+void getCommandInArray(char *commande, int taille) {
+    getCommandInArray_ctx(contexte_defaut(), commande, taille);
+}
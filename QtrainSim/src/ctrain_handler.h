@@ -50,6 +50,38 @@ extern "C" {
 #define ETEINT 0
 #define ALLUME 1
 
+/*
+ * Contexte d'une simulation. Chaque contexte a son propre simulateur, ses locos et
+ * ses reglages : plusieurs simulations peuvent tourner dans le meme processus.
+ * Les fonctions de ce fichier s'appliquent au contexte par defaut, celui de
+ * l'application ; chacune a une variante suffixee par _ctx qui prend le contexte
+ * en premier parametre (voir la fin du fichier).
+ * Les simulateurs de tous les contextes avancent dans le thread de l'interface :
+ * leurs pas s'executent les uns apres les autres, jamais en parallele. Seuls les
+ * programmes de controle, un thread par contexte, tournent en parallele.
+ */
+typedef struct TrainContext TrainContext;
+
+/*
+ * Retourne le contexte par defaut.
+ */
+TrainContext *contexte_defaut(void);
+
+/*
+ * Cree un contexte avec son propre simulateur, sans fenetre, deja initialise
+ * comme par init_maquette().
+ *   return : Le nouveau contexte, a liberer par detruire_contexte().
+ * Remarque : A appeler une fois l'application lancee, par exemple depuis cmain().
+ */
+TrainContext *creer_contexte(void);
+
+/*
+ * Detruit un contexte cree par creer_contexte(). Les threads qui l'utilisent
+ * doivent etre termines.
+ *   contexte : Contexte a detruire. Le contexte par defaut n'est pas detruit.
+ */
+void detruire_contexte(TrainContext *contexte);
+
 /*
  * Initialise la communication avec la maquette/simulateur.
  * A appeler au debut du programme client.
@@ -80,6 +112,66 @@ void diriger_aiguillage(int no_aiguillage, int direction, int temps_alim);
  */
 void attendre_contact(int no_contact);
 
+/*
+ * Fonction appelee lors de l'activation d'un contact attendu avec attendre_contact_async().
+ *   no_contact : No du contact active.
+ *   donnees    : Pointeur passe a attendre_contact_async().
+ */
+typedef void (*rappel_contact)(int no_contact, void *donnees);
+
+/*
+ * Version non bloquante de attendre_contact : la fonction rappel est appelee une
+ * seule fois, lors de la prochaine activation du contact.
+ *   no_contact : No du contact dont on attend l'activation.
+ *   rappel     : Fonction a appeler.
+ *   donnees    : Pointeur transmis tel quel a la fonction rappel.
+ * Remarque : le rappel est execute par le thread du simulateur et ne doit pas bloquer.
+ */
+void attendre_contact_async(int no_contact, rappel_contact rappel, void *donnees);
+
+/*
+ * Fonction appelee a l'expiration d'un delai demande avec attendre_delai_async().
+ *   donnees : Pointeur passe a attendre_delai_async().
+ */
+typedef void (*rappel_delai)(void *donnees);
+
+/*
+ * Appelle la fonction rappel apres delai_ms millisecondes de temps simule, sans
+ * bloquer l'appelant. Le delai ne s'ecoule pas quand la simulation est en pause.
+ *   delai_ms : Delai en millisecondes.
+ *   rappel   : Fonction a appeler.
+ *   donnees  : Pointeur transmis tel quel a la fonction rappel.
+ * Remarque : le rappel est execute par le thread du simulateur et ne doit pas bloquer.
+ *            Pendant le rejeu d'une trace, le rappel est appele immediatement.
+ */
+void attendre_delai_async(int delai_ms, rappel_delai rappel, void *donnees);
+
+/*
+ * Fonction appelee quand le canton mobile commence ou cesse de limiter la vitesse
+ * d'une loco.
+ *   no_loco         : No de la loco limitee.
+ *   no_loco_genante : No de la loco dont la reservation gene no_loco, 0 quand
+ *                     la limitation est levee.
+ *   donnees         : Pointeur passe a activer_canton_mobile().
+ */
+typedef void (*rappel_canton)(int no_loco, int no_loco_genante, void *donnees);
+
+/*
+ * Active ou desactive l'espacement des locos par canton mobile. Chaque loco
+ * reserve les voies devant elle sur sa distance de freinage, calculee avec
+ * l'inertie du simulateur. Lorsque deux reservations se rencontrent, la loco la
+ * plus eloignee du point de rencontre est ralentie par le simulateur, juste assez
+ * pour pouvoir s'arreter avant, puis reprend sa vitesse quand la voie se libere.
+ * Les locos peuvent ainsi se suivre de plus pres qu'avec des sections fixes.
+ *   actif   : 1 pour activer, 0 pour desactiver.
+ *   rappel  : Fonction appelee a chaque debut et fin de limitation, ou NULL.
+ *   donnees : Pointeur transmis tel quel a la fonction rappel.
+ * Remarque : la vitesse commandee des locos n'est pas modifiee. Le rappel est
+ *            execute par le thread du simulateur et ne doit pas bloquer.
+ *            Sans effet pendant le rejeu d'une trace.
+ */
+void activer_canton_mobile(int actif, rappel_canton rappel, void *donnees);
+
 /*
  * Arrete une locomotive (met sa vitesse a VITESSE_NULLE).
  *   no_loco : No de la loco a arreter.
@@ -96,6 +188,20 @@ void arreter_loco(int no_loco);
  */
 void mettre_vitesse_progressive(int no_loco, int vitesse_future);
 
+/*
+ * Fait ralentir une loco pour qu'elle franchisse un contact a la vitesse donnee.
+ * La loco garde sa vitesse, puis freine juste assez tot pour atteindre la
+ * vitesse voulue au contact, au lieu de ralentir des l'appel.
+ *   no_loco    : Numero de la loco.
+ *   vitesse    : Vitesse au passage du contact. Avec une vitesse nulle, la loco
+ *                s'arrete juste avant le contact, sans l'activer.
+ *   no_contact : Contact devant la loco, selon la position actuelle des aiguillages.
+ * Remarque : Si la vitesse n'est pas inferieure a la vitesse actuelle, ou si le
+ *            contact n'est pas devant la loco, cette procedure agit comme
+ *            mettre_vitesse_progressive().
+ */
+void mettre_vitesse_au_contact(int no_loco, int vitesse, int no_contact);
+
 /*
  * Permettre d'allumer ou d'eteindre les phares de la locomotive.
  *   no_loco : No de la loco a controler.
@@ -153,6 +259,124 @@ void assigner_loco(int contact_a, int contact_b, int no_loco, int vitesse);
  */
 void selection_maquette(const char *maquette);
 
+/*
+ * Calcule l'itineraire le plus court entre deux contacts de la maquette
+ * selectionnee, quelle que soit la position actuelle des aiguillages.
+ *   contact_precedent : Contact a l'arriere de la loco au depart, qui donne le sens
+ *                       de depart (0 pour un sens quelconque).
+ *   contact_depart    : Contact de depart.
+ *   contact_arrivee   : Contact d'arrivee.
+ *   contacts          : Tableau recevant les contacts parcourus, depart et arrivee compris.
+ *   max_contacts      : Taille du tableau contacts.
+ *   aiguillages       : Tableau recevant les numeros des aiguillages a diriger.
+ *   directions        : Tableau recevant la direction de chacun de ces aiguillages
+ *                       (DEVIE ou TOUT_DROIT).
+ *   max_aiguillages   : Taille des tableaux aiguillages et directions.
+ *   nb_aiguillages    : Recoit le nombre d'aiguillages a diriger.
+ *   return : le nombre de contacts de l'itineraire, 0 s'il n'y en a pas ou si
+ *            les tableaux sont trop petits.
+ * Remarque : A appeler apres selection_maquette().
+ */
+int calculer_itineraire(int contact_precedent, int contact_depart, int contact_arrivee,
+                        int *contacts, int max_contacts,
+                        int *aiguillages, int *directions, int max_aiguillages,
+                        int *nb_aiguillages);
+
+/*
+ * Confie au simulateur le choix du chemin d'une loco : a chaque contact franchi,
+ * le simulateur choisit le plus court chemin vers la destination qui evite les
+ * segments occupes par d'autres locos, et dirige les aiguillages jusqu'au
+ * contact suivant. Le chemin est mis a jour au fil des deplacements des locos.
+ *   no_loco         : Numero de la loco.
+ *   contact_arrivee : Contact a atteindre, 0 pour rendre la main au programme.
+ * Remarque : La loco n'est ni arretee ni ralentie, il faut toujours attendre
+ *            ses contacts pour gerer sa vitesse. Si aucun chemin libre n'existe,
+ *            les aiguillages ne sont pas modifies.
+ */
+void diriger_loco_vers(int no_loco, int contact_arrivee);
+
+/*
+ * Position d'une loco, lue par lire_position_loco().
+ */
+typedef struct
+{
+    int voie;              /* No de la voie sous la loco */
+    int segment;           /* Indice du segment, -1 s'il n'est pas connu */
+    int contact_arriere;   /* Contact du segment derriere la loco, 0 s'il n'est pas connu */
+    int contact_avant;     /* Prochain contact devant la loco, 0 s'il n'y en a pas */
+    int vitesse;           /* Vitesse actuelle, inertie comprise */
+    int distance_contact;  /* Distance jusqu'au prochain contact, en unites de la maquette */
+} position_loco;
+
+/*
+ * Lit la position d'une loco, sans bloquer ni attendre le simulateur : l'etat est
+ * publie par le simulateur a chaque pas et peut etre lu aussi souvent que voulu.
+ *   no_loco  : No de la loco.
+ *   position : Position a remplir.
+ *   return   : 1 si la loco est sur la maquette, 0 sinon.
+ * Remarque : Le prochain contact depend de la position actuelle des aiguillages.
+ *            Pendant le rejeu d'une trace, aucune loco n'est sur la maquette.
+ */
+int lire_position_loco(int no_loco, position_loco *position);
+
+/*
+ * Lit l'occupation de tous les segments, publiee en meme temps que la position
+ * des locos. Le bit i % 8 de l'octet i / 8 vaut 1 si une loco est sur le segment i.
+ *   occupation : Tableau a remplir.
+ *   taille     : Taille du tableau, en octets. Les segments au-dela sont ignores.
+ *   return     : Le nombre de segments de la maquette.
+ */
+int lire_occupation_segments(unsigned char *occupation, int taille);
+
+/*
+ * Lit les contacts aux extremites d'un segment.
+ *   no_segment : Indice du segment.
+ *   contact_a  : Premier contact du segment.
+ *   contact_b  : Second contact du segment, 0 s'il finit sur une voie buttoir.
+ *   return     : 1 si le segment existe, 0 sinon.
+ */
+int lire_contacts_segment(int no_segment, int *contact_a, int *contact_b);
+
+/*
+ * Enregistre l'etat complet de la simulation dans un fichier binaire compact :
+ * position exacte, vitesses et inertie des locos, aiguillages, destinations de
+ * diriger_loco_vers() et attentes en cours sur les contacts.
+ *   nom_fichier : Fichier a creer.
+ *   return      : 1 si l'etat a ete enregistre, 0 sinon.
+ */
+int sauver_etat(const char *nom_fichier);
+
+/*
+ * Restaure un etat enregistre par sauver_etat(), sans recharger la maquette.
+ *   nom_fichier : Fichier a lire.
+ *   return      : 1 si l'etat a ete restaure, 0 sinon.
+ * Remarque : A appeler apres selection_maquette() et assigner_loco() pour toutes
+ *            les locos de l'etat. Les attentes sur les contacts ne sont pas
+ *            restaurees : le programme doit reprendre les siennes, un avertissement
+ *            signale celles qui different de l'etat enregistre.
+ *            Sans effet pendant le rejeu d'une trace.
+ */
+int charger_etat(const char *nom_fichier);
+
+/*
+ * Demarre une simulation sans interface, lancee par qtrainsim_batch ou creee par
+ * creer_contexte(). A appeler une fois les locos assignees et les threads de
+ * controle lances.
+ * Remarque : Sans effet avec l'interface, ou la simulation est demarree par
+ *            l'utilisateur.
+ */
+void demarrer_simulation(void);
+
+/*
+ * Commence et termine une duree mesuree en temps simule pour qtrainsim_batch, par
+ * exemple l'attente d'une section partagee. Les durees de meme nom sont cumulees.
+ *   nom     : Nom de la mesure.
+ *   no_loco : Numero de la loco mesuree.
+ * Remarque : Sans effet hors de l'execution en batch.
+ */
+void debut_mesure(const char *nom, int no_loco);
+void fin_mesure(const char *nom, int no_loco);
+
 /*
  * Affiche un message dans la console principale
  *   message : chaine de caractere qui sera affichee dans la console.
@@ -181,6 +405,46 @@ const char* getCommand();
  */
 void getCommandInArray(char *commande, int taille);
 
+/*
+ * Variantes avec contexte des fonctions ci-dessus, pour un contexte cree par
+ * creer_contexte() : memes parametres, precedes du contexte. Le contexte se
+ * substitue a init_maquette(), qui n'a pas de variante.
+ */
+void mettre_maquette_hors_service_ctx(TrainContext *contexte);
+void mettre_maquette_en_service_ctx(TrainContext *contexte);
+void diriger_aiguillage_ctx(TrainContext *contexte, int no_aiguillage, int direction, int temps_alim);
+void attendre_contact_ctx(TrainContext *contexte, int no_contact);
+void attendre_contact_async_ctx(TrainContext *contexte, int no_contact, rappel_contact rappel, void *donnees);
+void attendre_delai_async_ctx(TrainContext *contexte, int delai_ms, rappel_delai rappel, void *donnees);
+void activer_canton_mobile_ctx(TrainContext *contexte, int actif, rappel_canton rappel, void *donnees);
+void arreter_loco_ctx(TrainContext *contexte, int no_loco);
+void mettre_vitesse_progressive_ctx(TrainContext *contexte, int no_loco, int vitesse_future);
+void mettre_vitesse_au_contact_ctx(TrainContext *contexte, int no_loco, int vitesse, int no_contact);
+void mettre_fonction_loco_ctx(TrainContext *contexte, int no_loco, char etat);
+void inverser_sens_loco_ctx(TrainContext *contexte, int no_loco);
+void mettre_vitesse_loco_ctx(TrainContext *contexte, int no_loco, int vitesse);
+void demander_loco_ctx(TrainContext *contexte, int contact_a, int contact_b, int *no_loco, int *vitesse);
+void assigner_loco_ctx(TrainContext *contexte, int contact_a, int contact_b, int no_loco, int vitesse);
+void selection_maquette_ctx(TrainContext *contexte, const char *maquette);
+int calculer_itineraire_ctx(TrainContext *contexte,
+                            int contact_precedent, int contact_depart, int contact_arrivee,
+                            int *contacts, int max_contacts,
+                            int *aiguillages, int *directions, int max_aiguillages,
+                            int *nb_aiguillages);
+void diriger_loco_vers_ctx(TrainContext *contexte, int no_loco, int contact_arrivee);
+int lire_position_loco_ctx(TrainContext *contexte, int no_loco, position_loco *position);
+int lire_occupation_segments_ctx(TrainContext *contexte, unsigned char *occupation, int taille);
+int lire_contacts_segment_ctx(TrainContext *contexte, int no_segment, int *contact_a, int *contact_b);
+int sauver_etat_ctx(TrainContext *contexte, const char *nom_fichier);
+int charger_etat_ctx(TrainContext *contexte, const char *nom_fichier);
+void demarrer_simulation_ctx(TrainContext *contexte);
+void debut_mesure_ctx(TrainContext *contexte, const char *nom, int no_loco);
+void fin_mesure_ctx(TrainContext *contexte, const char *nom, int no_loco);
+void afficher_message_ctx(TrainContext *contexte, const char *message);
+void afficher_message_loco_ctx(TrainContext *contexte, int numLoco, const char *message);
+const char *getCommand_ctx(TrainContext *contexte);
+void getCommandInArray_ctx(TrainContext *contexte, char *commande, int taille);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,63 @@
+#include <cstring>
+
+#include "etatsimulation.h"
+
+static_assert(sizeof(InstantaneSimulation) % sizeof(quint64) == 0,
+              "l'état doit se copier par mots de 64 bits");
+static_assert(std::atomic<quint64>::is_always_lock_free,
+              "les mots de l'état doivent être atomiques sans verrou");
+
+EtatSimulation::EtatSimulation()
+{
+    std::memset(&brouillon, 0, sizeof(brouillon));
+    for (auto& tampon : tampons)
+        for (std::atomic<quint64>& mot : tampon)
+            mot.store(0, std::memory_order_relaxed);
+    sequences[0] = 0;
+    sequences[1] = 0;
+}
+
+InstantaneSimulation &EtatSimulation::ecrire()
+{
+    return brouillon;
+}
+
+void EtatSimulation::publier()
+{
+    int i = 1 - publie.load(std::memory_order_relaxed);
+    sequences[i].fetch_add(1, std::memory_order_relaxed);
+
+    // Les mots sont écrits en release : un lecteur qui voit l'un d'eux voit
+    // aussi la séquence impaire, et rejette sa copie.
+    const char* source = reinterpret_cast<const char*>(&brouillon);
+    for (int m = 0; m < MOTS_ETAT; m++)
+    {
+        quint64 mot;
+        std::memcpy(&mot, source + m * sizeof(quint64), sizeof(quint64));
+        tampons[i][m].store(mot, std::memory_order_release);
+    }
+
+    sequences[i].fetch_add(1, std::memory_order_release);
+    publie.store(i, std::memory_order_release);
+}
+
+void EtatSimulation::lire(InstantaneSimulation &copie) const
+{
+    char* destination = reinterpret_cast<char*>(&copie);
+    while (true)
+    {
+        int i = publie.load(std::memory_order_acquire);
+        quint32 debut = sequences[i].load(std::memory_order_acquire);
+        if (debut & 1)
+            continue;
+
+        for (int m = 0; m < MOTS_ETAT; m++)
+        {
+            quint64 mot = tampons[i][m].load(std::memory_order_acquire);
+            std::memcpy(destination + m * sizeof(quint64), &mot, sizeof(quint64));
+        }
+
+        if (sequences[i].load(std::memory_order_relaxed) == debut)
+            return;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef ETATSIMULATION_H
+#define ETATSIMULATION_H
+
+#include <QtGlobal>
+#include <atomic>
+
+#include "general.h"
+
+//! Nombre max. de segments décrits par l'état de la simulation.
+#define MAX_SEGMENTS 256
+
+//! Position d'une loco à la fin d'un pas de simulation.
+struct PositionLoco
+{
+    bool presente;          //!< faux si aucune loco ne porte ce numéro
+    qint32 voie;            //!< numéro de la voie sous la loco
+    qint32 segment;         //!< indice du segment, -1 s'il n'est pas connu
+    qint32 contactArriere;  //!< contact du segment derrière la loco, 0 s'il n'est pas connu
+    qint32 contactAvant;    //!< prochain contact devant la loco, 0 s'il n'y en a pas
+    qint32 vitesse;
+    qreal distanceContact;  //!< distance jusqu'au prochain contact
+};
+
+//! Etat de la simulation publié à la fin d'un pas.
+struct InstantaneSimulation
+{
+    qint64 temps;                                   //!< temps simulé, en millisecondes
+    PositionLoco locos[MAX_LOCOS + 1];              //!< indicé par numéro de loco
+    qint32 nbreSegments;
+    qint32 contactsSegments[MAX_SEGMENTS][2];       //!< le second vaut 0 si le segment finit sur une voie buttoir
+    quint64 occupation[MAX_SEGMENTS / 64];          //!< un bit par segment, à 1 s'il porte une loco
+};
+
+/** Etat de la simulation à double tampon, publié par le simulateur une fois par pas
+  * et lu sans verrou par les threads de contrôle. Le simulateur remplit un brouillon
+  * qui lui est propre, puis le copie dans le tampon qui n'est pas publié et le publie ;
+  * chaque tampon porte un numéro de séquence, impair pendant l'écriture, qui permet au
+  * lecteur de détecter une copie faite pendant une écriture et de la recommencer. Les
+  * tampons partagés sont faits de mots atomiques : une copie concurrente à une
+  * écriture est rejetée, mais n'est jamais une course de données.
+  * Le simulateur n'attend jamais les lecteurs, et un lecteur ne recommence que s'il a
+  * été plus lent qu'un pas entier.
+  */
+class EtatSimulation
+{
+public:
+    EtatSimulation();
+
+    /** Commence l'écriture du prochain état, depuis le thread du simulateur.
+      * \return le brouillon à remplir, qui contient le dernier état publié.
+      */
+    InstantaneSimulation& ecrire();
+
+    /** Publie le brouillon rempli depuis l'appel à ecrire().
+      */
+    void publier();
+
+    /** Copie le dernier état publié. Peut être appelé depuis n'importe quel thread.
+      * \param copie l'état à remplir.
+      */
+    void lire(InstantaneSimulation& copie) const;
+
+private:
+    static constexpr int MOTS_ETAT = sizeof(InstantaneSimulation) / sizeof(quint64);
+
+    InstantaneSimulation brouillon;
+    std::atomic<quint64> tampons[2][MOTS_ETAT];
+    std::atomic<quint32> sequences[2];
+    std::atomic<int> publie{0};
+};
+
+#endif // ETATSIMULATION_H
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <QFile>
+#include <QMutexLocker>
+
+#include "exportimages.h"
+
+//! Nombre d'images en attente d'écriture au-delà duquel les nouvelles sont abandonnées.
+#define MAX_IMAGES_EN_ATTENTE 16
+
+ExportImages::~ExportImages()
+{
+    arreter();
+}
+
+bool ExportImages::demarrer(const QString &nomDossier, Format format)
+{
+    dossier.setPath(nomDossier);
+    if (!dossier.mkpath("."))
+        return false;
+
+    this->format = format;
+    actif = true;
+    start(QThread::LowPriority);
+    return true;
+}
+
+void ExportImages::arreter()
+{
+    {
+        QMutexLocker verrou(&mutex);
+        if (!actif)
+            return;
+        actif = false;
+        changement.wakeAll();
+    }
+    wait();
+
+    std::cout << ecrites << " images écrites dans " << qPrintable(dossier.path());
+    if (perdues > 0)
+        std::cout << ", " << perdues << " abandonnées";
+    std::cout << std::endl;
+}
+
+void ExportImages::soumettre(const QImage &image, qint64 temps)
+{
+    QMutexLocker verrou(&mutex);
+
+    if (!actif)
+        return;
+    if (file.size() >= MAX_IMAGES_EN_ATTENTE)
+    {
+        perdues++;
+        return;
+    }
+    file.enqueue(ImageDatee{image, temps});
+    changement.wakeAll();
+}
+
+void ExportImages::run()
+{
+    QMutexLocker verrou(&mutex);
+
+    // A l'arrêt, la file est vidée avant de terminer.
+    while (actif || !file.isEmpty())
+    {
+        if (file.isEmpty())
+        {
+            changement.wait(&mutex);
+            continue;
+        }
+
+        ImageDatee image = file.dequeue();
+        verrou.unlock();
+        bool ok = ecrire(image);
+        verrou.relock();
+
+        if (ok)
+            ecrites++;
+        else
+            perdues++;
+    }
+}
+
+bool ExportImages::ecrire(const ImageDatee &image)
+{
+    QString nom = QString("image_%1").arg(image.temps, 9, 10, QChar('0'));
+
+    if (format == PNG)
+        return image.image.save(dossier.filePath(nom + ".png"), "PNG");
+
+    QImage rgba = image.image.convertToFormat(QImage::Format_RGBA8888);
+    QFile fichier(dossier.filePath(QString("%1_%2x%3.rgba").arg(nom).arg(rgba.width()).arg(rgba.height())));
+    if (!fichier.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    for (int y = 0; y < rgba.height(); y++)
+    {
+        if (fichier.write(reinterpret_cast<const char*>(rgba.constScanLine(y)), rgba.width() * 4) != rgba.width() * 4)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef EXPORTIMAGES_H
+#define EXPORTIMAGES_H
+
+#include <QString>
+#include <QImage>
+#include <QDir>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+
+/** Enregistre des images de la simulation sur le disque, depuis son propre thread.
+  * Les images sont dessinées par le simulateur puis déposées dans une file bornée :
+  * la compression et l'écriture ne ralentissent jamais le pas de simulation. Si la
+  * file est pleine, l'image est abandonnée.
+  */
+class ExportImages : public QThread
+{
+public:
+    //! Format des fichiers produits.
+    enum Format {
+        PNG,    //!< une image PNG par fichier
+        BRUT    //!< pixels RGBA 8 bits non compressés, une image par fichier
+    };
+
+    ~ExportImages();
+
+    /** Prépare le dossier de destination et démarre le thread d'écriture.
+      * \param nomDossier le dossier où écrire les images (créé si besoin).
+      * \param format le format des fichiers.
+      * \return vrai si le dossier est utilisable.
+      */
+    bool demarrer(const QString& nomDossier, Format format);
+
+    /** Ecrit les images encore en attente, puis arrête le thread.
+      */
+    void arreter();
+
+    /** Dépose une image dans la file d'écriture, sans attendre.
+      * \param image l'image à écrire.
+      * \param temps le temps simulé de l'image, en millisecondes, qui sert à nommer le fichier.
+      */
+    void soumettre(const QImage& image, qint64 temps);
+
+protected:
+    void run() override;
+
+private:
+    struct ImageDatee
+    {
+        QImage image;
+        qint64 temps;
+    };
+
+    /** Ecrit une image dans le dossier de destination.
+      */
+    bool ecrire(const ImageDatee& image);
+
+    QDir dossier;
+    Format format{PNG};
+    QQueue<ImageDatee> file;
+    int ecrites{0};
+    int perdues{0};
+    bool actif{false};
+    QMutex mutex;
+    QWaitCondition changement;
+};
+
+#endif // EXPORTIMAGES_H
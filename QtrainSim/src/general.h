@@ -19,10 +19,14 @@
 #define LONGUEUR_FEUX 30.0
 #define DIRECTION_LOCO_GAUCHE 1
 #define DIRECTION_LOCO_DROITE -1
-//! Inertie des locos. indiqué en millièmes de secondes entre chaque changement
-//! de la valeur de vitesse de 1.
+//! Inertie des locos. indiqué en millièmes de secondes de temps simulé entre
+//! chaque changement de la valeur de vitesse de 1.
 #define INERTIE_LOCO 100
 
+//! Décélération des locos suivant un profil de vitesse, en unités de vitesse par
+//! seconde : la même que celle de l'inertie.
+#define DECELERATION_LOCO (1000.0 / INERTIE_LOCO)
+
 //! NE PAS CHANGER!!! nécessaire au calcul des poses de voies.
 #define DIRECTION_VOIE_GAUCHE 1.0
 #define DIRECTION_VOIE_DROITE -1.0
@@ -35,6 +39,10 @@
 #define FONTE_CONTACT QFont("Verdana", 30, 99)
 #define COULEUR_FONTE_CONTACT QColor(255,127,0)
 
+//! niveau de détail (échelle de la vue) en dessous duquel les locos sont
+//! dessinées sans phares ni numéro, et les contacts sans étiquette.
+#define LOD_DETAILS 0.15
+
 //! indications de l'ordre d'affichage des éléments.
 //! (les objets ayant de grandes valeurs de zval sont affichés dessus)
 #define ZVAL_VOIE 1.0
@@ -42,11 +50,31 @@
 #define ZVAL_EXPLOSION 4
 #define ZVAL_LOCO 3.0
 
-//! indication du nombre d'images à calculer par seconde.
-//! en cas de fort ralentissement, baisser cette valeur.
+//! nombre maximal d'images affichées par seconde.
+//! en cas de fort ralentissement, baisser cette valeur : seul l'affichage
+//! est touché, la simulation garde son propre pas.
 //! Valeurs conseillées : 30-60.
 #define FRAME_RATE 60
 
+//! nombre de pas de simulation par seconde de temps simulé. Fixe la
+//! précision des déplacements, indépendamment de l'affichage.
+#define FREQUENCE_SIMULATION 60
+
+//! durée d'un pas de simulation, en microsecondes de temps simulé. L'horloge,
+//! le rattrapage du temps réel et les déplacements utilisent tous cette durée.
+#define DUREE_PAS_US (1000000 / FREQUENCE_SIMULATION)
+
+//! largeur maximale, en pixels, des images exportées de la simulation.
+#define LARGEUR_IMAGE_EXPORT 1600
+
+//! nombre maximal de pas de simulation rattrapés entre deux images. Au-delà,
+//! la simulation ralentit plutôt que de bloquer l'interface.
+#define MAX_PAS_PAR_IMAGE 10
+
+//! nombre de locos à partir duquel les déplacements, les collisions et les
+//! alertes de proximité sont calculés en parallèle à chaque pas d'animation.
+#define SEUIL_LOCOS_PARALLELE 8
+
 //! permet d'ajuster la vitesse des locos. Ne pas changer.
 #define FACTEUR_VITESSE 0.05
 
@@ -1,4 +1,7 @@
 #include "loco.h"
+#include <QSet>
+#include <QtMath>
+
 #include "trainsimsettings.h"
 
 panneauNumLoco::panneauNumLoco(int numLoco, QObject *parent) :
@@ -12,8 +15,11 @@ QRectF panneauNumLoco::boundingRect() const
     return QRectF(- LARGEUR_LOCO * 0.4, - LARGEUR_LOCO * 0.4, LARGEUR_LOCO * 0.8, LARGEUR_LOCO * 0.8);
 }
 
-void panneauNumLoco::paint(QPainter *painter, const QStyleOptionGraphicsItem */*option*/, QWidget */*widget*/)
+void panneauNumLoco::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget */*widget*/)
 {
+    if (option->levelOfDetailFromTransform(painter->worldTransform()) < LOD_DETAILS)
+        return;
+
     painter->setPen(Qt::lightGray);
     painter->setBrush(Qt::lightGray);
 
@@ -34,8 +40,8 @@ int panneauNumLoco::getNumLoco()
     return numLoco;
 }
 
-Loco::Loco(int numLoco, QObject *parent) :
-    QObject(parent)
+Loco::Loco(int numLoco, TrainSimSettings *reglages, QObject *parent) :
+    QObject(parent), reglages(reglages)
 {
     this->numLoco1 = new panneauNumLoco(numLoco);
     this->numLoco1->setParentItem(this);
@@ -54,20 +60,18 @@ Loco::Loco(int numLoco, QObject *parent) :
     this->alerteProximite = false;
     this->inverser = false;
     this->deraille = false;
-    this->timer = new QTimer(this);
     this->mutex = new QMutex();
     this->VarCond = new QWaitCondition();
     setZValue(ZVAL_LOCO);
-
-    CONNECT(timer, SIGNAL(timeout()), this, SLOT(adapterVitesse()));
 }
 
 void Loco::setVitesse(int v)
 {
-    if(TrainSimSettings::getInstance()->getInertie())
+    contactProfil = nullptr;
+    if(reglages->getInertie())
     {
         this->vitesseFuture = v;
-        this->timer->start(INERTIE_LOCO);
+        demarrerInertie();
     }
     else
     {
@@ -80,6 +84,92 @@ int Loco::getVitesse()
     return this->vitesse;
 }
 
+void Loco::setProfilVitesse(int v, Contact *ctc)
+{
+    qreal distance = ctc != nullptr ? distanceJusquA(ctc) : -1.0;
+    if (distance < 0.0 || v >= vitesse || inverser)
+    {
+        setVitesse(v);
+        return;
+    }
+
+    inertieActive = false;
+    contactProfil = ctc;
+    vitesseCible = vitesseFuture = v;
+    vitesseProfil = vitesse;
+    distanceProfil = distance;
+}
+
+void Loco::appliquerProfilVitesse()
+{
+    if (contactProfil == nullptr)
+        return;
+
+    vitesseProfil = qMin(vitesseProfil, vitesseAvantFreinage(distanceProfil, vitesseCible));
+
+    if (vitesseCible == 0 && vitesseProfil < 1.0)
+    {
+        contactProfil = nullptr;
+        vitesse = vitesseFuture = 0;
+        return;
+    }
+    vitesse = qCeil(vitesseProfil);
+}
+
+qreal Loco::getVitesseReelle()
+{
+    qreal v = contactProfil != nullptr ? vitesseProfil : vitesse;
+    return limiteVitesse >= 0.0 ? qMin(v, limiteVitesse) : v;
+}
+
+void Loco::setLimiteVitesse(qreal limite)
+{
+    limiteVitesse = limite;
+}
+
+qreal Loco::getResteSurVoie()
+{
+    return voieActuelle != nullptr ? qMax(voieActuelle->getLongueurAParcourir() - parcouruSurVoie, 0.0) : 0.0;
+}
+
+// La loco parcourt 1000 * FACTEUR_VITESSE par seconde et par unité de vitesse :
+// en freinant de v à vf, elle parcourt 1000 * FACTEUR_VITESSE * (v² - vf²) / 2a.
+qreal Loco::distanceFreinage(qreal vitesse, qreal vitesseFinale)
+{
+    if (vitesse <= vitesseFinale)
+        return 0.0;
+    return 1000.0 * FACTEUR_VITESSE * (vitesse * vitesse - vitesseFinale * vitesseFinale) / (2.0 * DECELERATION_LOCO);
+}
+
+qreal Loco::vitesseAvantFreinage(qreal distance, qreal vitesseFinale)
+{
+    return sqrt(vitesseFinale * vitesseFinale + 2.0 * DECELERATION_LOCO * qMax(distance, 0.0) / (1000.0 * FACTEUR_VITESSE));
+}
+
+qreal Loco::distanceJusquA(Contact *ctc)
+{
+    if (voieActuelle == nullptr || voieSuivante == nullptr)
+        return -1.0;
+
+    qreal distance = getResteSurVoie();
+    Voie* viensDe = voieActuelle;
+    Voie* v = voieSuivante;
+    QSet<QPair<Voie*, Voie*> > parcourues;
+
+    // Le contact est activé dès que la loco entre sur sa voie
+    while (v != nullptr && !parcourues.contains(qMakePair(viensDe, v)))
+    {
+        if (v->getContact() == ctc)
+            return qMax(distance, 0.0);
+        parcourues.insert(qMakePair(viensDe, v));
+        distance += v->getLongueurAParcourir();
+        Voie* suivante = v->getVoieSuivante(viensDe);
+        viensDe = v;
+        v = suivante;
+    }
+    return -1.0;
+}
+
 void Loco::setDirection(int d)
 {
     this->direction = d;
@@ -108,8 +198,20 @@ QRectF Loco::boundingRect() const
                   LONGUEUR_LOCO + 2.0 * LONGUEUR_FEUX);
 }
 
-void Loco::paint(QPainter *painter, const QStyleOptionGraphicsItem */*option*/, QWidget */*widget*/)
+void Loco::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget */*widget*/)
 {
+    // Vue de loin : un simple rectangle plein, et un seul cercle pour l'alerte.
+    if (option->levelOfDetailFromTransform(painter->worldTransform()) < LOD_DETAILS)
+    {
+        painter->fillRect(QRectF(-LONGUEUR_LOCO / 2.0, -LARGEUR_LOCO / 2.0, LONGUEUR_LOCO, LARGEUR_LOCO), couleur);
+        if(alerteProximite)
+        {
+            painter->setPen(Qt::red);
+            painter->setBrush(QBrush());
+            painter->drawEllipse(QPointF(0.0, 0.0),LONGUEUR_LOCO / 2.0, LONGUEUR_LOCO / 2.0);
+        }
+        return;
+    }
 
     painter->setBrush(couleur);
 
@@ -164,6 +266,7 @@ void Loco::paint(QPainter *painter, const QStyleOptionGraphicsItem */*option*/,
 void Loco::setVoie(Voie *v)
 {
     this->voieActuelle = v;
+    this->parcouruSurVoie = 0.0;
 }
 
 Voie* Loco::getVoie()
@@ -205,103 +308,203 @@ void CHECK(bool condition)
 void CHECK(bool /*condition*/) {}
 #endif // FULLCHECK
 
-void Loco::avanceDUneVoie()
+MouvementLoco Loco::getMouvement(const ReseauVoies &reseau, qreal distance) const
 {
-    CHECK(voieActuelle != nullptr);
-    Voie* viensDe = voieActuelle;
-
-    CHECK(voieSuivante != nullptr);
-    voieActuelle = voieSuivante;
-
-    voieSuivante = voieActuelle->getVoieSuivante(viensDe);
-    CHECK(voieSuivante != nullptr);
-
-    setPos(voieActuelle->getPosAbsLiaison(viensDe));
+    MouvementLoco m;
+    m.position = pos();
+    m.rotation = rotation();
+    m.angleCumule = angleCumule;
+    m.voie = reseau.indice(voieActuelle);
+    m.suivante = reseau.indice(voieSuivante);
+    m.parcouruSurVoie = parcouruSurVoie;
+    m.distanceLiaison = distanceLiaison;
+    m.distance = distance;
+    return m;
+}
 
-    corrigerAngle(voieActuelle->getNouvelAngle(viensDe));
+void Loco::appliquerMouvement(const MouvementLoco &m, const ReseauVoies &reseau)
+{
+    distanceProfil -= m.distance;
 
-    if(voieActuelle->getContact() != nullptr)
+    for (const VoieFranchie& f : m.franchies)
     {
+        // Les récepteurs de nouveauSegment() voient la loco sur la voie du contact
+        voieActuelle = reseau.voie(f.voie);
+        voieSuivante = f.suivante >= 0 ? reseau.voie(f.suivante) : nullptr;
         Contact* ctc1 = voieActuelle->getContact();
-        Contact* ctc2 = nullptr;
-        viensDe = voieActuelle;
-        Voie* v1 = voieSuivante;
-        Voie* v2 = v1->getVoieSuivante(viensDe);
 
-        CHECK(v2 != nullptr);
-
-        while (ctc2 == nullptr)
+        // Contact visé atteint : la loco le franchit à la vitesse cible
+        if (ctc1 == contactProfil)
         {
-            ctc2 = v1->getContact();
-            viensDe = v1;
-            v1 = v2;
-            v2 = v1->getVoieSuivante(viensDe);
-            CHECK(v2 != nullptr);
+            contactProfil = nullptr;
+            vitesse = vitesseFuture = vitesseCible;
         }
 
-        nouveauSegment(ctc1, ctc2, this);
+        CHECK(f.voieContactSuivant >= 0);
+        if (f.voieContactSuivant >= 0)
+            nouveauSegment(ctc1, reseau.voie(f.voieContactSuivant)->getContact(), this);
 
-        voieActuelle->getContact()->active(); //pas ideal... A revoir.
-        if (TrainSimSettings::getInstance()->getViewLocoLog())
-        {
-            this->controller->console->append(QString("# Passe le contact numéro %1").arg(voieActuelle->getContact()->getNumContact()));
-            std::cout << "Loco " << this->numLoco1->getNumLoco() << " : Passe le contact " << voieActuelle->getContact()->getNumContact() << std::endl;
-        }
+        contactsFranchis.append(PassageContact{ctc1, f.fraction});
     }
+
+    setPos(m.position);
+    setRotation(m.rotation);
+    angleCumule = m.angleCumule;
+    voieActuelle = reseau.voie(m.voie);
+    voieSuivante = m.suivante >= 0 ? reseau.voie(m.suivante) : nullptr;
+    parcouruSurVoie = m.parcouruSurVoie;
+    distanceLiaison = m.distanceLiaison;
 }
 
-void Loco::avancer(qreal distance)
+const QVector<PassageContact> &Loco::getContactsFranchis() const
 {
-    qreal dist = distance;
-    qreal angle = 0.0;
-    qreal rayon = 0.0;
-
-    while(true)
-    {
-        this->voieActuelle->avanceLoco(dist, angle, rayon, this->angleCumule, this->pos(), this->voieSuivante);
+    return contactsFranchis;
+}
 
-        if(rayon == 0.0)
-        {
-            avancerDroit(distance - dist);
-        }
-        else
-        {
-            avancerCourbe(-angle, rayon);
-            angleCumule += angle;
-            if(angleCumule < 0.0)
-                angleCumule += 360.0;
-            if(angleCumule > 360.0)
-                angleCumule -= 360.0;
-        }
+void Loco::viderContactsFranchis()
+{
+    contactsFranchis.clear();
+}
 
-        if(dist == 0.0)
-        {
-            break;
-        }
-        avanceDUneVoie();
+void Loco::activerContact(Contact *ctc)
+{
+    ctc->active();
+    if (reglages->getViewLocoLog())
+    {
+        this->controller->console->append(QString("# Passe le contact numéro %1").arg(ctc->getNumContact()));
+        std::cout << "Loco " << this->numLoco1->getNumLoco() << " : Passe le contact " << ctc->getNumContact() << std::endl;
     }
 }
 
-void Loco::avancerDroit(qreal distance)
+void Loco::debutPas()
 {
-    qreal x =  distance * cos(angleCumule * (PI / 180.0));
-    qreal y = -distance * sin(angleCumule * (PI / 180.0));
-    CHECK(!isnan(x));
-    CHECK(!isnan(y));
-    voieActuelle->correctionPositionLoco(x, y);
-    CHECK(!isnan(x));
-    CHECK(!isnan(y));
-    moveBy(x,y);
-
+    restaurerPose();
+    posPrecedente = pos();
+    rotationPrecedente = rotation();
+    posePrecedenteConnue = true;
 }
 
-void Loco::avancerCourbe(qreal angle, qreal rayon)
+void Loco::afficherPoseInterpolee(qreal fraction)
 {
-    qreal angleAbs = angle < 0.0 ? -angle : angle;
-    qreal dist = rayon * tan(angleAbs * PI / 360.0);
-    avancerDroit(dist);
-    setRotation(rotation() + angle);
-    avancerDroit(dist);
+    restaurerPose();
+    if (!posePrecedenteConnue || fraction <= 0.0)
+        return;
+
+    // Une loco replacée ou retournée n'est pas interpolée : elle apparaît
+    // directement à sa nouvelle pose.
+    QPointF deplacement = pos() - posPrecedente;
+    qreal rotationPas = std::remainder(rotation() - rotationPrecedente, 360.0);
+    if (QPointF::dotProduct(deplacement, deplacement) > LONGUEUR_LOCO * LONGUEUR_LOCO ||
+        qAbs(rotationPas) > 90.0)
+        return;
+
+    // La pose affichée se situe entre les deux derniers pas, en retard d'au plus un pas
+    posFinPas = pos();
+    rotationFinPas = rotation();
+    setPos(posPrecedente + deplacement * fraction);
+    setRotation(rotationPrecedente + rotationPas * fraction);
+    posAffichee = pos();
+    rotationAffichee = rotation();
+    poseInterpolee = true;
+}
+
+void Loco::restaurerPose()
+{
+    if (!poseInterpolee)
+        return;
+
+    const QPointF p = posSimulee();
+    const qreal r = rotationSimulee();
+    poseInterpolee = false;
+    setPos(p);
+    setRotation(r);
+}
+
+QPointF Loco::posSimulee() const
+{
+    // Une loco replacée depuis l'affichage garde sa nouvelle position
+    if (!poseInterpolee || pos() != posAffichee)
+        return pos();
+    return posFinPas;
+}
+
+qreal Loco::rotationSimulee() const
+{
+    // Les rotations faites depuis l'affichage (inversion du sens, déraillement)
+    // sont relatives : elles s'ajoutent à la pose simulée.
+    if (!poseInterpolee)
+        return rotation();
+    return rotationFinPas + rotation() - rotationAffichee;
+}
+
+void Loco::ecrireEtat(QDataStream &flux) const
+{
+    const QPointF p = posSimulee();
+    flux << qint32(voieActuelle != nullptr ? voieActuelle->getIdVoie() : -1)
+         << qint32(voieSuivante != nullptr ? voieSuivante->getIdVoie() : -1)
+         << p.x() << p.y() << rotationSimulee() << angleCumule << parcouruSurVoie
+         << qint8(vitesse) << qint8(vitesseFuture) << qint8(direction)
+         << inverser << active << deraille
+         << qint16(contactProfil != nullptr ? contactProfil->getNumContact() : 0)
+         << qint8(vitesseCible) << vitesseProfil << distanceProfil << limiteVitesse;
+}
+
+bool Loco::lireEtat(QDataStream &flux, const QMap<int, Voie *> &voies,
+                    const QMap<int, Contact *> &contacts, EtatLoco &etat)
+{
+    qint32 idVoie, idSuivante;
+    qint8 v, vf, d, vc;
+    qint16 numContact;
+
+    flux >> idVoie >> idSuivante >> etat.x >> etat.y >> etat.rotation
+         >> etat.angleCumule >> etat.parcouruSurVoie
+         >> v >> vf >> d >> etat.inverser >> etat.active >> etat.deraille
+         >> numContact >> vc >> etat.vitesseProfil >> etat.distanceProfil >> etat.limiteVitesse;
+    if (flux.status() != QDataStream::Ok)
+        return false;
+    if ((idVoie >= 0 && !voies.contains(idVoie)) || (idSuivante >= 0 && !voies.contains(idSuivante)))
+        return false;
+
+    etat.voieActuelle = voies.value(idVoie);
+    etat.voieSuivante = voies.value(idSuivante);
+    etat.vitesse = v;
+    etat.vitesseFuture = vf;
+    etat.direction = d;
+    etat.vitesseCible = vc;
+    etat.contactProfil = contacts.value(numContact);
+    return true;
+}
+
+void Loco::appliquerEtat(const EtatLoco &etat)
+{
+    voieActuelle = etat.voieActuelle;
+    voieSuivante = etat.voieSuivante;
+    poseInterpolee = false;
+    posePrecedenteConnue = false;
+    setPos(etat.x, etat.y);
+    setRotation(etat.rotation);
+    angleCumule = etat.angleCumule;
+    parcouruSurVoie = etat.parcouruSurVoie;
+    distanceLiaison = 1000.0;
+    vitesse = etat.vitesse;
+    vitesseFuture = etat.vitesseFuture;
+    direction = etat.direction;
+    inverser = etat.inverser;
+    active = etat.active;
+    deraille = etat.deraille;
+    contactProfil = etat.contactProfil;
+    vitesseCible = etat.vitesseCible;
+    vitesseProfil = etat.vitesseProfil;
+    distanceProfil = etat.distanceProfil;
+    limiteVitesse = etat.limiteVitesse;
+    viderContactsFranchis();
+
+    // L'inertie ne s'applique pas pendant un profil de vitesse
+    if (contactProfil == nullptr && (vitesse != vitesseFuture || inverser))
+        demarrerInertie();
+    else
+        inertieActive = false;
+    update();
 }
 
 void Loco::setAngleCumule(qreal a)
@@ -319,6 +522,11 @@ void Loco::setSegmentActuel(Segment *s)
     this->segmentActuel = s;
 }
 
+Segment* Loco::getSegmentActuel()
+{
+    return this->segmentActuel;
+}
+
 void Loco::setAlerteProximite(bool b)
 {
     this->alerteProximite = b;
@@ -336,10 +544,11 @@ QPolygonF Loco::getContour()
 
 void Loco::inverserSens()
 {
-    if(TrainSimSettings::getInstance()->getInertie())
+    contactProfil = nullptr;
+    if(reglages->getInertie())
     {
         inverser = true;
-        this->timer->start(INERTIE_LOCO);
+        demarrerInertie();
     }
     else
     {
@@ -351,18 +560,6 @@ void Loco::inverserSens()
     }
 }
 
-void Loco::corrigerAngle(qreal nouvelAngle)
-{
-    QPointF avantLoco = mapToScene(LONGUEUR_LOCO / 2.0, 0.0);
-    qreal angleReel = atan2(- avantLoco.y() + pos().y(), avantLoco.x() - pos().x()) * 180.0 / PI;
-
-    setRotation(rotation() + angleReel);
-
-    setRotation( rotation() - nouvelAngle);
-
-    this->angleCumule = nouvelAngle;
-}
-
 void Loco::locoSurSegment(Segment *s)
 {
     if(s == segmentActuel)
@@ -377,6 +574,7 @@ void Loco::voieVariableModifiee(Voie *v)
     if(v == voieActuelle)
     {
         deraille = true;
+        contactProfil = nullptr;
         vitesse = vitesseFuture = 0;
         setRotation(rotation()+20.0);
     }
@@ -406,6 +604,25 @@ void Loco::adapterVitesse()
         else if(vitesse - vitesseFuture > 0)
             vitesse--;
         else
-            timer->stop();
+            inertieActive = false;
+    }
+}
+
+void Loco::demarrerInertie()
+{
+    inertieActive = true;
+    inertieEcoulee = 0;
+}
+
+void Loco::avancerInertie(qint64 dureeUs)
+{
+    if (!inertieActive)
+        return;
+
+    inertieEcoulee += dureeUs;
+    while (inertieActive && inertieEcoulee >= INERTIE_LOCO * 1000)
+    {
+        inertieEcoulee -= INERTIE_LOCO * 1000;
+        adapterVitesse();
     }
 }
@@ -5,10 +5,14 @@
 #include <QAbstractGraphicsShapeItem>
 #include <QStaticText>
 #include <QPainter>
-#include <QTimer>
+#include <QStyleOptionGraphicsItem>
+#include <QDataStream>
+#include <QMap>
+#include <QVector>
 
 #include "general.h"
 #include "voie.h"
+#include "reseauvoies.h"
 #include "segment.h"
 #include "connect.h"
 
@@ -40,6 +44,39 @@ private:
 };
 
 class LocoCtrl;
+class TrainSimSettings;
+
+/** Passage d'une loco sur un contact pendant un pas d'animation.
+  */
+struct PassageContact
+{
+    Contact* contact;
+    qreal fraction;     //!< part du pas écoulée au moment du passage, entre 0 et 1
+};
+
+/** Etat d'une loco relu dans un fichier, validé avant d'être appliqué.
+  */
+struct EtatLoco
+{
+    Voie* voieActuelle;
+    Voie* voieSuivante;
+    qreal x;
+    qreal y;
+    qreal rotation;
+    qreal angleCumule;
+    qreal parcouruSurVoie;
+    int vitesse;
+    int vitesseFuture;
+    int direction;
+    bool inverser;
+    bool active;
+    bool deraille;
+    Contact* contactProfil;
+    int vitesseCible;
+    qreal vitesseProfil;
+    qreal distanceProfil;
+    qreal limiteVitesse;
+};
 
 class Loco : public QObject, public QAbstractGraphicsShapeItem
 {
@@ -48,8 +85,9 @@ public:
 
     /** Constructeur de classe.
       * \param numLoco le numéro de la loco.
+      * \param reglages les réglages de la simulation, qui doivent survivre à la loco.
       */
-    explicit Loco(int numLoco, QObject *parent = 0);
+    Loco(int numLoco, TrainSimSettings* reglages, QObject *parent = 0);
 
     /** Permet de changer la vitesse de la loco.
       * Le comportement dépend de l'option "Inertie" :
@@ -64,6 +102,52 @@ public:
       */
     int getVitesse();
 
+    /** Fait ralentir la loco pour qu'elle franchisse un contact à la vitesse donnée.
+      * La loco garde sa vitesse puis freine avec la décélération DECELERATION_LOCO,
+      * juste assez tôt pour atteindre la vitesse cible au contact, où le profil prend fin.
+      * Avec une vitesse cible nulle, la loco s'arrête juste avant le contact.
+      * Si la vitesse cible n'est pas inférieure à la vitesse actuelle, ou si le
+      * contact n'est pas devant la loco, le changement se fait comme avec setVitesse().
+      * \param v la vitesse au contact.
+      * \param ctc le contact.
+      */
+    void setProfilVitesse(int v, Contact* ctc);
+
+    /** Met à jour la vitesse de la loco suivant son profil, à chaque pas d'animation.
+      */
+    void appliquerProfilVitesse();
+
+    /** Retourne la vitesse de la loco, non arrondie pendant un profil de vitesse et
+      * bornée par la limite du canton mobile.
+      * \return la vitesse à utiliser pour faire avancer la loco.
+      */
+    qreal getVitesseReelle();
+
+    /** borne la vitesse de la loco, sans changer sa vitesse commandée.
+      * \param limite la vitesse maximale, négative pour lever la limite.
+      */
+    void setLimiteVitesse(qreal limite);
+
+    /** retourne la distance restant à parcourir sur la voie actuelle.
+      * \return la distance jusqu'à la voie suivante.
+      */
+    qreal getResteSurVoie();
+
+    /** retourne la distance nécessaire pour freiner avec la décélération DECELERATION_LOCO.
+      * \param vitesse la vitesse de départ.
+      * \param vitesseFinale la vitesse à atteindre.
+      * \return la distance de freinage.
+      */
+    static qreal distanceFreinage(qreal vitesse, qreal vitesseFinale = 0.0);
+
+    /** retourne la vitesse la plus élevée depuis laquelle une loco peut encore
+      * atteindre une vitesse donnée sur une distance donnée.
+      * \param distance la distance disponible.
+      * \param vitesseFinale la vitesse à atteindre.
+      * \return la vitesse maximale.
+      */
+    static qreal vitesseAvantFreinage(qreal distance, qreal vitesseFinale = 0.0);
+
     /** permet de changer la direction de la loco.
       * N'est pas utilisé : pour changer de sens, on effectue une rotation de 180°.
       * \param d la nouvelle direction (DIRECTION_LOCO_GAUCHE ou DIRECTION_LOCO_DROITE)
@@ -127,26 +211,20 @@ public:
       */
     bool getActive();
 
-    /** effectue la transition d'une voie à l'autre et repositionne la loco (corrige les imprécisions de calcul).
-      *
-      */
-    void avanceDUneVoie();
-
-    /** Fait avancer la loco d'une certaine distance.
+    /** relève l'état de la loco nécessaire pour la faire avancer d'une certaine distance
+      * avec ReseauVoies::avancerLoco().
+      * \param reseau le réseau de voies de la maquette.
       * \param distance la distance de laquelle il faut faire avancer la loco.
       */
-    void avancer(qreal distance);
+    MouvementLoco getMouvement(const ReseauVoies& reseau, qreal distance) const;
 
-    /** avance la loco le long d'une droite, d'une distance determinee.
-      * \param distance la distance de laquelle il faut faire avancer la loco.
+    /** reporte sur la loco un mouvement calculé par ReseauVoies::avancerLoco() : pose,
+      * voies, profil de vitesse et contacts franchis. Emet nouveauSegment() pour chaque
+      * contact franchi, et doit donc être appelé depuis le thread de la simulation.
+      * \param m le mouvement calculé.
+      * \param reseau le réseau de voies utilisé pour le calcul.
       */
-    void avancerDroit(qreal distance);
-
-    /** avance la loco selon une courbe, définie par un angle et un rayon.
-      * \param angle l'angle de rotation
-      * \param rayon le rayon de rotation
-      */
-    void avancerCourbe(qreal angle, qreal rayon);
+    void appliquerMouvement(const MouvementLoco& m, const ReseauVoies& reseau);
 
     /** permet de mettre à jour l'angle cumule
       * \param a la nouvelle valeur de l'angle cumule
@@ -163,6 +241,11 @@ public:
       */
     void setSegmentActuel(Segment* s);
 
+    /** retourne le segment sur lequel la loco se trouve.
+      * \return le segment, nullptr s'il n'est pas connu.
+      */
+    Segment* getSegmentActuel();
+
     /** permet de changer la valeur booléenne d'alerte de proximité.
       * \param b la nouvelle valeur booléenne d'alerte de proximité.
       */
@@ -185,10 +268,61 @@ public:
       */
     void inverserSens();
 
-    /** Permet de corriger l'angle de la loco suite à des imprécisions de calcul.
-      * \param nouvelAngle le nouvel angle.
+    /** retourne les contacts franchis depuis le dernier appel à viderContactsFranchis(),
+      * dans l'ordre de passage. appliquerMouvement() ne fait que les noter, pour que la simulation
+      * puisse les publier une fois toutes les locos déplacées.
+      * \return les passages de contacts.
+      */
+    const QVector<PassageContact>& getContactsFranchis() const;
+
+    /** oublie les contacts franchis.
+      */
+    void viderContactsFranchis();
+
+    /** Active un contact franchi par la loco.
+      * \param ctc le contact.
+      */
+    void activerContact(Contact* ctc);
+
+    /** A appeler au début de chaque pas de simulation, avant de déplacer la loco :
+      * remet la loco à la pose simulée si une pose interpolée est affichée, et
+      * mémorise cette pose comme celle du pas précédent.
+      */
+    void debutPas();
+
+    /** Affiche la loco entre la pose du pas précédent et celle du dernier pas, pour
+      * un mouvement régulier quel que soit le nombre de pas simulés par image. La
+      * pose simulée est conservée et reprise par debutPas().
+      * \param fraction la part du pas suivant déjà écoulée, entre 0 et 1.
+      */
+    void afficherPoseInterpolee(qreal fraction);
+
+    /** fait s'écouler le temps simulé pour l'inertie : la vitesse change d'une unité
+      * toutes les INERTIE_LOCO ms de temps simulé. A appeler à chaque pas de simulation.
+      * \param dureeUs la durée du pas, en microsecondes.
+      */
+    void avancerInertie(qint64 dureeUs);
+
+    /** écrit l'état de la loco : voies et position exacte, vitesses, inertie et profil
+      * de vitesse en cours. Les voies et les contacts sont désignés par leur numéro.
+      * \param flux le flux où écrire.
       */
-    void corrigerAngle(qreal nouvelAngle);
+    void ecrireEtat(QDataStream& flux) const;
+
+    /** relit un état écrit par ecrireEtat(), sans modifier aucune loco.
+      * \param flux le flux à lire.
+      * \param voies les voies de la maquette, par numéro.
+      * \param contacts les contacts de la maquette, par numéro.
+      * \param etat l'état relu, à appliquer avec appliquerEtat().
+      * \return faux si l'état est illisible ou désigne une voie inconnue.
+      */
+    static bool lireEtat(QDataStream& flux, const QMap<int, Voie*>& voies,
+                         const QMap<int, Contact*>& contacts, EtatLoco& etat);
+
+    /** applique un état relu par lireEtat() et reprend l'inertie là où elle en était.
+      * \param etat l'état à appliquer.
+      */
+    void appliquerEtat(const EtatLoco& etat);
 
     LocoCtrl *controller;
 signals:
@@ -215,26 +349,64 @@ public slots:
       * \param v la voie variable modifiée.
       */
     void voieVariableModifiee(Voie* v);
-
-    /** Reçoit le signal qu'il faut adapter la vitesse d'un incrément / décrément.
+private:
+    /** adapte la vitesse d'un incrément / décrément, à chaque période d'inertie.
       */
     void adapterVitesse();
-private:
+
+    /** (re)lance l'inertie : la prochaine adaptation a lieu dans INERTIE_LOCO ms.
+      */
+    void demarrerInertie();
+
+    /** Retourne la distance à parcourir jusqu'à l'activation d'un contact, en suivant
+      * l'état actuel des aiguillages.
+      * \param ctc le contact.
+      * \return la distance, négative si le contact n'est pas devant la loco.
+      */
+    qreal distanceJusquA(Contact* ctc);
+
+    /** Remet la loco à la pose simulée si une pose interpolée est affichée.
+      */
+    void restaurerPose();
+
+    /** Retourne la pose simulée, même si une pose interpolée est affichée.
+      */
+    QPointF posSimulee() const;
+    qreal rotationSimulee() const;
+
+    TrainSimSettings* reglages;
     panneauNumLoco* numLoco1{nullptr};
     panneauNumLoco* numLoco2{nullptr};
     qreal angleCumule;
     bool active;
     int vitesse;
     int vitesseFuture;
+    Contact* contactProfil{nullptr};    //!< contact visé par le profil de vitesse, nullptr sans profil
+    int vitesseCible{0};
+    qreal vitesseProfil{0.0};
+    qreal distanceProfil{0.0};          //!< distance restant à parcourir jusqu'au contact visé
+    qreal parcouruSurVoie{0.0};         //!< distance parcourue depuis l'entrée sur la voie actuelle
+    qreal distanceLiaison{1000.0};      //!< dernière distance à la liaison visée sur la voie actuelle
+    qreal limiteVitesse{-1.0};          //!< limite du canton mobile, négative sans limite
     int direction;
     QColor couleur;
     Voie* voieActuelle{nullptr};
     Voie* voieSuivante{nullptr};
     Segment* segmentActuel{nullptr};
+    QVector<PassageContact> contactsFranchis;
     bool alerteProximite;
     bool inverser;
     bool deraille;
-    QTimer* timer{nullptr};
+    bool inertieActive{false};
+    qint64 inertieEcoulee{0};           //!< temps simulé depuis la dernière adaptation, en microsecondes
+    QPointF posPrecedente;              //!< pose au début du dernier pas
+    qreal rotationPrecedente{0.0};
+    bool posePrecedenteConnue{false};
+    QPointF posFinPas;                  //!< pose à la fin du dernier pas, pendant l'interpolation
+    qreal rotationFinPas{0.0};
+    QPointF posAffichee;                //!< pose interpolée affichée
+    qreal rotationAffichee{0.0};
+    bool poseInterpolee{false};
     QWaitCondition* VarCond{nullptr};
     QMutex* mutex{nullptr};
 };
@@ -1,6 +1,7 @@
 #include <QApplication>
 #include <QSettings>
 #include <QDebug>
+#include <QCommandLineParser>
 
 #include <iostream>
 using namespace std;
@@ -21,6 +22,47 @@ int main(int argc, char *argv[])
 
     QApplication app(argc,argv);
 
+    //Enregistrement ou rejeu d'une trace de simulation
+    QCommandLineParser parser;
+    QCommandLineOption enregistrer("enregistrer", "Enregistre une trace de la simulation.", "fichier");
+    QCommandLineOption rejouer("rejouer", "Rejoue une trace sans le simulateur.", "fichier");
+    QCommandLineOption images("images", "Exporte des images de la simulation dans un dossier.", "dossier");
+    QCommandLineOption periodeImages("periode-images", "Nombre de pas de simulation entre deux images (0 : collisions seulement).", "pas", "60");
+    QCommandLineOption imagesBrutes("images-brutes", "Exporte des pixels RGBA non compressés au lieu de PNG.");
+    QCommandLineOption batch("batch", "Simule sans interface et écrit les mesures dans un fichier JSON.", "fichier");
+    QCommandLineOption duree("duree", "Durée de la simulation en batch, en millisecondes de temps simulé.", "ms", "600000");
+    parser.addOption(enregistrer);
+    parser.addOption(rejouer);
+    parser.addOption(images);
+    parser.addOption(periodeImages);
+    parser.addOption(imagesBrutes);
+    parser.addOption(batch);
+    parser.addOption(duree);
+    parser.process(app);
+
+    if (parser.isSet(rejouer) && !CommandeTrain::getInstance()->rejouer_trace(parser.value(rejouer)))
+    {
+        cerr << "Trace invalide : " << qPrintable(parser.value(rejouer)) << endl;
+        return 1;
+    }
+    if (parser.isSet(enregistrer) && !CommandeTrain::getInstance()->enregistrer_trace(parser.value(enregistrer)))
+    {
+        cerr << "Impossible de créer la trace : " << qPrintable(parser.value(enregistrer)) << endl;
+        return 1;
+    }
+
+    if (parser.isSet(images) &&
+        !CommandeTrain::getInstance()->exporter_images(parser.value(images),
+                                                       parser.value(periodeImages).toInt(),
+                                                       parser.isSet(imagesBrutes)))
+    {
+        cerr << "Impossible d'utiliser le dossier d'images : " << qPrintable(parser.value(images)) << endl;
+        return 1;
+    }
+
+    if (parser.isSet(batch))
+        CommandeTrain::getInstance()->executer_batch(parser.value(batch), parser.value(duree).toLongLong());
+
     //Init the marklin maquette
 #ifdef MAQUETTE
     init_maquette();
@@ -38,8 +38,8 @@
 
 
 
-MainWindow::MainWindow(QWidget *parent) :
-    QMainWindow(parent)
+MainWindow::MainWindow(CommandeTrain *commande, TrainSimSettings *reglages, QWidget *parent) :
+    QMainWindow(parent), commande(commande), reglages(reglages)
 {
     generalConsole = new QTextEdit(this);
     dockGeneralConsole = new QDockWidget("Console generale",this);
@@ -51,10 +51,12 @@ MainWindow::MainWindow(QWidget *parent) :
     inputDock->setWidget(inputWidget);
     addDockWidget(Qt::TopDockWidgetArea, inputDock, Qt::Horizontal);
     CONNECT(inputWidget, SIGNAL(returnPressed()), this, SLOT(onReturnPressed()));
-    CommandeTrain* ct = CommandeTrain::getInstance();
-    CONNECT(this, SIGNAL(commandSent(QString)), ct, SLOT(commandSent(QString)))
+    CONNECT(this, SIGNAL(commandSent(QString)), commande, SLOT(commandSent(QString)))
 
-    myRedirector = new StdRedirector<>( std::cout, outcallback, generalConsole );
+    // std::cout est unique : seule la fenêtre du contexte par défaut l'affiche
+    myRedirector = nullptr;
+    if (commande == CommandeTrain::getInstance())
+        myRedirector = new StdRedirector<>( std::cout, outcallback, generalConsole );
 
     //Lecture des informations des voies.
     QFile fichierInfosVoies(DATADIR+"/infosVoies.txt");
@@ -135,7 +137,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     setGeometry(0,0,530,580);
 
-    simView = new SimView(this);
+    simView = new SimView(reglages, this);
 
     setCentralWidget(simView);
 
@@ -169,14 +171,14 @@ void MainWindow::readSettings()
 {
     QSettings settings(ORG,APPNAME);
     this->setGeometry(settings.value("geometry",QRect(100,100,700,600)).toRect());
-    TrainSimSettings::getInstance()->setViewAiguillageNumber(settings.value("viewAiguillageNb",false).toBool());
-    viewAiguillageNumberAct->setChecked(TrainSimSettings::getInstance()->getViewAiguillageNumber());
-    TrainSimSettings::getInstance()->setViewContactNumber(settings.value("viewContactNb",false).toBool());
-    viewContactNumberAct->setChecked(TrainSimSettings::getInstance()->getViewContactNumber());
-    TrainSimSettings::getInstance()->setViewLocoLog(settings.value("viewLocoLog",false).toBool());
-    viewLocoLogAct->setChecked(TrainSimSettings::getInstance()->getViewLocoLog());
-    TrainSimSettings::getInstance()->setInertie(settings.value("inertie",true).toBool());
-    inertieAct->setChecked(TrainSimSettings::getInstance()->getInertie());
+    reglages->setViewAiguillageNumber(settings.value("viewAiguillageNb",false).toBool());
+    viewAiguillageNumberAct->setChecked(reglages->getViewAiguillageNumber());
+    reglages->setViewContactNumber(settings.value("viewContactNb",false).toBool());
+    viewContactNumberAct->setChecked(reglages->getViewContactNumber());
+    reglages->setViewLocoLog(settings.value("viewLocoLog",false).toBool());
+    viewLocoLogAct->setChecked(reglages->getViewLocoLog());
+    reglages->setInertie(settings.value("inertie",true).toBool());
+    inertieAct->setChecked(reglages->getInertie());
 
 }
 
@@ -184,10 +186,10 @@ void MainWindow::writeSettings() const
 {
     QSettings settings(ORG,APPNAME);
     settings.setValue("geometry",geometry());
-    settings.setValue("viewAiguillageNb",TrainSimSettings::getInstance()->getViewAiguillageNumber());
-    settings.setValue("viewContactNb",TrainSimSettings::getInstance()->getViewContactNumber());
-    settings.setValue("viewLocoLog",TrainSimSettings::getInstance()->getViewLocoLog());
-    settings.setValue("inertie",TrainSimSettings::getInstance()->getInertie());
+    settings.setValue("viewAiguillageNb",reglages->getViewAiguillageNumber());
+    settings.setValue("viewContactNb",reglages->getViewContactNumber());
+    settings.setValue("viewLocoLog",reglages->getViewLocoLog());
+    settings.setValue("inertie",reglages->getInertie());
 }
 
 
@@ -344,7 +346,7 @@ void MainWindow::afficherMessageLoco(int numLoco,QString message)
 
 void MainWindow::addLoco(int no_loco)
 {
-    Loco* l = new Loco(no_loco);
+    Loco* l = new Loco(no_loco, reglages);
     simView->addLoco(l, no_loco);
 
     LocoCtrl *c=new LocoCtrl;
@@ -390,6 +392,10 @@ void MainWindow::createActions()
     printAct->setStatusTip(tr("Print the map"));
     CONNECT(printAct, SIGNAL(triggered()), this, SLOT(print()));
 
+    snapshotAct = new QAction(tr("Save &snapshot..."), this);
+    snapshotAct->setStatusTip(tr("Save an image of the whole map"));
+    CONNECT(snapshotAct, SIGNAL(triggered()), this, SLOT(saveSnapshot()));
+
     toggleSimAct = new QAction(tr("&Pause"), this);
     toggleSimAct->setShortcut(tr("Ctrl+P"));
     toggleSimAct->setStatusTip(tr("Pause the simulation"));
@@ -477,6 +483,11 @@ void MainWindow::createActions()
     inertieAct->setStatusTip(tr("Enable inertia"));
     inertieAct->setCheckable(true);
     CONNECT(inertieAct, SIGNAL(triggered()), this, SLOT(toggleInertie()));
+
+    modeRapideAct = new QAction(tr("Fast simulation"), this);
+    modeRapideAct->setStatusTip(tr("Run the simulation as fast as possible"));
+    modeRapideAct->setCheckable(true);
+    CONNECT(modeRapideAct, SIGNAL(triggered()), this, SLOT(toggleModeRapide()));
 }
 
 void MainWindow::createMenus()
@@ -484,6 +495,7 @@ void MainWindow::createMenus()
     QMenu *fileMenu = menuBar()->addMenu(tr("&File"));
     //fileMenu->addAction(chargerMaquetteAct);
     fileMenu->addAction(printAct);
+    fileMenu->addAction(snapshotAct);
     fileMenu->addAction(exitAct);
 
     actionMenu = menuBar()->addMenu(tr("&Actions"));
@@ -508,6 +520,7 @@ void MainWindow::createMenus()
 
     QMenu *settings=menuBar()->addMenu(tr("&Settings"));
     settings->addAction(inertieAct);
+    settings->addAction(modeRapideAct);
 }
 
 #include <QPrintDialog>
@@ -543,24 +556,39 @@ void MainWindow::print()
 
 void MainWindow::viewContactNumber()
 {
-    TrainSimSettings::getInstance()->setViewContactNumber(viewContactNumberAct->isChecked());
+    reglages->setViewContactNumber(viewContactNumberAct->isChecked());
     simView->redraw();
 }
 
 void MainWindow::viewAiguillageNumber()
 {
-    TrainSimSettings::getInstance()->setViewAiguillageNumber(viewAiguillageNumberAct->isChecked());
+    reglages->setViewAiguillageNumber(viewAiguillageNumberAct->isChecked());
     simView->redraw();
 }
 
+void MainWindow::saveSnapshot()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Enregistrer une image"), QString(), tr("Images PNG (*.png)"));
+    if (filename.isEmpty())
+        return;
+
+    if (!simView->capturer().save(filename, "PNG"))
+        QMessageBox::warning(this, "Erreur", QString("Impossible d'enregistrer l'image %1.").arg(filename));
+}
+
 void MainWindow::viewLocoLog()
 {
-    TrainSimSettings::getInstance()->setViewLocoLog(viewLocoLogAct->isChecked());
+    reglages->setViewLocoLog(viewLocoLogAct->isChecked());
 }
 
 void MainWindow::toggleInertie()
 {
-    TrainSimSettings::getInstance()->setInertie(inertieAct->isChecked());
+    reglages->setInertie(inertieAct->isChecked());
+}
+
+void MainWindow::toggleModeRapide()
+{
+    reglages->setModeRapide(modeRapideAct->isChecked());
 }
 
 SimView* MainWindow::getSimView()
@@ -81,6 +81,8 @@ protected:
    void*                         m_pUserData;
  };
 
+class CommandeTrain;
+
 class LocoCtrl : public QObject
 {
 public:
@@ -100,9 +102,10 @@ class MainWindow : public QMainWindow
 
 public:
     /** Constructeur de classe.
-      *
+      * \param commande la commande de train qui reçoit les commandes saisies.
+      * \param reglages les réglages de la simulation.
       */
-    explicit MainWindow(QWidget *parent = 0);
+    MainWindow(CommandeTrain* commande, TrainSimSettings* reglages, QWidget *parent = 0);
 
     /** Destructeur de classe.
       *
@@ -157,8 +160,10 @@ public:
     QAction *viewLocoLogAct;
     QAction *viewInputAct;
     QAction *inertieAct;
+    QAction *modeRapideAct;
     QAction *emergencyStopAct;
     QAction *printAct;
+    QAction *snapshotAct;
 
     QMenu *actionMenu;
     QToolBar *toolBar;
@@ -176,6 +181,8 @@ private slots:
     void on_actionCharger_Maquette_triggered();
 
 private:
+    CommandeTrain *commande;
+    TrainSimSettings *reglages;
     SimView *simView;
     QMap <int, QList<double>*> infosVoies;
 
@@ -197,9 +204,11 @@ public slots:
     void viewLocoLog();
     void toggleLoco(QObject *locoCtrls);
     void toggleInertie();
+    void toggleModeRapide();
     void afficherMessage(QString message);
     void afficherMessageLoco(int numLoco,QString message);
     void print();
+    void saveSnapshot();
     void onReturnPressed();
 };
 
@@ -0,0 +1,101 @@
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+#include "mesuresbatch.h"
+
+void MesuresBatch::demarrer(const QString &nomFichier, qint64 duree)
+{
+    this->nomFichier = nomFichier;
+    this->duree = duree;
+    actif = true;
+}
+
+void MesuresBatch::contact(int numLoco, qint64 temps)
+{
+    locos[numLoco].contacts++;
+    derniereActivation = temps;
+}
+
+void MesuresBatch::pas(int numLoco, qreal distance, qint64 dureePasUs)
+{
+    CompteursLoco& l = locos[numLoco];
+    l.distance += distance;
+    if (distance == 0.0)
+        l.tempsArret += dureePasUs;
+}
+
+void MesuresBatch::debutMesure(const QString &nom, int numLoco, qint64 temps)
+{
+    QMutexLocker verrou(&mutex);
+    debuts.insert(qMakePair(nom, numLoco), temps);
+}
+
+void MesuresBatch::finMesure(const QString &nom, int numLoco, qint64 temps)
+{
+    QMutexLocker verrou(&mutex);
+
+    // Une fin sans début est ignorée
+    auto it = debuts.find(qMakePair(nom, numLoco));
+    if (it == debuts.end())
+        return;
+
+    qint64 d = temps - it.value();
+    debuts.erase(it);
+    Duree& mesure = durees[nom];
+    mesure.nombre++;
+    mesure.total += d;
+    mesure.max = qMax(mesure.max, d);
+}
+
+bool MesuresBatch::termine(qint64 temps, int nbreLocosActives)
+{
+    if (temps - derniereActivation > DELAI_INTERBLOCAGE_MS && nbreLocosActives > 0)
+        interblocage = true;
+    return temps >= duree || interblocage || (nbreLocosActives == 0 && !locos.isEmpty());
+}
+
+bool MesuresBatch::ecrire(qint64 temps)
+{
+    QJsonObject resultats;
+    resultats["temps_simule_ms"] = double(temps);
+    resultats["collisions"] = collisions;
+    resultats["interblocage"] = interblocage;
+
+    int contacts = 0;
+    QJsonArray listeLocos;
+    for (auto it = locos.constBegin(); it != locos.constEnd(); ++it)
+    {
+        QJsonObject l;
+        l["numero"] = it.key();
+        l["contacts"] = it.value().contacts;
+        l["distance"] = it.value().distance;
+        l["temps_arret_ms"] = double(it.value().tempsArret) / 1000.0;
+        listeLocos.append(l);
+        contacts += it.value().contacts;
+    }
+    resultats["contacts"] = contacts;
+    resultats["debit_contacts_par_minute"] = temps > 0 ? contacts * 60000.0 / temps : 0.0;
+    resultats["locos"] = listeLocos;
+
+    QMutexLocker verrou(&mutex);
+    QJsonObject mesures;
+    for (auto it = durees.constBegin(); it != durees.constEnd(); ++it)
+    {
+        QJsonObject m;
+        m["nombre"] = it.value().nombre;
+        m["total_ms"] = double(it.value().total);
+        m["max_ms"] = double(it.value().max);
+        m["moyenne_ms"] = it.value().nombre > 0 ? double(it.value().total) / it.value().nombre : 0.0;
+        mesures[it.key()] = m;
+    }
+    resultats["mesures"] = mesures;
+
+    QFile fichier(nomFichier);
+    if (!fichier.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    fichier.write(QJsonDocument(resultats).toJson());
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef MESURESBATCH_H
+#define MESURESBATCH_H
+
+#include <QString>
+#include <QMap>
+#include <QPair>
+#include <QMutex>
+
+//! Temps simulé sans aucune activation de contact au-delà duquel la simulation
+//! est considérée comme interbloquée.
+#define DELAI_INTERBLOCAGE_MS 60000
+
+/** Mesures d'une simulation sans interface, lancée par qtrainsim_batch. Le simulateur
+  * compte les contacts franchis, la distance parcourue et le temps d'arrêt de chaque
+  * loco, ainsi que les collisions ; le programme de contrôle y ajoute des durées
+  * nommées, par exemple l'attente d'une section partagée. La simulation se termine
+  * au bout de la durée demandée, ou plus tôt si plus aucun contact n'est franchi.
+  * Les résultats sont écrits dans un fichier JSON.
+  */
+class MesuresBatch
+{
+public:
+    /** active les mesures.
+      * \param nomFichier le fichier JSON où écrire les résultats.
+      * \param duree la durée de la simulation, en millisecondes de temps simulé.
+      */
+    void demarrer(const QString& nomFichier, qint64 duree);
+
+    bool estActif() const { return actif; }
+
+    /** compte un contact franchi par une loco. A appeler depuis le thread du simulateur.
+      */
+    void contact(int numLoco, qint64 temps);
+
+    /** compte un pas de simulation d'une loco. A appeler depuis le thread du simulateur.
+      * \param numLoco le numéro de la loco.
+      * \param distance la distance parcourue pendant le pas.
+      * \param dureePasUs la durée du pas, en microsecondes.
+      */
+    void pas(int numLoco, qreal distance, qint64 dureePasUs);
+
+    void collision() { collisions++; }
+
+    /** commence ou termine une durée nommée. Peut être appelé depuis n'importe quel thread.
+      * \param nom le nom de la mesure.
+      * \param numLoco la loco mesurée.
+      * \param temps le temps simulé.
+      */
+    void debutMesure(const QString& nom, int numLoco, qint64 temps);
+    void finMesure(const QString& nom, int numLoco, qint64 temps);
+
+    /** indique si la simulation doit s'arrêter : durée écoulée, interblocage, ou plus
+      * aucune loco en état de rouler.
+      * \param temps le temps simulé.
+      * \param nbreLocosActives le nombre de locos encore actives.
+      */
+    bool termine(qint64 temps, int nbreLocosActives);
+
+    /** écrit les résultats.
+      * \param temps le temps simulé à la fin de la simulation.
+      * \return vrai si le fichier a pu être écrit.
+      */
+    bool ecrire(qint64 temps);
+
+private:
+    //! compteurs d'une loco.
+    struct CompteursLoco
+    {
+        int contacts{0};
+        qreal distance{0.0};
+        qint64 tempsArret{0};   //!< en microsecondes
+    };
+
+    //! durées accumulées d'une mesure nommée.
+    struct Duree
+    {
+        int nombre{0};
+        qint64 total{0};
+        qint64 max{0};
+    };
+
+    bool actif{false};
+    QString nomFichier;
+    qint64 duree{0};
+    qint64 derniereActivation{0};
+    bool interblocage{false};
+    int collisions{0};
+    QMap<int, CompteursLoco> locos;
+
+    QMutex mutex;                                   //!< protège les mesures nommées
+    QMap<QPair<QString, int>, qint64> debuts;
+    QMap<QString, Duree> durees;
+};
+
+#endif // MESURESBATCH_H
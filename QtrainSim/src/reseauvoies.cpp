@@ -0,0 +1,572 @@
+#include <limits>
+#include <queue>
+
+#include <QTransform>
+
+#include "reseauvoies.h"
+#include "voievariable.h"
+
+namespace {
+
+// Comme Voie::normaliserAngle()
+qreal normaliserAngle(qreal angle)
+{
+    while (angle < 0.0)
+        angle += 360.0;
+    while (angle > 360.0)
+        angle -= 360.0;
+    return angle;
+}
+
+qreal distanceEntre(QPointF a, QPointF b)
+{
+    return sqrt((a.x() - b.x()) * (a.x() - b.x()) + (a.y() - b.y()) * (a.y() - b.y()));
+}
+
+// Vrai si le point, relatif à la voie, est sur le cercle de centre et de rayon donnés
+bool surCercle(QPointF point, QPointF centre, qreal rayon)
+{
+    qreal ecart = distanceEntre(point, centre) - rayon;
+    return ecart < 0.1 && ecart > -0.1;
+}
+
+// Parcours en ligne droite jusqu'à la liaison visée
+void parcourirDroit(qreal& dist, qreal& angle, qreal& rayon, qreal distanceLiaison)
+{
+    angle = 0.0;
+    rayon = 0.0;
+    if (distanceLiaison < dist)
+        dist -= distanceLiaison;
+    else
+        dist = 0.0;
+}
+
+// Parcours en courbe jusqu'à l'angle de la liaison visée. L'écart d'angle est ramené
+// entre -borne et borne ; pour une voie courbe et l'extérieur d'un aiguillage enroulé,
+// borne vaut deux fois l'angle de la voie et l'écart y est ramené par tours complets.
+void parcourirCourbe(qreal& dist, qreal& angle, qreal& rayon, qreal rayonCourbe,
+                     qreal angleLiaison, qreal angleCumule, qreal borne, bool toursComplets)
+{
+    rayon = rayonCourbe;
+
+    qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
+    qreal angleRestant = (angleLiaison + 360.0) - (angleCumule + 360.0);
+
+    while (angleRestant < -borne)
+        angleRestant += 360.0;
+    if (toursComplets)
+    {
+        while (angleRestant > borne)
+            angleRestant -= 360.0;
+    }
+    else if (angleRestant > borne)
+        angleRestant -= 360.0;
+
+    if (angleRestant < 0.0)
+    {
+        if (-angleRestant < angleAParcourir)
+        {
+            dist -= -angleRestant * (PI / 180.0) * rayon;
+            angle = angleRestant;
+        }
+        else
+        {
+            dist = 0.0;
+            angle = -angleAParcourir;
+        }
+    }
+    else
+    {
+        if (angleRestant < angleAParcourir)
+        {
+            dist -= angleRestant * (PI / 180.0) * rayon;
+            angle = angleRestant;
+        }
+        else
+        {
+            dist = 0.0;
+            angle = angleAParcourir;
+        }
+    }
+}
+
+// Une loco qui ne se rapproche plus de la liaison visée est passée à la voie suivante
+void verifierRapprochement(qreal& dist, qreal& derniereDistance, qreal distanceLiaison)
+{
+    if (derniereDistance > distanceLiaison)
+        derniereDistance = distanceLiaison;
+    else
+        dist = 0.1;
+    if (dist > 0.0)
+        derniereDistance = 1000.0;
+}
+
+// Projette un déplacement sur l'axe d'une voie droite
+void projeterSurAxe(const GeometrieVoie& g, qreal& x, qreal& y)
+{
+    QPointF p0(x, y);
+    QPointF p1 = g.extremite0;
+    QPointF p2 = g.extremite1;
+
+    qreal distP1P0 = distanceEntre(p1, p0);
+    qreal dx = p1.x() - p2.x();
+    qreal dy = p1.y() - p2.y();
+    qreal distP1P2 = sqrt(dx * dx + dy * dy);
+
+    qreal produit = (p0.x() - p1.x()) * (p2.x() - p1.x()) + (p0.y() - p1.y()) * (p2.y() - p1.y());
+    qreal cosP2P1P0 = produit / (distanceEntre(p0, p1) * distanceEntre(p2, p1));
+
+    // Déplacement nul ou confondu avec une extrémité : rien à corriger
+    if (isnan(cosP2P1P0))
+        return;
+
+    qreal rapport = distP1P0 * cosP2P1P0 / distP1P2;
+    x = -rapport * dx;
+    y = -rapport * dy;
+}
+
+} // namespace
+
+void ReseauVoies::vider()
+{
+    types.clear();
+    etats.clear();
+    voisines.clear();
+    nbresLiaisons.clear();
+    geometries.clear();
+    longueurs.clear();
+    contacts.clear();
+    aiguillages.clear();
+    vues.clear();
+    indices.clear();
+    voiesContacts.clear();
+}
+
+void ReseauVoies::construire(const QList<Voie *> &voies)
+{
+    vider();
+
+    int n = voies.size();
+    vues.reserve(n);
+    for (Voie* v : voies)
+    {
+        indices.insert(v, vues.size());
+        vues.append(v);
+    }
+
+    types.resize(n);
+    etats.resize(n);
+    contacts.fill(0, n);
+    aiguillages.fill(0, n);
+    voisines.fill(-1, n * MAX_LIAISONS);
+    nbresLiaisons.resize(n);
+    geometries.resize(n);
+    longueurs.resize(n * NB_ETATS_VOIE);
+
+    for (int i = 0; i < n; i++)
+    {
+        Voie* v = vues.at(i);
+        types[i] = v->getType();
+
+        VoieVariable* vv = qobject_cast<VoieVariable*>(v);
+        etats[i] = qBound(-1, vv != nullptr ? vv->getEtat() : DEVIE, 1);
+        if (vv != nullptr)
+            aiguillages[i] = vv->getNumVoieVariable();
+        if (v->getContact() != nullptr)
+        {
+            contacts[i] = v->getContact()->getNumContact();
+            voiesContacts.insert(contacts[i], i);
+        }
+
+        nbresLiaisons[i] = qMin(v->getNbreLiaisons(), MAX_LIAISONS);
+        for (int l = 0; l < nbresLiaisons.at(i); l++)
+            voisines[i * MAX_LIAISONS + l] = indice(v->getVoieVoisineDOrdre(l));
+        v->decrireGeometrie(geometries[i]);
+
+        for (int e = -1; e <= 1; e++)
+            longueurs[i * NB_ETATS_VOIE + e + 1] = v->getLongueurEtat(e);
+    }
+}
+
+void ReseauVoies::setEtat(Voie *v, int etat)
+{
+    int i = indice(v);
+    if (i >= 0)
+        etats[i] = qBound(-1, etat, 1);
+}
+
+int ReseauVoies::ordre(int i, int j) const
+{
+    // Comme Voie::getOrdreLiaison() : seules les liaisons existantes sont parcourues
+    for (int n = 0; n < nbresLiaisons.at(i); n++)
+    {
+        if (voisine(i, n) == j)
+            return n;
+    }
+    return 0;
+}
+
+int ReseauVoies::suivanteDansEtat(int i, int arrivee, int etat) const
+{
+    int o = ordre(i, arrivee);
+
+    // Mêmes règles que les méthodes getVoieSuivante() de chaque genre de voie
+    switch (types.at(i))
+    {
+    case TypeVoie::DROITE:
+    case TypeVoie::COURBE:
+        return voisine(i, (o + 1) % 2);
+
+    case TypeVoie::BUTTOIR:
+        return -1;
+
+    case TypeVoie::AIGUILLAGE:
+    case TypeVoie::AIGUILLAGE_ENROULE:
+    case TypeVoie::AIGUILLAGE_TRIPLE:
+        if (o != 0)
+            return voisine(i, 0);
+        return voisine(i, etat == TOUT_DROIT ? 1 : 2);
+
+    case TypeVoie::CROISEMENT:
+        return voisine(i, o ^ 1);
+
+    case TypeVoie::TRAVERSEE_JONCTION:
+        if (etat == TOUT_DROIT)
+            return voisine(i, o ^ 1);
+        return voisine(i, 3 - o);
+    }
+    return -1;
+}
+
+void ReseauVoies::parcourirVoie(MouvementLoco &m, qreal &dist, qreal &angle, qreal &rayon) const
+{
+    const GeometrieVoie& g = geometries.at(m.voie);
+    const int o = ordre(m.voie, m.suivante);
+    const qreal distanceLiaison = distanceEntre(m.position, g.liaisons[o]);
+    const QPointF relative = m.position - g.position;
+    const qreal ac = m.angleCumule;
+
+    // Parcours selon le genre de la voie
+    switch (types.at(m.voie))
+    {
+    case TypeVoie::DROITE:
+        // angle et rayon gardent les valeurs de la voie précédente
+        if (distanceLiaison < dist)
+            dist -= distanceLiaison;
+        else
+            dist = 0.0;
+        break;
+
+    case TypeVoie::COURBE:
+        parcourirCourbe(dist, angle, rayon, g.rayon, g.angles[o], ac, g.angle * 2.0, true);
+        break;
+
+    case TypeVoie::BUTTOIR:
+    {
+        angle = 0.0;
+        rayon = 0.0;
+        qreal distanceAuContact = distanceEntre(m.position, g.position);
+        if (distanceAuContact + LONGUEUR_LOCO / 2.0 > g.longueur)
+        {
+            //déclarer un deraillement.
+        }
+        else if (m.suivante < 0)
+            dist = 0.0;
+        else if (distanceAuContact < dist)
+            dist -= distanceAuContact;
+        else
+            dist = 0.0;
+        return;
+    }
+
+    case TypeVoie::AIGUILLAGE:
+        if (o == 0)
+        {
+            qreal ecart = normaliserAngle(ac - g.angles[1] - 180.0);
+            if (ecart < 1.0 && ecart > -1.0)
+                parcourirDroit(dist, angle, rayon, distanceLiaison);
+            else
+                parcourirCourbe(dist, angle, rayon, g.rayon, g.angles[0], ac, g.angle, false);
+        }
+        else if (etats.at(m.voie) == TOUT_DROIT)
+            parcourirDroit(dist, angle, rayon, distanceLiaison);
+        else
+            parcourirCourbe(dist, angle, rayon, g.rayon, g.angles[2], ac, g.angle, false);
+        break;
+
+    case TypeVoie::AIGUILLAGE_ENROULE:
+        if (o == 0)
+        {
+            if (surCercle(relative, g.centre, g.rayon))
+                parcourirCourbe(dist, angle, rayon, g.rayon, g.angles[0], ac, g.angle, false);
+            else if (distanceEntre(relative, QPointF()) < g.longueur)
+                parcourirDroit(dist, angle, rayon, distanceLiaison);
+            else
+                parcourirCourbe(dist, angle, rayon, g.rayon2, g.angles[o], ac, g.angle * 2.0, true);
+        }
+        else if (etats.at(m.voie) == TOUT_DROIT)
+        {
+            // La partie droite précède la courbe extérieure
+            if (distanceEntre(relative, QPointF()) < g.longueur)
+                parcourirDroit(dist, angle, rayon, distanceLiaison - g.longueur);
+            else
+                parcourirCourbe(dist, angle, rayon, g.rayon2, g.angles[o], ac, g.angle * 2.0, true);
+        }
+        else
+            parcourirCourbe(dist, angle, rayon, g.rayon, g.angles[2], ac, g.angle, false);
+        break;
+
+    case TypeVoie::AIGUILLAGE_TRIPLE:
+    {
+        qreal rayonCourbe = surCercle(relative, g.centre, g.rayon) ? g.rayon : g.rayon2;
+        if (o == 0)
+        {
+            if (ac == normaliserAngle(g.angles[1] - 180.0))
+                parcourirDroit(dist, angle, rayon, distanceLiaison);
+            else
+                parcourirCourbe(dist, angle, rayon, rayonCourbe, g.angles[0], ac, g.angle, false);
+        }
+        else if (etats.at(m.voie) == TOUT_DROIT)
+            parcourirDroit(dist, angle, rayon, distanceLiaison);
+        else
+            parcourirCourbe(dist, angle, rayon, rayonCourbe, g.angles[o], ac, g.angle, false);
+        break;
+    }
+
+    case TypeVoie::CROISEMENT:
+        parcourirDroit(dist, angle, rayon, distanceLiaison);
+        break;
+
+    case TypeVoie::TRAVERSEE_JONCTION:
+        if (etats.at(m.voie) == TOUT_DROIT)
+            parcourirDroit(dist, angle, rayon, distanceLiaison);
+        else
+        {
+            qreal rayonCourbe = surCercle(relative, g.centre, g.rayon) ? g.rayon : g.rayon2;
+            parcourirCourbe(dist, angle, rayon, rayonCourbe, g.angles[o], ac, g.angle, false);
+        }
+        break;
+    }
+
+    verifierRapprochement(dist, m.distanceLiaison, distanceLiaison);
+}
+
+void ReseauVoies::avancerDroit(MouvementLoco &m, qreal distance) const
+{
+    qreal x =  distance * cos(m.angleCumule * (PI / 180.0));
+    qreal y = -distance * sin(m.angleCumule * (PI / 180.0));
+    if (types.at(m.voie) == TypeVoie::DROITE)
+        projeterSurAxe(geometries.at(m.voie), x, y);
+    m.position += QPointF(x, y);
+}
+
+void ReseauVoies::passerVoieSuivante(MouvementLoco &m, qreal fraction) const
+{
+    int viensDe = m.voie;
+    m.voie = m.suivante;
+    m.suivante = suivante(m.voie, viensDe);
+
+    const GeometrieVoie& g = geometries.at(m.voie);
+    int o = ordre(m.voie, viensDe);
+    m.position = g.liaisons[o];
+    m.parcouruSurVoie = 0.0;
+
+    // La loco prend la direction de la liaison par laquelle elle entre sur la voie
+    qreal nouvelAngle = normaliserAngle(g.angles[o] + 180.0);
+    QPointF avant = (QTransform().rotate(m.rotation) *
+                     QTransform::fromTranslate(m.position.x(), m.position.y()))
+                        .map(QPointF(LONGUEUR_LOCO / 2.0, 0.0));
+    qreal angleReel = atan2(-avant.y() + m.position.y(), avant.x() - m.position.x()) * 180.0 / PI;
+    m.rotation += angleReel;
+    m.rotation -= nouvelAngle;
+    m.angleCumule = nouvelAngle;
+
+    if (contacts.at(m.voie) == 0)
+        return;
+
+    // Prochaine voie à contact devant la loco. Au-delà d'un passage par liaison de
+    // chaque voie, le parcours tourne en rond sans rencontrer de contact.
+    int voieContactSuivant = -1;
+    int precedente = m.voie;
+    int v = m.suivante;
+    for (int n = 0; v >= 0 && n < vues.size() * MAX_LIAISONS; n++)
+    {
+        if (contacts.at(v) != 0)
+        {
+            voieContactSuivant = v;
+            break;
+        }
+        int s = suivante(v, precedente);
+        precedente = v;
+        v = s;
+    }
+    m.franchies.append(VoieFranchie{m.voie, m.suivante, voieContactSuivant, fraction});
+}
+
+void ReseauVoies::avancerLoco(MouvementLoco &m) const
+{
+    const qreal distance = m.distance;
+    qreal dist = distance;
+    qreal angle = 0.0;
+    qreal rayon = 0.0;
+    qreal restant = distance;
+
+    m.franchies.clear();
+
+    while (true)
+    {
+        parcourirVoie(m, dist, angle, rayon);
+        m.parcouruSurVoie += restant - dist;
+        restant = dist;
+
+        if (rayon == 0.0)
+            avancerDroit(m, distance - dist);
+        else
+        {
+            // Virage : demi-corde, rotation, demi-corde
+            qreal demiCorde = rayon * tan(qAbs(angle) * PI / 360.0);
+            avancerDroit(m, demiCorde);
+            m.rotation -= angle;
+            avancerDroit(m, demiCorde);
+
+            m.angleCumule += angle;
+            if (m.angleCumule < 0.0)
+                m.angleCumule += 360.0;
+            if (m.angleCumule > 360.0)
+                m.angleCumule -= 360.0;
+        }
+
+        // Fin du parcours, ou fin de voie
+        if (dist == 0.0 || m.suivante < 0)
+            break;
+
+        // La loco quitte la voie après avoir parcouru distance - dist : les
+        // contacts de la voie suivante sont franchis à cette part du pas.
+        passerVoieSuivante(m, distance != 0.0 ? (distance - dist) / distance : 0.0);
+    }
+}
+
+int ReseauVoies::chercher(const QVector<int> &departs, int contactCible,
+                         QVector<int> &precedents, QVector<qint8> &etatsChoisis) const
+{
+    const int nbreEtats = vues.size() * MAX_LIAISONS;
+    QVector<qreal> distances(nbreEtats, std::numeric_limits<qreal>::infinity());
+    precedents.fill(-1, nbreEtats);
+    etatsChoisis.fill(DEVIE, nbreEtats);
+
+    typedef QPair<qreal, int> Candidat;
+    std::priority_queue<Candidat, std::vector<Candidat>, std::greater<Candidat> > file;
+    for (int s : departs)
+    {
+        distances[s] = 0.0;
+        file.push(Candidat(0.0, s));
+    }
+
+    while (!file.empty())
+    {
+        Candidat c = file.top();
+        file.pop();
+        int s = c.second;
+        if (c.first > distances.at(s))
+            continue;
+
+        int i = s / MAX_LIAISONS;
+        if (contacts.at(i) == contactCible && !departs.contains(s))
+            return s;
+
+        int arrivee = voisine(i, s % MAX_LIAISONS);
+        if (arrivee < 0)
+            continue;
+
+        // Une voie variable peut être traversée dans ses deux états, les autres
+        // dans leur seul état.
+        for (int etat = DEVIE; etat <= TOUT_DROIT; etat++)
+        {
+            if (aiguillages.at(i) == 0 && etat != etats.at(i))
+                continue;
+
+            int j = suivanteDansEtat(i, arrivee, etat);
+            if (j < 0)
+                continue;
+
+            int t = j * MAX_LIAISONS + ordre(j, i);
+            qreal d = c.first + longueurs.at(i * NB_ETATS_VOIE + etat + 1);
+            if (d < distances.at(t))
+            {
+                distances[t] = d;
+                precedents[t] = s;
+                etatsChoisis[t] = etat;
+                file.push(Candidat(d, t));
+            }
+        }
+    }
+    return -1;
+}
+
+bool ReseauVoies::itineraire(int precedent, int depart, int arrivee,
+                             QVector<int> &contactsFranchis, QVector<Aiguillage> &aiguillagesRequis) const
+{
+    contactsFranchis.clear();
+    aiguillagesRequis.clear();
+
+    if (!voiesContacts.contains(depart) || !voiesContacts.contains(arrivee))
+        return false;
+
+    QVector<int> precedents;
+    QVector<qint8> etatsChoisis;
+
+    // Sens de départ : celui dans lequel on arrive au départ depuis le contact précédent
+    int voieDepart = voiesContacts.value(depart);
+    QVector<int> departs;
+    if (voiesContacts.contains(precedent))
+    {
+        int voiePrecedent = voiesContacts.value(precedent);
+        int s = chercher({voiePrecedent * MAX_LIAISONS, voiePrecedent * MAX_LIAISONS + 1},
+                         depart, precedents, etatsChoisis);
+        if (s < 0)
+            return false;
+        departs.append(s);
+    }
+    else
+    {
+        departs.append(voieDepart * MAX_LIAISONS);
+        departs.append(voieDepart * MAX_LIAISONS + 1);
+    }
+
+    int s = chercher(departs, arrivee, precedents, etatsChoisis);
+    if (s < 0)
+        return false;
+
+    // Remontée du chemin, de l'arrivée vers le départ
+    QHash<int, int> directions;
+    for (; s >= 0; s = precedents.at(s))
+    {
+        int i = s / MAX_LIAISONS;
+        if (contacts.at(i) != 0)
+            contactsFranchis.prepend(contacts.at(i));
+
+        int p = precedents.at(s);
+        if (p < 0)
+            break;
+
+        // L'aiguillage quitté n'est à positionner que si ses deux états mènent
+        // à des voies différentes (pas pour un aiguillage pris en talon).
+        int v = p / MAX_LIAISONS;
+        int venantDe = voisine(v, p % MAX_LIAISONS);
+        if (aiguillages.at(v) != 0 &&
+            suivanteDansEtat(v, venantDe, DEVIE) != suivanteDansEtat(v, venantDe, TOUT_DROIT))
+        {
+            int numero = aiguillages.at(v);
+            int etat = etatsChoisis.at(s);
+            if (directions.contains(numero))
+            {
+                if (directions.value(numero) != etat)
+                    return false;
+                continue;
+            }
+            directions.insert(numero, etat);
+            aiguillagesRequis.prepend(Aiguillage(numero, etat));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,184 @@
+#ifndef RESEAUVOIES_H
+#define RESEAUVOIES_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVarLengthArray>
+#include <QVector>
+
+#include "voie.h"
+
+//! Voie à contact atteinte par une loco pendant un pas.
+struct VoieFranchie
+{
+    int voie;               //!< indice de la voie atteinte, qui porte un contact
+    int suivante;           //!< indice de la voie suivante à ce moment, -1 s'il n'y en a pas
+    int voieContactSuivant; //!< indice de la prochaine voie à contact, -1 s'il n'y en a pas
+    qreal fraction;         //!< fraction du pas écoulée au franchissement
+};
+
+/** Etat d'une loco nécessaire à son déplacement, détaché de l'élément graphique :
+  * ReseauVoies::avancerLoco() le fait évoluer sans toucher à la scène, et
+  * Loco::appliquerMouvement() reporte ensuite le résultat sur la loco.
+  */
+struct MouvementLoco
+{
+    QPointF position;           //!< position de la loco dans la scène
+    qreal rotation{0.0};        //!< rotation de l'élément graphique, en degrés
+    qreal angleCumule{0.0};     //!< direction de la loco, en degrés
+    int voie{-1};               //!< indice de la voie parcourue
+    int suivante{-1};           //!< indice de la voie vers laquelle se dirige la loco
+    qreal parcouruSurVoie{0.0}; //!< distance parcourue sur la voie
+    qreal distanceLiaison{1000.0}; //!< dernière distance à la liaison visée
+    qreal distance{0.0};        //!< distance à parcourir pendant le pas
+    QVarLengthArray<VoieFranchie, 4> franchies; //!< voies à contact atteintes
+};
+
+/** Copie compacte du réseau de voies, pour les parcours effectués à chaque pas de
+  * simulation. Les voies sont désignées par leur indice, et leurs données sont rangées
+  * dans des tableaux (genre, état, voisines, longueurs), sans appel virtuel ni
+  * recherche dans un QMap. Les voies graphiques restent chargées de l'affichage ; le
+  * déplacement des locomotives se fait ici, sur la géométrie relevée des voies.
+  */
+class ReseauVoies
+{
+public:
+    //! Nombre maximal de liaisons d'une voie.
+    static const int MAX_LIAISONS = MAX_LIAISONS_VOIE;
+
+    /** Construit le réseau. A appeler une fois les voies posées et précalculées.
+      * \param voies toutes les voies de la maquette.
+      */
+    void construire(const QList<Voie*>& voies);
+
+    /** vide le réseau.
+      */
+    void vider();
+
+    /** retourne l'indice d'une voie.
+      * \param v la voie.
+      * \return l'indice de la voie, -1 si elle n'appartient pas au réseau.
+      */
+    int indice(Voie* v) const { return indices.value(v, -1); }
+
+    /** retourne la voie d'indice donné.
+      */
+    Voie* voie(int i) const { return vues.at(i); }
+
+    /** met à jour l'état d'une voie variable.
+      * \param v la voie variable modifiée.
+      * \param etat son nouvel état.
+      */
+    void setEtat(Voie* v, int etat);
+
+    /** retourne la longueur à parcourir sur une voie, dans son état actuel.
+      * \param i l'indice de la voie.
+      */
+    qreal longueur(int i) const { return longueurs.at(i * NB_ETATS_VOIE + etats.at(i) + 1); }
+
+    /** équivalent de Voie::getVoieSuivante(), par indices.
+      * \param i l'indice de la voie parcourue.
+      * \param arrivee l'indice de la voie d'où vient la locomotive.
+      * \return l'indice de la voie suivante, -1 s'il n'y en a pas.
+      */
+    int suivante(int i, int arrivee) const { return suivanteDansEtat(i, arrivee, etats.at(i)); }
+
+    /** équivalent de suivante(), l'état de la voie étant imposé.
+      */
+    int suivanteDansEtat(int i, int arrivee, int etat) const;
+
+    /** retourne la longueur à parcourir sur une voie dans un état donné.
+      */
+    qreal longueurEtat(int i, int etat) const { return longueurs.at(i * NB_ETATS_VOIE + etat + 1); }
+
+    /** retourne l'état actuel d'une voie.
+      */
+    int etat(int i) const { return etats.at(i); }
+
+    /** retourne le numéro du contact porté par une voie, 0 si elle n'en porte pas.
+      */
+    int numeroContact(int i) const { return contacts.at(i); }
+
+    /** retourne le numéro de la voie variable d'indice donné, 0 pour les autres voies.
+      */
+    int numeroAiguillage(int i) const { return aiguillages.at(i); }
+
+    /** retourne le nombre de voies du réseau.
+      */
+    int nbreVoies() const { return vues.size(); }
+
+    /** fait avancer une loco de la distance prévue pour le pas, en passant d'une voie à
+      * l'autre. Ne lit que le réseau et ne modifie que le mouvement : plusieurs locos
+      * peuvent avancer en même temps, dans des threads différents.
+      * \param m le mouvement de la loco, mis à jour.
+      */
+    void avancerLoco(MouvementLoco& m) const;
+
+    //! Aiguillage à positionner : numéro et direction (DEVIE ou TOUT_DROIT).
+    typedef QPair<int, int> Aiguillage;
+
+    /** calcule l'itinéraire le plus court entre deux contacts, quel que soit l'état
+      * actuel des aiguillages.
+      * \param precedent le contact à l'arrière de la loco, qui fixe le sens de départ ;
+      * 0 pour partir dans n'importe quel sens.
+      * \param depart le contact de départ.
+      * \param arrivee le contact d'arrivée.
+      * \param contactsFranchis reçoit les contacts franchis, départ et arrivée compris.
+      * \param aiguillagesRequis reçoit les aiguillages à positionner, dans l'ordre de passage.
+      * \return vrai si un itinéraire existe.
+      */
+    bool itineraire(int precedent, int depart, int arrivee,
+                    QVector<int>& contactsFranchis, QVector<Aiguillage>& aiguillagesRequis) const;
+
+private:
+    /** recherche le plus court chemin (Dijkstra) sur les états (voie, liaison d'arrivée),
+      * depuis les états de départ jusqu'à la voie portant le contact cible.
+      * \param departs les états de départ, numérotés voie * MAX_LIAISONS + liaison.
+      * \param precedents reçoit, pour chaque état atteint, l'état d'où il a été atteint.
+      * \param etatsChoisis reçoit, pour chaque état atteint, l'état de la voie quittée.
+      * \return l'état atteint sur la voie du contact cible, -1 si elle est inaccessible.
+      */
+    int chercher(const QVector<int>& departs, int contactCible,
+                 QVector<int>& precedents, QVector<qint8>& etatsChoisis) const;
+
+    /** retourne l'ordre de la liaison de la voie i vers la voie j (0 si elles ne sont pas liées).
+      */
+    int ordre(int i, int j) const;
+
+    /** retourne l'indice de la voisine d'ordre n de la voie i, -1 s'il n'y en a pas.
+      */
+    int voisine(int i, int n) const { return voisines.at(i * MAX_LIAISONS + n); }
+
+    /** calcule le parcours possible sur la voie actuelle de la loco, vers sa voie
+      * suivante, selon le genre de la voie.
+      * \param m le mouvement de la loco ; seule sa distance à la liaison visée est modifiée.
+      * \param dist la distance à parcourir, diminuée de la distance possible sur la voie.
+      * \param angle l'angle de rotation du parcours.
+      * \param rayon le rayon de rotation du parcours, 0 en ligne droite.
+      */
+    void parcourirVoie(MouvementLoco& m, qreal& dist, qreal& angle, qreal& rayon) const;
+
+    /** déplace la loco en ligne droite dans sa direction actuelle.
+      */
+    void avancerDroit(MouvementLoco& m, qreal distance) const;
+
+    /** fait passer la loco sur sa voie suivante, et relève le contact éventuel.
+      * \param fraction la fraction du pas écoulée au passage.
+      */
+    void passerVoieSuivante(MouvementLoco& m, qreal fraction) const;
+
+    QVector<TypeVoie> types;
+    QVector<qint8> etats;
+    QVector<int> voisines;      //!< MAX_LIAISONS voisines par voie, -1 si absente
+    QVector<int> nbresLiaisons;
+    QVector<GeometrieVoie> geometries;
+    QVector<qreal> longueurs;   //!< NB_ETATS_VOIE longueurs par voie
+    QVector<int> contacts;      //!< numéro du contact de chaque voie, 0 si aucun
+    QVector<int> aiguillages;   //!< numéro de chaque voie variable, 0 pour les autres
+    QVector<Voie*> vues;
+    QHash<Voie*, int> indices;
+    QHash<int, int> voiesContacts;  //!< voie portant chaque contact
+};
+
+#endif // RESEAUVOIES_H
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <limits>
+
+#include "routeur.h"
+
+static const qreal INFINI = std::numeric_limits<qreal>::infinity();
+
+void GrapheTroncons::vider()
+{
+    noeuds.clear();
+    contactsNoeuds.clear();
+    arcs.clear();
+    arcsSortants.clear();
+    arcsEntrants.clear();
+    arcsVoies.clear();
+}
+
+void GrapheTroncons::construire(const ReseauVoies &reseau, const QList<Segment *> &segments)
+{
+    vider();
+    arcsVoies.resize(reseau.nbreVoies());
+
+    QVector<int> chemin;
+    for (int s = 0; s < segments.size(); s++)
+    {
+        Segment* segment = segments.at(s);
+        chemin.resize(segment->getNbreVoies());
+        for (int i = 0; i < chemin.size(); i++)
+            chemin[i] = reseau.indice(segment->getVoie(i));
+
+        // Les segments se terminant sur un buttoir ne mènent à aucun contact
+        if (chemin.size() < 2 || chemin.contains(-1) || reseau.numeroContact(chemin.last()) == 0)
+            continue;
+
+        ajouterArc(reseau, chemin, s);
+        std::reverse(chemin.begin(), chemin.end());
+        ajouterArc(reseau, chemin, s);
+    }
+}
+
+int GrapheTroncons::creerNoeud(const ReseauVoies &reseau, int voieContact, int voieSuivante)
+{
+    QPair<int, int> cle(voieContact, voieSuivante);
+    if (noeuds.contains(cle))
+        return noeuds.value(cle);
+
+    int n = contactsNoeuds.size();
+    noeuds.insert(cle, n);
+    contactsNoeuds.append(reseau.numeroContact(voieContact));
+    arcsSortants.append(QVector<int>());
+    arcsEntrants.append(QVector<int>());
+    return n;
+}
+
+void GrapheTroncons::ajouterArc(const ReseauVoies &reseau, const QVector<int> &chemin, int segment)
+{
+    const int fin = chemin.size() - 1;
+
+    // En arrivant sur le dernier contact, la loco continue vers la voie suivante
+    int apres = reseau.suivante(chemin.at(fin), chemin.at(fin - 1));
+    if (apres < 0)
+        return;
+
+    Arc arc;
+    arc.origine = creerNoeud(reseau, chemin.first(), chemin.at(1));
+    arc.destination = creerNoeud(reseau, chemin.at(fin), apres);
+    arc.segment = segment;
+    arc.longueur = 0.0;
+
+    for (int i = 1; i <= fin; i++)
+    {
+        int v = chemin.at(i);
+        int etat = reseau.etat(v);
+
+        if (i < fin)
+        {
+            arc.voies.append(v);
+
+            // Etat qui mène à la voie suivante du segment ; l'aiguillage n'est à
+            // positionner que si ses deux états mènent à des voies différentes.
+            int venantDe = chemin.at(i - 1);
+            if (reseau.numeroAiguillage(v) != 0)
+            {
+                for (int e = DEVIE; e <= TOUT_DROIT; e++)
+                {
+                    if (reseau.suivanteDansEtat(v, venantDe, e) == chemin.at(i + 1))
+                        etat = e;
+                }
+                if (reseau.suivanteDansEtat(v, venantDe, DEVIE) != reseau.suivanteDansEtat(v, venantDe, TOUT_DROIT))
+                    arc.aiguillages.append(ReseauVoies::Aiguillage(reseau.numeroAiguillage(v), etat));
+            }
+        }
+        arc.longueur += reseau.longueurEtat(v, etat);
+    }
+
+    int a = arcs.size();
+    arcs.append(arc);
+    arcsSortants[arc.origine].append(a);
+    arcsEntrants[arc.destination].append(a);
+    for (int v : arc.voies)
+        arcsVoies[v].append(a);
+}
+
+Routeur::Routeur(const GrapheTroncons *graphe, const QVector<int> *occupation)
+    : graphe(graphe), occupation(occupation)
+{
+}
+
+void Routeur::setDestination(int contact)
+{
+    destination = contact;
+
+    const int n = graphe->nbreNoeuds();
+    g.fill(INFINI, n);
+    rhs.fill(INFINI, n);
+    clesFile.fill(-1.0, n);
+    file.clear();
+    arcsModifies.clear();
+
+    couts.resize(graphe->nbreArcs());
+    for (int a = 0; a < couts.size(); a++)
+        couts[a] = cout(a);
+
+    // La recherche part de tous les noeuds du contact de destination
+    for (int i = 0; i < n && destination != 0; i++)
+    {
+        if (graphe->contact(i) == destination)
+        {
+            rhs[i] = 0.0;
+            clesFile[i] = 0.0;
+            file.insert(qMakePair(0.0, i));
+        }
+    }
+}
+
+void Routeur::setVoiesPropres(const QVector<int> &voies)
+{
+    voiesModifiees(propres);
+    propres = voies;
+    voiesModifiees(propres);
+}
+
+void Routeur::voiesModifiees(const QVector<int> &voies)
+{
+    if (destination == 0)
+        return;
+    for (int v : voies)
+        arcsModifies += graphe->arcsDeVoie(v);
+}
+
+qreal Routeur::cout(int a) const
+{
+    const GrapheTroncons::Arc& arc = graphe->arc(a);
+    for (int v : arc.voies)
+    {
+        if (occupation->at(v) > (propres.contains(v) ? 1 : 0))
+            return INFINI;
+    }
+    return arc.longueur;
+}
+
+void Routeur::majNoeud(int n)
+{
+    if (graphe->contact(n) != destination)
+    {
+        qreal meilleur = INFINI;
+        for (int a : graphe->sortants(n))
+            meilleur = qMin(meilleur, couts.at(a) + g.at(graphe->arc(a).destination));
+        rhs[n] = meilleur;
+    }
+
+    if (clesFile.at(n) >= 0.0)
+    {
+        file.erase(qMakePair(clesFile.at(n), n));
+        clesFile[n] = -1.0;
+    }
+    if (g.at(n) != rhs.at(n))
+    {
+        clesFile[n] = cle(n);
+        file.insert(qMakePair(clesFile.at(n), n));
+    }
+}
+
+void Routeur::calculer(int depart)
+{
+    while (!file.empty() && (file.begin()->first < cle(depart) || rhs.at(depart) != g.at(depart)))
+    {
+        int n = file.begin()->second;
+        file.erase(file.begin());
+        clesFile[n] = -1.0;
+
+        if (g.at(n) > rhs.at(n))
+        {
+            g[n] = rhs.at(n);
+        }
+        else
+        {
+            g[n] = INFINI;
+            majNoeud(n);
+        }
+        for (int a : graphe->entrants(n))
+            majNoeud(graphe->arc(a).origine);
+    }
+}
+
+int Routeur::prochainArc(int depart)
+{
+    if (destination == 0 || depart < 0 || graphe->contact(depart) == destination)
+        return -1;
+
+    // Seuls les arcs dont la longueur a changé remettent en cause la recherche
+    for (int a : arcsModifies)
+    {
+        qreal c = cout(a);
+        if (c != couts.at(a))
+        {
+            couts[a] = c;
+            majNoeud(graphe->arc(a).origine);
+        }
+    }
+    arcsModifies.clear();
+
+    calculer(depart);
+
+    int choisi = -1;
+    qreal meilleur = INFINI;
+    for (int a : graphe->sortants(depart))
+    {
+        qreal d = couts.at(a) + g.at(graphe->arc(a).destination);
+        if (d < meilleur)
+        {
+            meilleur = d;
+            choisi = a;
+        }
+    }
+    return choisi;
+}
@@ -0,0 +1,140 @@
+#ifndef ROUTEUR_H
+#define ROUTEUR_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <set>
+
+#include "reseauvoies.h"
+#include "segment.h"
+
+/** Graphe des tronçons de la maquette, construit à partir des segments.
+  * Un noeud est un contact pris dans un sens (la voie du contact et la voie vers
+  * laquelle la loco se dirige), un arc est un segment parcouru dans un sens, avec
+  * sa longueur et les aiguillages à positionner pour le suivre. Le graphe ne change
+  * plus une fois construit : il est partagé par les routeurs de toutes les locos.
+  */
+class GrapheTroncons
+{
+public:
+    //! Segment parcouru dans un sens.
+    struct Arc
+    {
+        int origine;
+        int destination;
+        int segment;                                 //!< indice du segment
+        qreal longueur;
+        QVector<int> voies;                          //!< voies intérieures, contacts exclus
+        QVector<ReseauVoies::Aiguillage> aiguillages;
+    };
+
+    /** Construit le graphe. A appeler une fois le réseau construit et les segments générés.
+      * \param reseau le réseau de voies.
+      * \param segments les segments de la maquette.
+      */
+    void construire(const ReseauVoies& reseau, const QList<Segment*>& segments);
+
+    /** vide le graphe.
+      */
+    void vider();
+
+    bool estVide() const { return arcs.isEmpty(); }
+
+    /** retourne le noeud d'une loco sur la voie d'un contact.
+      * \param voieContact l'indice de la voie du contact.
+      * \param voieSuivante l'indice de la voie vers laquelle se dirige la loco.
+      * \return le noeud, -1 si la voie ne porte pas de contact.
+      */
+    int noeud(int voieContact, int voieSuivante) const { return noeuds.value(qMakePair(voieContact, voieSuivante), -1); }
+
+    int nbreNoeuds() const { return contactsNoeuds.size(); }
+
+    int nbreArcs() const { return arcs.size(); }
+
+    //! numéro du contact d'un noeud.
+    int contact(int n) const { return contactsNoeuds.at(n); }
+
+    const Arc& arc(int a) const { return arcs.at(a); }
+
+    const QVector<int>& sortants(int n) const { return arcsSortants.at(n); }
+
+    const QVector<int>& entrants(int n) const { return arcsEntrants.at(n); }
+
+    /** retourne les arcs passant par une voie.
+      */
+    const QVector<int>& arcsDeVoie(int v) const { return arcsVoies.at(v); }
+
+private:
+    /** ajoute l'arc suivant les voies données, de la première à la dernière.
+      */
+    void ajouterArc(const ReseauVoies& reseau, const QVector<int>& chemin, int segment);
+
+    /** retourne le noeud (voieContact, voieSuivante), en le créant au besoin.
+      */
+    int creerNoeud(const ReseauVoies& reseau, int voieContact, int voieSuivante);
+
+    QHash<QPair<int, int>, int> noeuds;
+    QVector<int> contactsNoeuds;
+    QVector<Arc> arcs;
+    QVector<QVector<int> > arcsSortants;
+    QVector<QVector<int> > arcsEntrants;
+    QVector<QVector<int> > arcsVoies;
+};
+
+/** Recherche incrémentale du plus court chemin vers une destination, pour une loco
+  * (D* Lite, sans heuristique). La recherche part de la destination : quand la loco
+  * avance ou quand l'occupation des voies change, seuls les noeuds dont la distance
+  * est affectée sont recalculés, au lieu de refaire toute la recherche à chaque contact.
+  * Un arc dont une voie est occupée par une autre loco a une longueur infinie.
+  */
+class Routeur
+{
+public:
+    /** Constructeur de classe
+      * \param graphe le graphe des tronçons, qui doit survivre au routeur.
+      * \param occupation le nombre de locos sur chaque voie, tenu à jour par le simulateur.
+      */
+    Routeur(const GrapheTroncons* graphe, const QVector<int>* occupation);
+
+    /** fixe la destination et recommence la recherche.
+      * \param contact le numéro du contact à atteindre.
+      */
+    void setDestination(int contact);
+
+    int getDestination() const { return destination; }
+
+    /** indique les voies occupées par la loco elle-même, qui ne bloquent pas ses arcs.
+      */
+    void setVoiesPropres(const QVector<int>& voies);
+
+    /** signale un changement d'occupation des voies données.
+      */
+    void voiesModifiees(const QVector<int>& voies);
+
+    /** met à jour la recherche et choisit l'arc à suivre.
+      * \param depart le noeud où se trouve la loco.
+      * \return l'arc à suivre, -1 si la destination est atteinte ou inaccessible.
+      */
+    int prochainArc(int depart);
+
+private:
+    qreal cout(int a) const;
+    qreal cle(int n) const { return qMin(g.at(n), rhs.at(n)); }
+    void majNoeud(int n);
+    void calculer(int depart);
+
+    const GrapheTroncons* graphe;
+    const QVector<int>* occupation;
+    QVector<int> propres;
+    int destination{0};
+    QVector<qreal> g;
+    QVector<qreal> rhs;
+    QVector<qreal> couts;
+    QVector<qreal> clesFile;            //!< clé de chaque noeud dans la file, -1 s'il n'y est pas
+    std::set<QPair<qreal, int> > file;
+    QVector<int> arcsModifies;
+};
+
+#endif // ROUTEUR_H
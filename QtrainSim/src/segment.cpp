@@ -1,30 +1,42 @@
 #include "segment.h"
 
-Segment::Segment(Contact *c1, Contact *c2, QList<Voie *> lv, QObject *parent) :
+Segment::Segment(Contact *c1, Contact *c2, const QVector<Voie *> *voies, int debut, int nbreVoies, QObject *parent) :
     QObject(parent)
 {
     this->contact1 = c1;
     this->contact2 = c2;
-    this->voies = lv;
+    this->voies = voies;
+    this->debut = debut;
+    this->nbreVoies = nbreVoies;
 }
 
-Voie* Segment::getMilieu()
+int Segment::getNbreVoies() const
+{
+    return nbreVoies;
+}
+
+Voie* Segment::getVoie(int i) const
+{
+    return voies->at(debut + i);
+}
+
+int Segment::getIndiceMilieu() const
 {
-    int indiceMilieu = this->voies.length() / 2;
+    int indiceMilieu = nbreVoies / 2;
     int delta = 1;
 
     while(true)
     {
-        if(voies.at(indiceMilieu)->getNbreLiaisons() == 2)
+        if(getVoie(indiceMilieu)->getNbreLiaisons() == 2)
         {
-            return voies.at(indiceMilieu);
+            return indiceMilieu;
         }
         else
         {
             indiceMilieu += delta;
 
-            if(indiceMilieu < 0 || indiceMilieu >= voies.length())
-                return nullptr;
+            if(indiceMilieu < 0 || indiceMilieu >= nbreVoies)
+                return -1;
 
             delta *= -1;
             if(delta < 0)
@@ -35,18 +47,25 @@ Voie* Segment::getMilieu()
     }
 }
 
+Voie* Segment::getMilieu()
+{
+    int indiceMilieu = getIndiceMilieu();
+
+    return indiceMilieu < 0 ? nullptr : getVoie(indiceMilieu);
+}
+
 Voie* Segment::getSuivantMilieu()
 {
-    int indiceMilieu = voies.indexOf(getMilieu());
+    int indiceMilieu = getIndiceMilieu();
 
-    return voies.at(indiceMilieu +1); //pas de garde fou! probablement un peu risque...
+    return getVoie(indiceMilieu +1); //pas de garde fou! probablement un peu risque...
 }
 
 Voie* Segment::getPrecedentMilieu()
 {
-    int indiceMilieu = voies.indexOf(getMilieu());
+    int indiceMilieu = getIndiceMilieu();
 
-    return voies.at(indiceMilieu -1); //pas de garde fou! probablement un peu risque...
+    return getVoie(indiceMilieu -1); //pas de garde fou! probablement un peu risque...
 }
 
 bool Segment::relie(Contact *c1, Contact *c2)
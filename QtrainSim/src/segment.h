@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QVector>
 
 #include "contact.h"
 #include "voie.h"
@@ -14,9 +15,11 @@ public:
     /** Constructeur de classe
       * \param c1 le premier contact du segment
       * \param c2 le second contact du segment
-      * \param lv la liste des voies du segment
+      * \param voies le tableau contenant les voies de tous les segments de la maquette
+      * \param debut l'indice de la première voie du segment dans le tableau
+      * \param nbreVoies le nombre de voies du segment
       */
-    explicit Segment(Contact* c1, Contact* c2, QList<Voie*> lv, QObject *parent = 0);
+    explicit Segment(Contact* c1, Contact* c2, const QVector<Voie*>* voies, int debut, int nbreVoies, QObject *parent = 0);
 
     /** retourne la voie droite ou courbe la plus au milieu du segment.
       * \return la voie droite ou courbe la plus au milieu du segment.
@@ -39,6 +42,23 @@ public:
       * \return vrai si le segment relie c1 et c2, faux sinon.
       */
     bool relie(Contact* c1, Contact* c2);
+
+    /** retourne le nombre de voies du segment.
+      * \return le nombre de voies du segment.
+      */
+    int getNbreVoies() const;
+
+    /** retourne une voie du segment, dans l'ordre du premier au second contact.
+      * \param i l'indice de la voie dans le segment.
+      * \return la voie d'indice i.
+      */
+    Voie* getVoie(int i) const;
+
+    /** retourne les contacts du segment.
+      * \return le premier, respectivement le second contact du segment.
+      */
+    Contact* getContact1() const { return contact1; }
+    Contact* getContact2() const { return contact2; }
 signals:
 
 public slots:
@@ -46,7 +66,14 @@ public slots:
 private:
     Contact* contact1;
     Contact* contact2;
-    QList<Voie*> voies;
+    const QVector<Voie*>* voies;
+    int debut;
+    int nbreVoies;
+
+    /** retourne l'indice dans le segment de la voie droite ou courbe la plus au milieu.
+      * \return l'indice de la voie, -1 s'il n'y en a pas.
+      */
+    int getIndiceMilieu() const;
 };
 
 #endif // SEGMENT_H
@@ -0,0 +1,289 @@
+#include <iostream>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include "simtrace.h"
+
+//! En-tête des fichiers de trace.
+#define MAGIC_TRACE 0x54525451 // "QTRT"
+#define VERSION_TRACE 1
+
+//! Temps sans progression du rejeu au-delà duquel on considère qu'il a divergé.
+#define DELAI_DIVERGENCE_MS 10000
+
+bool EvenementTrace::correspond(const EvenementTrace &autre) const
+{
+    return type == autre.type && numero == autre.numero &&
+           a == autre.a && b == autre.b && c == autre.c;
+}
+
+QString EvenementTrace::description() const
+{
+    switch (type)
+    {
+    case ATTENTE_CONTACT:     return QString("attendre_contact(%1)").arg(numero);
+    case ACTIVATION_CONTACT:  return QString("activation du contact %1").arg(numero);
+    case AIGUILLAGE:          return QString("diriger_aiguillage(%1, %2)").arg(numero).arg(a);
+    case VITESSE:             return QString("mettre_vitesse_loco(%1, %2)").arg(numero).arg(a);
+    case VITESSE_PROGRESSIVE: return QString("mettre_vitesse_progressive(%1, %2)").arg(numero).arg(a);
+    case ARRET:               return QString("arreter_loco(%1)").arg(numero);
+    case INVERSION:           return QString("inverser_sens_loco(%1)").arg(numero);
+    case ASSIGNATION:         return QString("assigner_loco(%1, %2, %3, %4)").arg(a).arg(b).arg(numero).arg(c);
+    case ITINERAIRE:          return QString("calculer_itineraire(%1, %2, %3)").arg(b).arg(numero).arg(a);
+    case ITINERAIRE_CONTACT:  return QString("contact %1 de l'itinéraire").arg(numero);
+    case ITINERAIRE_AIGUILLAGE: return QString("aiguillage %1 de l'itinéraire, direction %2").arg(numero).arg(a);
+    case DESTINATION:         return QString("diriger_loco_vers(%1, %2)").arg(numero).arg(a);
+    case VITESSE_CONTACT:     return QString("mettre_vitesse_au_contact(%1, %2, %3)").arg(numero).arg(a).arg(b);
+    }
+    return QString("événement inconnu (%1)").arg(type);
+}
+
+TraceEnregistreur::~TraceEnregistreur()
+{
+    arreter();
+}
+
+bool TraceEnregistreur::demarrer(const QString &nomFichier)
+{
+    QMutexLocker verrou(&mutex);
+
+    fichier.setFileName(nomFichier);
+    if (!fichier.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    flux.setDevice(&fichier);
+    flux.setByteOrder(QDataStream::LittleEndian);
+    flux << quint32(MAGIC_TRACE) << quint16(VERSION_TRACE);
+    actif = true;
+    return true;
+}
+
+void TraceEnregistreur::arreter()
+{
+    QMutexLocker verrou(&mutex);
+
+    if (!actif)
+        return;
+    actif = false;
+    flux.setDevice(nullptr);
+    fichier.close();
+}
+
+void TraceEnregistreur::enregistrer(quint32 temps, quint8 type, int numero, int a, int b, int c)
+{
+    QMutexLocker verrou(&mutex);
+
+    if (!actif)
+        return;
+    flux << temps << type << quint8(numero) << qint16(a) << qint16(b) << qint16(c);
+}
+
+void TraceEnregistreur::enregistrer(quint32 temps, const QVector<EvenementTrace> &evenements)
+{
+    QMutexLocker verrou(&mutex);
+
+    if (!actif)
+        return;
+    for (const EvenementTrace& e : evenements)
+        flux << temps << e.type << e.numero << e.a << e.b << e.c;
+}
+
+TraceRejoueur::TraceRejoueur()
+{
+    for (int i = 0; i <= MAX_CONTACTS; i++)
+        activations[i] = 0;
+}
+
+bool TraceRejoueur::charger(const QString &nomFichier)
+{
+    QFile fichier(nomFichier);
+    if (!fichier.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream lecture(&fichier);
+    lecture.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic;
+    quint16 version;
+    lecture >> magic >> version;
+    if (magic != MAGIC_TRACE || version != VERSION_TRACE)
+        return false;
+
+    evenements.clear();
+    while (!lecture.atEnd())
+    {
+        EvenementTrace e;
+        lecture >> e.temps >> e.type >> e.numero >> e.a >> e.b >> e.c;
+        if (lecture.status() != QDataStream::Ok)
+            return false;
+        evenements.append(e);
+    }
+    return true;
+}
+
+bool TraceRejoueur::attendreTour(const EvenementTrace &e)
+{
+    while (!termine)
+    {
+        if (curseur < evenements.size() && evenements.at(curseur).correspond(e))
+        {
+            curseur++;
+            changement.wakeAll();
+            return true;
+        }
+        if (!changement.wait(&mutex, DELAI_DIVERGENCE_MS))
+        {
+            signalerDivergence(e.description());
+        }
+    }
+    return false;
+}
+
+void TraceRejoueur::signalerDivergence(const QString &recu)
+{
+    if (termine)
+        return;
+
+    std::cout << "Divergence du rejeu à l'événement " << curseur << " : attendu ";
+    if (curseur < evenements.size())
+        std::cout << qPrintable(evenements.at(curseur).description());
+    else
+        std::cout << "fin de trace";
+    std::cout << ", reçu " << qPrintable(recu) << std::endl;
+
+    divergence = true;
+    termine = true;
+    changement.wakeAll();
+}
+
+void TraceRejoueur::commande(quint8 type, int numero, int a, int b, int c)
+{
+    QMutexLocker verrou(&mutex);
+
+    EvenementTrace e{0, type, quint8(numero), qint16(a), qint16(b), qint16(c)};
+    attendreTour(e);
+}
+
+void TraceRejoueur::attendreContact(int numero)
+{
+    QMutexLocker verrou(&mutex);
+
+    if (numero < 0 || numero > MAX_CONTACTS)
+        return;
+
+    EvenementTrace e{0, EvenementTrace::ATTENTE_CONTACT, quint8(numero), 0, 0, 0};
+    attendreTour(e);
+
+    // Une fois la trace terminée, le thread de contrôle reste bloqué ici jusqu'à interrompre().
+    quint64 vu = activations[numero];
+    while (activations[numero] == vu && !interrompu)
+        changement.wait(&mutex);
+}
+
+void TraceRejoueur::attendreContactAsync(int numero, void (*rappel)(int, void *), void *donnees)
+{
+    QMutexLocker verrou(&mutex);
+
+    if (numero < 0 || numero > MAX_CONTACTS)
+        return;
+
+    EvenementTrace e{0, EvenementTrace::ATTENTE_CONTACT, quint8(numero), 0, 0, 0};
+    if (attendreTour(e))
+        rappels[numero].append(qMakePair(rappel, donnees));
+}
+
+bool TraceRejoueur::itineraire(int precedent, int depart, int arrivee,
+                               QVector<int> &contacts, QVector<QPair<int, int> > &aiguillages)
+{
+    QMutexLocker verrou(&mutex);
+
+    contacts.clear();
+    aiguillages.clear();
+
+    EvenementTrace e{0, EvenementTrace::ITINERAIRE, quint8(depart), qint16(arrivee), qint16(precedent), 0};
+    if (!attendreTour(e))
+        return false;
+
+    // Le résultat suit l'appel dans la trace, d'un seul tenant
+    while (curseur < evenements.size())
+    {
+        const EvenementTrace& r = evenements.at(curseur);
+        if (r.type == EvenementTrace::ITINERAIRE_CONTACT)
+            contacts.append(r.numero);
+        else if (r.type == EvenementTrace::ITINERAIRE_AIGUILLAGE)
+            aiguillages.append(qMakePair(int(r.numero), int(r.a)));
+        else
+            break;
+        curseur++;
+    }
+    changement.wakeAll();
+    return !contacts.isEmpty();
+}
+
+void TraceRejoueur::interrompre()
+{
+    QMutexLocker verrou(&mutex);
+
+    termine = true;
+    interrompu = true;
+    changement.wakeAll();
+}
+
+bool TraceRejoueur::aDiverge()
+{
+    QMutexLocker verrou(&mutex);
+
+    return divergence;
+}
+
+void TraceRejoueur::run()
+{
+    QElapsedTimer chrono;
+    chrono.start();
+
+    QMutexLocker verrou(&mutex);
+
+    while (!termine && curseur < evenements.size())
+    {
+        const EvenementTrace& e = evenements.at(curseur);
+        if (e.type == EvenementTrace::ACTIVATION_CONTACT)
+        {
+            int numero = e.numero;
+            curseur++;
+            changement.wakeAll();
+            if (numero <= MAX_CONTACTS)
+            {
+                activations[numero]++;
+
+                // Les rappels sont appelés sans le verrou : ils peuvent soumettre
+                // de nouvelles commandes.
+                QVector<QPair<void (*)(int, void *), void *> > aAppeler;
+                aAppeler.swap(rappels[numero]);
+                verrou.unlock();
+                for (const auto& rappel : aAppeler)
+                    rappel.first(numero, rappel.second);
+                verrou.relock();
+            }
+        }
+        else if (!changement.wait(&mutex, DELAI_DIVERGENCE_MS))
+        {
+            signalerDivergence("aucune commande");
+        }
+    }
+    termine = true;
+    changement.wakeAll();
+
+    quint32 tempsSimule = evenements.isEmpty() ? 0 : evenements.last().temps;
+    std::cout << "Rejeu " << (divergence ? "interrompu" : "terminé") << " : "
+              << curseur << "/" << evenements.size() << " événements en "
+              << chrono.elapsed() << " ms (temps simulé : " << tempsSimule << " ms)" << std::endl;
+
+    int code = divergence ? 1 : 0;
+    if (QCoreApplication::instance() != nullptr)
+    {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [code]() {
+            QCoreApplication::exit(code);
+        }, Qt::QueuedConnection);
+    }
+}
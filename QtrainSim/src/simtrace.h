@@ -0,0 +1,160 @@
+#ifndef SIMTRACE_H
+#define SIMTRACE_H
+
+#include <QString>
+#include <QFile>
+#include <QDataStream>
+#include <QVector>
+#include <QPair>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+
+#include "general.h"
+
+/** Evénement élémentaire d'une trace de simulation : une commande du programme
+  * de contrôle ou l'activation d'un contact, horodatée en temps simulé.
+  * Chaque événement occupe 12 octets dans le fichier de trace.
+  */
+struct EvenementTrace
+{
+    enum Type : quint8 {
+        ATTENTE_CONTACT = 1,   //!< attendre_contact(numero)
+        ACTIVATION_CONTACT,    //!< passage d'une loco sur le contact numero
+        AIGUILLAGE,            //!< diriger_aiguillage(numero, a)
+        VITESSE,               //!< mettre_vitesse_loco(numero, a)
+        VITESSE_PROGRESSIVE,   //!< mettre_vitesse_progressive(numero, a)
+        ARRET,                 //!< arreter_loco(numero)
+        INVERSION,             //!< inverser_sens_loco(numero)
+        ASSIGNATION,           //!< assigner_loco(a, b, numero, c)
+        ITINERAIRE,            //!< calculer_itineraire(b, numero, a), suivi de son résultat
+        ITINERAIRE_CONTACT,    //!< contact numero de l'itinéraire calculé
+        ITINERAIRE_AIGUILLAGE, //!< aiguillage numero à mettre dans la direction a
+        DESTINATION,           //!< diriger_loco_vers(numero, a)
+        VITESSE_CONTACT        //!< mettre_vitesse_au_contact(numero, a, b)
+    };
+
+    quint32 temps;  //!< temps simulé en millisecondes
+    quint8 type;
+    quint8 numero;  //!< numéro de loco, de contact ou d'aiguillage
+    qint16 a;
+    qint16 b;
+    qint16 c;
+
+    /** Compare deux événements, sans tenir compte de leur horodatage.
+      */
+    bool correspond(const EvenementTrace& autre) const;
+
+    /** retourne une description lisible de l'événement.
+      */
+    QString description() const;
+};
+
+/** Enregistre les commandes et les activations de contacts dans une trace binaire.
+  * Les méthodes peuvent être appelées depuis n'importe quel thread.
+  */
+class TraceEnregistreur
+{
+public:
+    ~TraceEnregistreur();
+
+    /** Ouvre le fichier de trace et commence l'enregistrement.
+      * \param nomFichier le fichier à créer.
+      * \return vrai si le fichier a pu être ouvert.
+      */
+    bool demarrer(const QString& nomFichier);
+
+    /** Termine l'enregistrement et ferme le fichier.
+      */
+    void arreter();
+
+    /** Ajoute un événement à la trace. Sans effet si l'enregistrement n'est pas actif.
+      */
+    void enregistrer(quint32 temps, quint8 type, int numero, int a = 0, int b = 0, int c = 0);
+
+    /** Ajoute plusieurs événements d'un seul tenant, sans que ceux d'autres threads
+      * puissent s'intercaler.
+      */
+    void enregistrer(quint32 temps, const QVector<EvenementTrace>& evenements);
+
+private:
+    QMutex mutex;
+    QFile fichier;
+    QDataStream flux;
+    bool actif{false};
+};
+
+/** Rejoue une trace sans simulateur.
+  * Les commandes des threads de contrôle sont sérialisées dans l'ordre enregistré,
+  * et les activations de contacts sont rejouées par ce thread dès que leur tour
+  * arrive, sans attendre le temps réel. Une commande qui ne correspond pas à la
+  * trace est signalée comme une divergence.
+  */
+class TraceRejoueur : public QThread
+{
+public:
+    TraceRejoueur();
+
+    /** Charge une trace en mémoire.
+      * \param nomFichier le fichier de trace.
+      * \return vrai si la trace est valide.
+      */
+    bool charger(const QString& nomFichier);
+
+    /** Attend que la commande soit la prochaine de la trace, puis la consomme.
+      */
+    void commande(quint8 type, int numero, int a = 0, int b = 0, int c = 0);
+
+    /** Equivalent de attendre_contact() pendant le rejeu.
+      * \param numero le numéro du contact.
+      */
+    void attendreContact(int numero);
+
+    /** Equivalent de attendre_contact_async() pendant le rejeu. L'appel attend son
+      * tour dans la trace, puis le rappel est appelé par ce thread à la prochaine
+      * activation du contact.
+      * \param numero le numéro du contact.
+      * \param rappel la fonction à appeler.
+      * \param donnees le pointeur transmis à la fonction.
+      */
+    void attendreContactAsync(int numero, void (*rappel)(int, void *), void *donnees);
+
+    /** Equivalent de calculer_itineraire() pendant le rejeu : le résultat est lu
+      * dans la trace, à la suite de l'appel enregistré.
+      * \return vrai si l'itinéraire enregistré n'est pas vide.
+      */
+    bool itineraire(int precedent, int depart, int arrivee,
+                    QVector<int>& contacts, QVector<QPair<int, int> >& aiguillages);
+
+    /** Termine le rejeu et libère les threads de contrôle qui attendent un contact,
+      * par exemple à la fermeture de l'application.
+      */
+    void interrompre();
+
+    /** \return vrai si une divergence a été détectée pendant le rejeu.
+      */
+    bool aDiverge();
+
+protected:
+    void run() override;
+
+private:
+    /** Attend (mutex pris) que l'événement soit le prochain de la trace et le consomme.
+      * \return faux en cas de divergence ou si la trace est terminée.
+      */
+    bool attendreTour(const EvenementTrace& e);
+
+    void signalerDivergence(const QString& recu);
+
+    QVector<EvenementTrace> evenements;
+    int curseur{0};
+    quint64 activations[MAX_CONTACTS + 1];
+    QVector<QPair<void (*)(int, void *), void *> > rappels[MAX_CONTACTS + 1];
+    bool termine{false};
+    bool divergence{false};
+    bool interrompu{false};
+    QMutex mutex;
+    QWaitCondition changement;
+};
+
+#endif // SIMTRACE_H
@@ -1,19 +1,35 @@
 #include "simview.h"
-
-SimView::SimView(QWidget */*parent*/)
-    : QGraphicsView()
+#include "solveurgeometrie.h"
+#include "trainsimsettings.h"
+#include <QVarLengthArray>
+#include <QFile>
+#include <QDataStream>
+
+//! En-tête des fichiers d'état de la simulation.
+#define MAGIC_ETAT 0x51545253 // "QTRS"
+#define VERSION_ETAT 1
+
+SimView::SimView(TrainSimSettings *reglages, QWidget */*parent*/)
+    : QGraphicsView(), reglages(reglages)
 {
     scene = new QGraphicsScene();
     this->setScene(scene);
     this->setRenderHints(QPainter::Antialiasing);
     this->setBackgroundBrush(Qt::white);
+    // Seules les zones modifiées (locos, contacts, aiguillages) sont repeintes.
+    this->setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
     timer = new QTimer(this);
-    CONNECT(timer, SIGNAL(timeout()), this, SLOT(animationStep()));
+    CONNECT(timer, SIGNAL(timeout()), this, SLOT(cadencer()));
 }
 
 void SimView::redraw()
 {
-    scene->update(sceneRect());
+    // Les voies et les contacts sont gardés en cache : il faut invalider
+    // chaque élément dont l'affichage dépend des réglages.
+    foreach(Voie* v, this->Voies)
+        v->update();
+    foreach(Contact* c, this->contacts)
+        c->update();
 }
 
 void SimView::addVoie(Voie *v, int ID)
@@ -26,6 +42,7 @@ void SimView::addVoie(Voie *v, int ID)
 void SimView::addContact(Contact *c, int ID)
 {
     this->contacts.insert(ID, c);
+    CONNECT(c, SIGNAL(activation(int)), this, SIGNAL(contactActive(int)));
 }
 
 void SimView::addVoieVariable(VoieVariable *vv, int ID)
@@ -46,13 +63,30 @@ void SimView::modifierAiguillage(int n, int v)
 
 void SimView::construireMaquette()
 {
-    this->premiereVoie->calculerAnglesEtCoordonnees();
+    SolveurGeometrie solveur(this->premiereVoie);
+    solveur.orienter();
+    solveur.poser();
+
+    // Les voies ne bougent plus : chacune est dessinée une fois dans un pixmap à
+    // l'échelle de la vue, et n'est redessinée que si elle change d'état ou si
+    // le zoom change, et non à chaque passage d'une loco.
+    foreach(Voie* v, this->Voies)
+        v->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    foreach(Contact* c, this->contacts)
+        c->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
-    this->premiereVoie->calculerPosition();
+    reseau.construire(this->Voies.values());
 }
 
 void SimView::viderMaquette()
 {
+    qDeleteAll(routeurs);
+    routeurs.clear();
+    voiesOccupees.clear();
+    occupationVoies.clear();
+    graphe.vider();
+    reseau.vider();
+
     foreach(Voie* v, this->Voies)
         delete v;
 
@@ -61,34 +95,80 @@ void SimView::viderMaquette()
 
 void SimView::genererSegments()
 {
+    qDeleteAll(segments);
+    segments.clear();
+    voiesSegments.clear();
+
+    // Etat du parcours en profondeur : la voie atteinte, son extrémité d'entrée et
+    // la longueur du chemin (depuis le contact de départ) avant d'y entrer.
+    struct Etape
+    {
+        Voie* voie;
+        int entree;
+        int longueur;
+    };
+    QVector<Etape> pile;
+    QVector<Voie*> chemin;
+
     for(int i = 1; i <= this->contacts.size(); i++)
     {
-        QList<QList<Voie*>*> parcours;
-        parcours = this->Voies.value(contacts.value(i)->getNumVoiePorteuse())->startExplorationContactAContact();
+        Contact* depart = contacts.value(i);
+        Voie* voieDepart = this->Voies.value(depart->getNumVoiePorteuse());
 
-        foreach(QList<Voie*>* lv, parcours)
+        for(int sortie = 0; sortie < voieDepart->getNbreLiaisons(); sortie++)
         {
-            if(lv->last()->getContact() != nullptr)
+            Voie* voisine = voieDepart->getVoieVoisineDOrdre(sortie);
+            chemin.resize(1);
+            chemin[0] = voieDepart;
+            pile.append({voisine, voisine->getOrdreLiaison(voieDepart), 1});
+
+            while(!pile.isEmpty())
             {
-                if(contacts.key(lv->first()->getContact()) < contacts.key(lv->last()->getContact()))
+                Etape e = pile.takeLast();
+                chemin.resize(e.longueur);
+                chemin.append(e.voie);
+
+                Contact* arrivee = e.voie->getContact();
+                int sorties = arrivee == nullptr ? e.voie->getSortiesPossibles(e.entree) : 0;
+
+                if(arrivee != nullptr || sorties == 0)
                 {
-                    segments.append(new Segment(lv->first()->getContact(), lv->last()->getContact(), *lv));
+                    // Chaque segment entre deux contacts est parcouru depuis ses deux
+                    // extrémités ; il n'est émis que depuis la plus petite (contact, sortie).
+                    if(arrivee != nullptr)
+                    {
+                        int numArrivee = arrivee->getNumContact();
+                        if(numArrivee < i || (numArrivee == i && e.entree <= sortie))
+                            continue;
+                    }
+                    //gestion de segments entre un contact et une voie buttoir : contact2 == nullptr
+                    segments.append(new Segment(depart, arrivee, &voiesSegments, voiesSegments.size(), chemin.size()));
+                    voiesSegments += chemin;
+                    continue;
                 }
-            }
-            else
-            {
-                //gestion de segments entre un contact et une voie buttoir...
-                segments.append(new Segment(lv->first()->getContact(), nullptr, *lv));
-            }
-        }
 
-        // On détruit les QList*
-        while (!parcours.isEmpty()) {
-            QList<Voie*> *l = parcours.at(0);
-            delete l;
-            parcours.pop_front();
+                // Boucle sans contact : le chemin ne peut pas être plus long que la maquette
+                if(chemin.size() > this->Voies.size())
+                    continue;
+
+                // Empilées en ordre décroissant pour explorer les sorties dans l'ordre
+                for(int n = e.voie->getNbreLiaisons() - 1; n >= 0; n--)
+                {
+                    if(sorties & (1 << n))
+                    {
+                        Voie* suivante = e.voie->getVoieVoisineDOrdre(n);
+                        pile.append({suivante, suivante->getOrdreLiaison(e.voie), chemin.size()});
+                    }
+                }
+            }
         }
     }
+
+    graphe.construire(reseau, segments);
+    indicesSegments.clear();
+    for (int s = 0; s < segments.size(); s++)
+        indicesSegments.insert(segments.at(s), s);
+    occupationVoies.fill(0, reseau.nbreVoies());
 }
 
 void SimView::addLoco(Loco *l, int ID)
@@ -176,6 +256,53 @@ void SimView::zoomFit()
 }
 
 
+qint64 SimView::getTempsSimulation() const
+{
+    return tempsSimulationUs.load() / 1000;
+}
+
+void SimView::ajouterDelai(qint64 delaiMs, std::function<void()> rappel)
+{
+    delais.emplace(tempsSimulationUs.load() + qMax(delaiMs, qint64(0)) * 1000, std::move(rappel));
+}
+
+QImage SimView::capturer()
+{
+    QRectF source = scene->itemsBoundingRect();
+    if (source.isEmpty())
+        return QImage();
+
+    QSize taille = source.size().toSize();
+    if (taille.width() > LARGEUR_IMAGE_EXPORT)
+        taille.scale(LARGEUR_IMAGE_EXPORT, taille.height(), Qt::KeepAspectRatio);
+
+    QImage image(taille, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    painter.setRenderHints(renderHints());
+    scene->render(&painter, QRectF(QPointF(0.0, 0.0), QSizeF(taille)), source, Qt::KeepAspectRatio);
+    return image;
+}
+
+bool SimView::calculerItineraire(int precedent, int depart, int arrivee,
+                                 QVector<int> &contacts, QVector<ReseauVoies::Aiguillage> &aiguillages) const
+{
+    return reseau.itineraire(precedent, depart, arrivee, contacts, aiguillages);
+}
+
+void SimView::setExportImages(ExportImages *exportImages, int periode)
+{
+    this->exportImages = exportImages;
+    this->periodeImages = periode;
+    this->pasDepuisImage = 0;
+}
+
+void SimView::setMesures(MesuresBatch *mesures)
+{
+    this->mesures = mesures;
+}
+
 Contact* SimView::getContact(int n)
 {
     return this->contacts.value(n);
@@ -196,15 +323,60 @@ Segment* SimView::getSegmentByContacts(int contactA, int contactB)
 
 void SimView::animationStart()
 {
+    horloge.start();
+    tempsReelPrecedent = 0;
+    enRetard = 0;
     timer->start(1000/FRAME_RATE);
 }
 
+void SimView::cadencer()
+{
+    if(reglages->getModeRapide())
+    {
+        // Autant de pas que possible pendant la durée d'une image, puis la main
+        // revient à la boucle d'événements pour l'affichage et les commandes.
+        QElapsedTimer budget;
+        budget.start();
+        while(timer->isActive() && budget.elapsed() < 1000 / FRAME_RATE)
+            animationStep();
+
+        tempsReelPrecedent = horloge.elapsed();
+        enRetard = 0;
+        return;
+    }
+
+    // Pas fixe : on simule le temps réel écoulé depuis la dernière image, que
+    // l'affichage soit en avance ou en retard. Une image lente donne plusieurs
+    // pas, une image rapide aucun.
+    qint64 maintenant = horloge.elapsed();
+    enRetard = qMin(enRetard + (maintenant - tempsReelPrecedent) * 1000, qint64(DUREE_PAS_US) * MAX_PAS_PAR_IMAGE);
+    tempsReelPrecedent = maintenant;
+
+    while(timer->isActive() && enRetard >= DUREE_PAS_US)
+    {
+        animationStep();
+        enRetard -= DUREE_PAS_US;
+    }
+
+    // Le temps restant est une fraction de pas : les locos sont affichées entre
+    // leurs deux dernières poses, sans quoi leur mouvement saccade quand le
+    // nombre de pas par image varie.
+    if(!timer->isActive())
+        return;
+    const qreal fraction = qreal(enRetard) / DUREE_PAS_US;
+    foreach(Loco* l, this->Locos)
+        l->afficherPoseInterpolee(fraction);
+}
+
 
 
 #include <QPropertyAnimation>
 #include <QParallelAnimationGroup>
 #include <QThread>
 #include <QApplication>
+#include <QtConcurrent>
+#include <numeric>
+#include <algorithm>
 
 #ifdef WITHSOUND
 #include <QSound>
@@ -232,105 +404,548 @@ protected:
 
 void SimView::animationStep()
 {
+    const qint64 debutPas = tempsSimulationUs.load();
+
     QList<Loco*> listeLocos = this->Locos.values();
+    QList<int> numerosLocos = this->Locos.keys();
+    int nbreLocos = listeLocos.size();
+
+    // Les traitements indépendants d'une loco à l'autre sont répartis sur le pool
+    // de threads à partir de SEUIL_LOCOS_PARALLELE locos.
+    QVector<int> indices(nbreLocos);
+    std::iota(indices.begin(), indices.end(), 0);
+    auto pourChaqueLoco = [&](const std::function<void(int)>& traitement) {
+        if(nbreLocos >= SEUIL_LOCOS_PARALLELE)
+            QtConcurrent::blockingMap(indices, [&](int& n) { traitement(n); });
+        else
+        {
+            for(int n = 0; n < nbreLocos; n++)
+                traitement(n);
+        }
+    };
 
-    bool tropProche;
+    // Phase 1 : déplacement. La vitesse de chaque loco est mise à jour, puis les
+    // locos avancent sur le réseau compact (ReseauVoies::avancerLoco()). Chaque
+    // loco ne lit que le réseau et n'écrit que son propre mouvement, sans toucher
+    // aux éléments de la scène : les locos avancent en parallèle.
+    QVector<char> actives(nbreLocos);
+    QVector<MouvementLoco> mouvements(nbreLocos);
 
-    QList<Voie*> prochainesVoies;
+    for(int n = 0; n < nbreLocos; n++)
+    {
+        Loco* l = listeLocos.at(n);
+        l->debutPas();
+        l->avancerInertie(DUREE_PAS_US);
+        actives[n] = l->getActive() && reseau.indice(l->getVoie()) >= 0;
+        if(actives[n])
+            l->appliquerProfilVitesse();
+        qreal distance = actives[n] ? (l->getVitesseReelle() * DUREE_PAS_US / 1000.0) * FACTEUR_VITESSE : 0.0;
+        mouvements[n].distance = distance;
+        if(distance > 0.0)
+            mouvements[n] = l->getMouvement(reseau, distance);
+    }
 
-    foreach(Loco* l, listeLocos)
+    pourChaqueLoco([&](int n) {
+        if(mouvements[n].distance > 0.0)
+            reseau.avancerLoco(mouvements[n]);
+    });
+
+    // Phase 2 : application des poses. Les mouvements sont reportés sur les locos,
+    // éléments de la scène, dans le thread de l'interface et dans l'ordre des locos.
+    // Les contacts franchis sont mis de côté et l'état nécessaire aux tests est relevé
+    // dans des tableaux.
+    QVector<qreal> distancesSecurite(nbreLocos);
+    QVector<int> voiesLocos(nbreLocos);
+    QVector<int> voiesSuivantes(nbreLocos);
+    QVector<QPolygonF> contours(nbreLocos);
+    QVector<QRectF> englobants(nbreLocos);
+    QVector<ReservationCanton> reservations(cantonMobile ? nbreLocos : 0);
+
+    for(int n = 0; n < nbreLocos; n++)
     {
-        if(l->getActive() && l->getVoie() != nullptr)
+        Loco* l = listeLocos.at(n);
+        qreal distance = mouvements[n].distance;
+        if(distance > 0.0)
+            l->appliquerMouvement(mouvements[n], reseau);
+        if(mesures != nullptr && actives[n])
+            mesures->pas(numerosLocos.at(n), distance, DUREE_PAS_US);
+
+        distancesSecurite[n] = l->getVitesse() * 2000.0 * FACTEUR_VITESSE;
+        voiesLocos[n] = reseau.indice(l->getVoie());
+        voiesSuivantes[n] = actives[n] ? reseau.indice(l->getVoieSuivante()) : -1;
+        contours[n] = l->getContour();
+        englobants[n] = contours[n].boundingRect();
+        if(cantonMobile && actives[n])
+            reserverCanton(l, voiesLocos[n], voiesSuivantes[n], reservations[n]);
+    }
+
+    // Phase 3 : collisions et alertes de proximité. Chaque loco ne lit que les
+    // tableaux relevés en phase 2 et le réseau, et n'écrit que ses propres résultats :
+    // les locos peuvent être traitées en parallèle.
+    QVector<int> collisions(nbreLocos, -1);
+    QVector<char> alertes(nbreLocos, false);
+    QVector<int> genes(nbreLocos, 0);
+    QVector<qreal> limites(nbreLocos, -1.0);
+
+    auto tester = [&](int n) {
+        if(!actives[n])
+            return;
+
+        //test de collision
+        for(int autre = 0; autre < nbreLocos; autre++)
         {
-            if(l->getVitesse() != 0)
-                l->avancer((l->getVitesse() * 1000.0 / FRAME_RATE) * FACTEUR_VITESSE);
+            if(autre != n && englobants[n].intersects(englobants[autre]) &&
+               contours[n].subtracted(contours[autre]) != contours[n])
+            {
+                collisions[n] = autre;
+                break;
+            }
+        }
 
-            QPolygonF contourLoco = l->getContour();
-            QPolygonF contourAutreLoco;
-            //test de collision
-            foreach(Loco* otherLoco, listeLocos)
+        //alerte proximite. Pas encore optimal.
+        QVarLengthArray<int, 32> prochainesVoies;
+        qreal distanceSecurite = distancesSecurite[n];
+        int precedente = voiesLocos[n];
+        int courante = voiesSuivantes[n];
+
+        prochainesVoies.append(precedente);
+        while(courante >= 0)
+        {
+            prochainesVoies.append(courante);
+            distanceSecurite -= reseau.longueur(courante);
+            if(distanceSecurite <= 0)
+                break;
+
+            int suivante = reseau.suivante(courante, precedente);
+            precedente = courante;
+            courante = suivante;
+        }
+
+        for(int v : prochainesVoies)
+        {
+            for(int autre = 0; autre < nbreLocos && !alertes[n]; autre++)
             {
-                if(l != otherLoco)
-                {
-                    contourAutreLoco = otherLoco->getContour();
+                if(autre != n && v == voiesLocos[autre])
+                    alertes[n] = true;
+            }
+        }
 
-                    if(contourLoco.subtracted(contourAutreLoco) != contourLoco)
-                    {
-                        animationStop();
-                        l->setActive(false);
-                        otherLoco->setActive(false);
-                        ExplosionItem *item=new ExplosionItem();
-                        QPixmap img(":images/explosion.png");
-                        item->setPixmap(img);
-                        scene->addItem(item);
-                        QPointF debPoint((l->pos().x()+otherLoco->pos().x())/2,
-                                    (l->pos().y()+otherLoco->pos().y())/2);
-                        QPointF endPoint((l->pos().x()+otherLoco->pos().x())/2-256,
-                                    (l->pos().y()+otherLoco->pos().y())/2-256);
-                        item->setPos(endPoint);
-
-                        QPropertyAnimation *animation1=new QPropertyAnimation(item, "pos");
-                        animation1->setDuration(500);
-                        animation1->setStartValue(debPoint);
-                        animation1->setEndValue(endPoint);
-
-                        QPropertyAnimation *animation2=new QPropertyAnimation(item, "scale");
-                        animation2->setDuration(500);
-                        animation2->setStartValue(0.0);
-                        animation2->setEndValue(1.0);
-
-                        QParallelAnimationGroup *animationGroup=new QParallelAnimationGroup();
-
-                        animationGroup->addAnimation(animation1);
-                        animationGroup->addAnimation(animation2);
-
-                        item->setZValue(ZVAL_EXPLOSION);
-                        item->show();
-                        animationGroup->start();
-#ifdef WITHSOUND
-                        SoundThread *thread=new SoundThread(this);
-                        thread->start();
-#endif // WITHSOUND
-                    }
+        //canton mobile : la loco qui arrive la plus tard à la première voie commune
+        //aux deux réservations cède le passage, à égalité celle de plus grand indice.
+        if(!cantonMobile)
+            return;
+        const ReservationCanton& r = reservations[n];
+        qreal libre = -1.0;
+        for(int autre = 0; autre < nbreLocos; autre++)
+        {
+            if(autre == n || !actives[autre])
+                continue;
+            const ReservationCanton& ra = reservations[autre];
+            for(int i = 0; i < r.voies.size(); i++)
+            {
+                int j = ra.voies.indexOf(r.voies[i]);
+                if(j < 0)
+                    continue;
+                if((r.distances[i] > ra.distances[j] || (r.distances[i] == ra.distances[j] && n > autre)) &&
+                   (libre < 0.0 || r.distances[i] < libre))
+                {
+                    libre = r.distances[i];
+                    genes[n] = numerosLocos.at(autre);
                 }
+                break;
             }
+        }
+        if(genes[n] != 0)
+        {
+            // La loco doit pouvoir s'arrêter une longueur de loco avant la voie commune
+            qreal limite = Loco::vitesseAvantFreinage(libre - LONGUEUR_LOCO);
+            limites[n] = limite < 1.0 ? 0.0 : limite;
+        }
+    };
 
+    pourChaqueLoco(tester);
 
-            //alerte proximite. Pas encore optimal.
-            qreal distanceSecurite = l->getVitesse() * 2000.0 * FACTEUR_VITESSE;
+    // Phase 4 : publication. Les passages de contacts de toutes les locos sont
+    // activés dans l'ordre où ils ont eu lieu pendant le pas, à égalité dans l'ordre
+    // des numéros de locos, et les délais échus pendant le pas sont appelés parmi eux,
+    // après les contacts de même instant. Le temps simulé vaut alors l'instant exact
+    // du passage ou de l'échéance, ce qui horodate correctement les traces et les
+    // commandes qui en découlent.
+    struct Passage
+    {
+        qreal fraction;
+        int loco;
+        Contact* contact;               //!< nullptr pour un délai échu
+        std::function<void()> rappel;
+    };
+    QVector<Passage> passages;
+    for(int n = 0; n < nbreLocos; n++)
+    {
+        for(const PassageContact& p : listeLocos.at(n)->getContactsFranchis())
+            passages.append(Passage{p.fraction, n, p.contact, nullptr});
+        listeLocos.at(n)->viderContactsFranchis();
+    }
+    while(!delais.empty() && delais.begin()->first <= debutPas + DUREE_PAS_US)
+    {
+        qreal fraction = qMax(qreal(delais.begin()->first - debutPas) / DUREE_PAS_US, 0.0);
+        passages.append(Passage{fraction, -1, nullptr, std::move(delais.begin()->second)});
+        delais.erase(delais.begin());
+    }
+    std::stable_sort(passages.begin(), passages.end(), [](const Passage& a, const Passage& b) {
+        return a.fraction < b.fraction;
+    });
+    for(const Passage& p : passages)
+    {
+        tempsSimulationUs = debutPas + qint64(p.fraction * DUREE_PAS_US);
+        if(p.contact == nullptr)
+        {
+            p.rappel();
+            continue;
+        }
+        listeLocos.at(p.loco)->activerContact(p.contact);
+        if(mesures != nullptr)
+            mesures->contact(numerosLocos.at(p.loco), getTempsSimulation());
+    }
+    tempsSimulationUs = debutPas + DUREE_PAS_US;
 
-            prochainesVoies.append(l->getVoie());
-            prochainesVoies.append(l->getVoieSuivante());
-            distanceSecurite -= prochainesVoies.last()->getLongueurAParcourir();
+    if(exportImages != nullptr && periodeImages > 0 && ++pasDepuisImage >= periodeImages)
+    {
+        pasDepuisImage = 0;
+        exportImages->soumettre(capturer(), getTempsSimulation());
+    }
 
-            while(distanceSecurite > 0)
-            {
-                prochainesVoies.append(prochainesVoies.last()->getVoieSuivante(prochainesVoies.at(prochainesVoies.length()-2)));
-                distanceSecurite -= prochainesVoies.last()->getLongueurAParcourir();
-            }
+    for(int n = 0; n < nbreLocos; n++)
+    {
+        Loco* l = listeLocos.at(n);
+
+        if(!actives[n])
+            continue;
 
-            tropProche = false;
+        if(collisions[n] >= 0 && l->getActive())
+            collision(l, listeLocos.at(collisions[n]));
 
-            foreach(Voie* v, prochainesVoies)
+        l->setAlerteProximite(alertes[n]);
+
+        if(cantonMobile)
+        {
+            l->setLimiteVitesse(limites[n]);
+            if(locosGenantes.value(l, 0) != genes[n])
             {
-                foreach(Loco* autreLoco, listeLocos)
-                {
-                    if(autreLoco != l && v == autreLoco->getVoie())
-                    {
-                        tropProche = true;
-                    }
-                }
+                locosGenantes.insert(l, genes[n]);
+                if(rappelCanton != nullptr)
+                    rappelCanton(numerosLocos.at(n), genes[n], donneesCanton);
             }
-            if(tropProche)
-                l->setAlerteProximite(true);
-            else
-                l->setAlerteProximite(false);
+        }
+    }
+
+    publierEtat(listeLocos, numerosLocos, voiesLocos, voiesSuivantes);
 
-            prochainesVoies.clear();
+    if(mesures != nullptr)
+    {
+        int nbreActives = 0;
+        for(Loco* l : listeLocos)
+            nbreActives += l->getActive() ? 1 : 0;
+        if(mesures->termine(getTempsSimulation(), nbreActives))
+        {
+            animationStop();
+            int code = mesures->ecrire(getTempsSimulation()) ? 0 : 1;
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [code]() {
+                QCoreApplication::exit(code);
+            }, Qt::QueuedConnection);
         }
     }
 }
 
+bool SimView::sauverEtat(const QString &nomFichier)
+{
+    QFile fichier(nomFichier);
+    if (!fichier.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream flux(&fichier);
+    flux.setByteOrder(QDataStream::LittleEndian);
+    flux << quint32(MAGIC_ETAT) << quint16(VERSION_ETAT)
+         << quint32(Voies.size()) << quint32(contacts.size())
+         << qint64(getTempsSimulation());
+
+    flux << quint16(VoiesVariables.size());
+    for (auto it = VoiesVariables.constBegin(); it != VoiesVariables.constEnd(); ++it)
+        flux << qint16(it.key()) << qint8(it.value()->getEtat());
+
+    flux << quint16(Locos.size());
+    for (auto it = Locos.constBegin(); it != Locos.constEnd(); ++it)
+    {
+        Loco* l = it.value();
+        Routeur* r = routeurs.value(l);
+        flux << qint16(it.key()) << qint32(indicesSegments.value(l->getSegmentActuel(), -1))
+             << qint16(r != nullptr ? r->getDestination() : 0);
+        l->ecrireEtat(flux);
+    }
+
+    flux << quint16(contacts.size());
+    for (auto it = contacts.constBegin(); it != contacts.constEnd(); ++it)
+        flux << qint16(it.key()) << quint16(it.value()->getNbreAttentes());
+
+    return flux.status() == QDataStream::Ok;
+}
+
+bool SimView::chargerEtat(const QString &nomFichier)
+{
+    QFile fichier(nomFichier);
+    if (!fichier.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream flux(&fichier);
+    flux.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, nbreVoies, nbreContacts;
+    quint16 version, nbre;
+    qint64 temps;
+    flux >> magic >> version >> nbreVoies >> nbreContacts >> temps;
+    if (flux.status() != QDataStream::Ok || magic != MAGIC_ETAT || version != VERSION_ETAT)
+        return false;
+    if (nbreVoies != quint32(Voies.size()) || nbreContacts != quint32(contacts.size()))
+    {
+        qWarning() << "L'état" << nomFichier << "a été enregistré sur une autre maquette";
+        return false;
+    }
+
+    // Tout le fichier est relu et validé avant d'appliquer quoi que ce soit : un état
+    // refusé laisse la simulation intacte.
+    QVector<QPair<VoieVariable*, int> > aiguillages;
+    flux >> nbre;
+    for (int i = 0; i < nbre && flux.status() == QDataStream::Ok; i++)
+    {
+        qint16 numero;
+        qint8 etatVoie;
+        flux >> numero >> etatVoie;
+        VoieVariable* vv = VoiesVariables.value(numero);
+        if (vv != nullptr)
+            aiguillages.append(qMakePair(vv, int(etatVoie)));
+    }
+
+    struct LocoRelue
+    {
+        Loco* loco;
+        int numero;
+        qint32 segment;
+        qint16 destination;
+        EtatLoco etat;
+    };
+    QVector<LocoRelue> locos;
+    flux >> nbre;
+    for (int i = 0; i < nbre && flux.status() == QDataStream::Ok; i++)
+    {
+        LocoRelue r;
+        qint16 numero;
+        flux >> numero >> r.segment >> r.destination;
+
+        r.numero = numero;
+        r.loco = Locos.value(numero);
+        if (r.loco == nullptr)
+        {
+            qWarning() << "La loco" << numero << "de l'état" << nomFichier << "n'est pas sur la maquette";
+            return false;
+        }
+        if (!Loco::lireEtat(flux, Voies, contacts, r.etat))
+            return false;
+        locos.append(r);
+    }
+
+    QVector<QPair<int, int> > attentes;
+    flux >> nbre;
+    for (int i = 0; i < nbre && flux.status() == QDataStream::Ok; i++)
+    {
+        qint16 numero;
+        quint16 nbreAttentes;
+        flux >> numero >> nbreAttentes;
+        attentes.append(qMakePair(int(numero), int(nbreAttentes)));
+    }
+    if (flux.status() != QDataStream::Ok)
+        return false;
+
+    // Les aiguillages d'abord : changer un aiguillage sous une loco la fait dérailler,
+    // et l'état des locos appliqué ensuite l'emporte.
+    for (const auto& aiguillage : aiguillages)
+    {
+        if (aiguillage.first->getEtat() != aiguillage.second)
+            aiguillage.first->setEtat(aiguillage.second);
+    }
+
+    for (const LocoRelue& r : locos)
+    {
+        r.loco->appliquerEtat(r.etat);
+
+        Segment* s = r.segment >= 0 && r.segment < segments.size() ? segments.at(r.segment) : nullptr;
+        r.loco->setSegmentActuel(s);
+        occuperSegment(r.loco, s);
+        setDestinationLoco(r.numero, r.destination);
+    }
+
+    for (const auto& attente : attentes)
+    {
+        Contact* c = contacts.value(attente.first);
+        if (c != nullptr && c->getNbreAttentes() != attente.second)
+            qWarning() << "Contact" << attente.first << ":" << attente.second << "attente(s) enregistrée(s),"
+                       << c->getNbreAttentes() << "en cours";
+    }
+
+    // Les délais en cours gardent le temps qu'il leur reste
+    std::multimap<qint64, std::function<void()> > decales;
+    for (auto& d : delais)
+        decales.emplace(d.first - tempsSimulationUs.load() + temps * 1000, std::move(d.second));
+    delais.swap(decales);
+
+    tempsSimulationUs = temps * 1000;
+    return true;
+}
+
+void SimView::publierEtat(const QList<Loco *> &locos, const QList<int> &numeros,
+                          const QVector<int> &voiesLocos, const QVector<int> &voiesSuivantes)
+{
+    InstantaneSimulation& e = etat.ecrire();
+
+    e.temps = getTempsSimulation();
+    for (PositionLoco& p : e.locos)
+        p.presente = false;
+
+    e.nbreSegments = qMin(segments.size(), MAX_SEGMENTS);
+    for (int s = 0; s < e.nbreSegments; s++)
+    {
+        // Un segment part toujours d'un contact, mais peut finir sur une voie buttoir
+        Segment* segment = segments.at(s);
+        Q_ASSERT(segment->getContact1() != nullptr);
+        Contact* contact2 = segment->getContact2();
+        e.contactsSegments[s][0] = segment->getContact1()->getNumContact();
+        e.contactsSegments[s][1] = contact2 != nullptr ? contact2->getNumContact() : 0;
+    }
+    for (quint64& mot : e.occupation)
+        mot = 0;
+
+    for (int n = 0; n < locos.size(); n++)
+    {
+        Loco* l = locos.at(n);
+        if (numeros.at(n) < 0 || numeros.at(n) > MAX_LOCOS || l->getVoie() == nullptr)
+            continue;
+
+        PositionLoco& p = e.locos[numeros.at(n)];
+        p.presente = true;
+        p.voie = l->getVoie()->getIdVoie();
+        p.vitesse = l->getVitesse();
+
+        // Prochain contact : la voie suivante portant un contact, aiguillages dans leur état actuel
+        p.distanceContact = l->getResteSurVoie();
+        int precedente = voiesLocos[n];
+        int courante = voiesSuivantes[n];
+        for (int garde = 0; courante >= 0 && reseau.numeroContact(courante) == 0 && garde < reseau.nbreVoies(); garde++)
+        {
+            p.distanceContact += reseau.longueur(courante);
+            int suivante = reseau.suivante(courante, precedente);
+            precedente = courante;
+            courante = suivante;
+        }
+        p.contactAvant = courante >= 0 ? reseau.numeroContact(courante) : 0;
+
+        Segment* s = l->getSegmentActuel();
+        p.segment = s != nullptr ? indicesSegments.value(s, -1) : -1;
+        p.contactArriere = 0;
+        if (p.segment >= 0 && p.segment < e.nbreSegments)
+        {
+            int c1 = e.contactsSegments[p.segment][0];
+            int c2 = e.contactsSegments[p.segment][1];
+            // Vers une voie buttoir, contactAvant vaut 0 et le contact arrière est c1 ;
+            // en s'en éloignant, c2 vaut 0 : il n'y a pas de contact derrière la loco.
+            p.contactArriere = p.contactAvant != 0 && c1 == p.contactAvant ? c2 : c1;
+            e.occupation[p.segment / 64] |= quint64(1) << (p.segment % 64);
+        }
+    }
+
+    etat.publier();
+}
+
+void SimView::reserverCanton(Loco *l, int voie, int voieSuivante, ReservationCanton &r) const
+{
+    const qreal longueur = Loco::distanceFreinage(l->getVitesse()) + LONGUEUR_LOCO;
+    qreal distance = l->getResteSurVoie();
+    int precedente = voie;
+    int courante = voieSuivante;
+
+    r.voies.append(voie);
+    r.distances.append(0.0);
+    while(courante >= 0 && distance < longueur)
+    {
+        r.voies.append(courante);
+        r.distances.append(distance);
+        distance += reseau.longueur(courante);
+
+        int suivante = reseau.suivante(courante, precedente);
+        precedente = courante;
+        courante = suivante;
+    }
+}
+
+void SimView::setCantonMobile(bool actif, void (*rappel)(int, int, void *), void *donnees)
+{
+    cantonMobile = actif;
+    rappelCanton = rappel;
+    donneesCanton = donnees;
+
+    // Sans canton mobile, plus aucune vitesse n'est limitée
+    if(!actif)
+    {
+        for(Loco* l : Locos)
+            l->setLimiteVitesse(-1.0);
+        locosGenantes.clear();
+    }
+}
+
+void SimView::collision(Loco *l, Loco *otherLoco)
+{
+    // Image de la collision, avant l'explosion qui la masquerait.
+    if(exportImages != nullptr)
+        exportImages->soumettre(capturer(), getTempsSimulation());
+
+    // En mesure, la simulation continue avec les autres locos
+    if(mesures != nullptr)
+        mesures->collision();
+    else
+        animationStop();
+    l->setActive(false);
+    otherLoco->setActive(false);
+    ExplosionItem *item=new ExplosionItem();
+    QPixmap img(":images/explosion.png");
+    item->setPixmap(img);
+    scene->addItem(item);
+    QPointF debPoint((l->pos().x()+otherLoco->pos().x())/2,
+                (l->pos().y()+otherLoco->pos().y())/2);
+    QPointF endPoint((l->pos().x()+otherLoco->pos().x())/2-256,
+                (l->pos().y()+otherLoco->pos().y())/2-256);
+    item->setPos(endPoint);
+
+    QPropertyAnimation *animation1=new QPropertyAnimation(item, "pos");
+    animation1->setDuration(500);
+    animation1->setStartValue(debPoint);
+    animation1->setEndValue(endPoint);
+
+    QPropertyAnimation *animation2=new QPropertyAnimation(item, "scale");
+    animation2->setDuration(500);
+    animation2->setStartValue(0.0);
+    animation2->setEndValue(1.0);
+
+    QParallelAnimationGroup *animationGroup=new QParallelAnimationGroup();
+
+    animationGroup->addAnimation(animation1);
+    animationGroup->addAnimation(animation2);
+
+    item->setZValue(ZVAL_EXPLOSION);
+    item->show();
+    animationGroup->start();
+#ifdef WITHSOUND
+    SoundThread *thread=new SoundThread(this);
+    thread->start();
+#endif // WITHSOUND
+}
+
 void SimView::animationStop()
 {
     timer->stop();
@@ -359,6 +974,9 @@ void SimView::setLoco(int contactA, int contactB, int numLoco, int vitesseLoco)
 
     l->setPos(v->pos());
 
+    l->setSegmentActuel(s);
+    occuperSegment(l, s);
+
     if(l->getVoieSuivante() == l->getVoie()->getVoieVoisineDOrdre(0))
     {
         l->setRotation(l->rotation() - v->getAngleDeg(0));
@@ -397,6 +1015,13 @@ void SimView::setVitesseProgressiveLoco(int numLoco, int vitesseLoco)
     this->Locos.value(numLoco)->setVitesse(vitesseLoco); //similaire à setVitesseLoco!
 }
 
+void SimView::setProfilVitesseLoco(int numLoco, int vitesseLoco, int numContact)
+{
+    if (!checkLoco(numLoco))
+        return;
+    this->Locos.value(numLoco)->setProfilVitesse(vitesseLoco, this->contacts.value(numContact));
+}
+
 void SimView::stopLoco(int numLoco)
 {
     if (!checkLoco(numLoco))
@@ -411,13 +1036,95 @@ void SimView::setVoieVariable(int numVoieVariable, int direction)
     this->VoiesVariables.value(numVoieVariable)->setEtat(direction);
 }
 
+void SimView::setDestinationLoco(int numLoco, int contact)
+{
+    if (!checkLoco(numLoco))
+        return;
+    Loco* l = this->Locos.value(numLoco);
+
+    if (contact == 0)
+    {
+        delete routeurs.take(l);
+        return;
+    }
+
+    Routeur* r = routeurs.value(l);
+    if (r == nullptr)
+    {
+        r = new Routeur(&graphe, &occupationVoies);
+        r->setVoiesPropres(voiesOccupees.value(l));
+        routeurs.insert(l, r);
+    }
+    r->setDestination(contact);
+}
+
 void SimView::locoSurNouveauSegment(Contact *ctc1, Contact *ctc2, Loco *l)
 {
-    l->setSegmentActuel(getSegmentByContacts(contacts.key(ctc1), contacts.key(ctc2)));
+    Segment* s = nullptr;
+
+    // Loco routée : le segment suivant est celui du plus court chemin libre, et ses
+    // aiguillages sont dirigés avant que la loco ne quitte le contact.
+    Routeur* r = routeurs.value(l);
+    if (r != nullptr)
+    {
+        int a = r->prochainArc(graphe.noeud(reseau.indice(l->getVoie()), reseau.indice(l->getVoieSuivante())));
+        if (a >= 0)
+        {
+            const GrapheTroncons::Arc& arc = graphe.arc(a);
+            for (const ReseauVoies::Aiguillage& aiguillage : arc.aiguillages)
+            {
+                VoieVariable* vv = this->VoiesVariables.value(aiguillage.first);
+                if (vv != nullptr && vv->getEtat() != aiguillage.second)
+                    vv->setEtat(aiguillage.second);
+            }
+            s = segments.at(arc.segment);
+        }
+    }
+
+    if (s == nullptr)
+        s = getSegmentByContacts(contacts.key(ctc1), contacts.key(ctc2));
+    l->setSegmentActuel(s);
+    occuperSegment(l, s);
+}
+
+void SimView::occuperSegment(Loco *l, Segment *s)
+{
+    // Segments pas encore générés
+    if (occupationVoies.size() != reseau.nbreVoies())
+        return;
+
+    // Les contacts aux extrémités sont communs aux segments voisins : seules les
+    // voies intérieures sont occupées.
+    QVector<int> voies;
+    for (int i = 1; s != nullptr && i < s->getNbreVoies() - 1; i++)
+    {
+        int v = reseau.indice(s->getVoie(i));
+        if (v >= 0)
+            voies.append(v);
+    }
+
+    QVector<int> anciennes = voiesOccupees.value(l);
+    for (int v : anciennes)
+        occupationVoies[v]--;
+    for (int v : voies)
+        occupationVoies[v]++;
+    voiesOccupees.insert(l, voies);
+
+    for (auto it = routeurs.constBegin(); it != routeurs.constEnd(); ++it)
+    {
+        if (it.key() == l)
+        {
+            it.value()->setVoiesPropres(voies);
+            continue;
+        }
+        it.value()->voiesModifiees(anciennes);
+        it.value()->voiesModifiees(voies);
+    }
 }
 
 void SimView::voieVariableModifiee(Voie *v)
 {
+    reseau.setEtat(v, static_cast<VoieVariable*>(v)->getEtat());
     notificationVoieVariableModifiee(v);
 }
 
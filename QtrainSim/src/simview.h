@@ -4,14 +4,26 @@
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QVarLengthArray>
+#include <atomic>
+#include <functional>
+#include <map>
 
 #include "connect.h"
 #include "voie.h"
 #include "voievariable.h"
 #include "loco.h"
 #include "segment.h"
+#include "reseauvoies.h"
+#include "routeur.h"
+#include "exportimages.h"
+#include "etatsimulation.h"
+#include "mesuresbatch.h"
 
 
+class TrainSimSettings;
+
 class ExplosionItem :  public QObject, public QGraphicsPixmapItem
 {
     Q_OBJECT
@@ -27,9 +39,9 @@ class SimView : public QGraphicsView
     Q_OBJECT
 public:
     /** Constructeur de classe
-      *
+      * \param reglages les réglages de la simulation, qui doivent survivre à la vue.
       */
-    explicit SimView(QWidget *);
+    SimView(TrainSimSettings* reglages, QWidget *);
 
     /** Permet d'ajouter une voie à la simulation.
       * \param v la voie à ajouter
@@ -72,8 +84,9 @@ public:
       */
     void viderMaquette();
 
-    /** Génére la liste des segments de la maquette.
-      *
+    /** Génére la liste des segments de la maquette, par un parcours en profondeur
+      * depuis chaque contact. Chaque segment est créé une seule fois et ses voies sont
+      * rangées dans un tableau commun à tous les segments.
       */
     void genererSegments();
 
@@ -110,12 +123,94 @@ public:
       */
     Contact* getContact(int n);
 
-    /** raffraichit l'affichage.
-      *
+    /** raffraichit l'affichage des voies et des contacts, par exemple après un
+      * changement des réglages d'affichage.
       */
     void redraw();
+
+    /** retourne le temps simulé écoulé depuis le début de la simulation.
+      * Peut être appelé depuis n'importe quel thread.
+      * \return le temps simulé en millisecondes.
+      */
+    qint64 getTempsSimulation() const;
+
+    /** appelle une fonction une fois écoulé un délai de temps simulé, pendant le pas
+      * où il expire : le temps simulé vaut alors l'instant exact de l'échéance. Le
+      * délai ne s'écoule pas pendant une pause. A appeler depuis le thread de l'interface.
+      * \param delaiMs le délai, en millisecondes de temps simulé.
+      * \param rappel la fonction à appeler, dans le thread de l'interface.
+      */
+    void ajouterDelai(qint64 delaiMs, std::function<void()> rappel);
+
+    /** dessine toute la maquette dans une image, indépendamment du zoom de la vue.
+      * A appeler depuis le thread de l'interface.
+      * \return l'image, d'au plus LARGEUR_IMAGE_EXPORT pixels de large.
+      */
+    QImage capturer();
+
+    /** exporte une image de la simulation tous les periode pas, ainsi qu'à chaque
+      * collision. L'écriture est faite par le thread de l'export.
+      * \param exportImages l'export à utiliser, nullptr pour ne plus exporter.
+      * \param periode le nombre de pas de simulation entre deux images, 0 pour
+      * n'exporter qu'en cas de collision.
+      */
+    void setExportImages(ExportImages* exportImages, int periode);
+
+    /** mesure la simulation pour qtrainsim_batch. Une collision n'arrête plus la
+      * simulation, et l'application se termine quand les mesures le demandent.
+      * \param mesures les mesures à tenir à jour, nullptr pour ne rien mesurer.
+      */
+    void setMesures(MesuresBatch* mesures);
+
+    /** calcule l'itinéraire le plus court entre deux contacts, voir ReseauVoies::itineraire().
+      * A appeler depuis le thread de l'interface.
+      */
+    bool calculerItineraire(int precedent, int depart, int arrivee,
+                            QVector<int>& contacts, QVector<ReseauVoies::Aiguillage>& aiguillages) const;
+
+    /** active ou désactive l'espacement des locos par canton mobile. Chaque loco réserve
+      * les voies devant elle sur sa distance de freinage ; une loco dont la réservation
+      * rencontre celle d'une loco plus proche du point de rencontre est ralentie pour
+      * pouvoir s'arrêter avant. A appeler depuis le thread de l'interface.
+      * \param actif vrai pour activer le canton mobile.
+      * \param rappel la fonction appelée quand la limitation d'une loco commence ou
+      * cesse, avec le numéro de la loco, celui de la loco qui la gêne (0 à la levée)
+      * et donnees. Peut être nullptr.
+      * \param donnees le pointeur transmis à la fonction.
+      */
+    void setCantonMobile(bool actif, void (*rappel)(int, int, void *), void *donnees);
+
+    /** retourne l'état de la simulation publié à chaque pas, à lire sans verrou
+      * depuis n'importe quel thread.
+      */
+    const EtatSimulation& getEtat() const { return etat; }
+
+    /** enregistre l'état complet de la simulation dans un fichier binaire : temps
+      * simulé, état des aiguillages, position exacte, vitesses et inertie des locos,
+      * destinations du routage et nombre d'attentes en cours sur chaque contact.
+      * A appeler depuis le thread de l'interface.
+      * \param nomFichier le fichier à créer.
+      * \return vrai si l'état a pu être écrit.
+      */
+    bool sauverEtat(const QString& nomFichier);
+
+    /** restaure un état enregistré par sauverEtat(), sans recharger la maquette.
+      * La maquette doit être la même, et les locos déjà placées sur la maquette ; sinon
+      * le chargement échoue, éventuellement après avoir changé des aiguillages.
+      * Les attentes sur les contacts ne peuvent pas être restaurées : si celles en
+      * cours diffèrent de celles enregistrées, un avertissement est affiché.
+      * A appeler depuis le thread de l'interface.
+      * \param nomFichier le fichier à lire.
+      * \return vrai si l'état a été restauré.
+      */
+    bool chargerEtat(const QString& nomFichier);
 signals:
 
+    /** Signale qu'une loco a activé un contact.
+      * \param numContact le numéro du contact activé.
+      */
+    void contactActive(int numContact);
+
     /** Signale qu'une loco a changé de segment, et se trouve que le segment s.
       * \param s, le segment occupé.
       */
@@ -127,6 +222,12 @@ signals:
     void notificationVoieVariableModifiee(Voie* v);
 public slots:
 
+    /** appelé à chaque image : effectue les pas de simulation correspondant au
+      * temps réel écoulé (ou autant que possible en mode rapide). L'affichage
+      * suit à la fin de l'image, une seule fois quel que soit le nombre de pas.
+      */
+    void cadencer();
+
     /** effectue un nouveau pas d'animation.
       *
       */
@@ -177,12 +278,25 @@ public slots:
       */
     void stopLoco(int numLoco);
 
+    /** fait ralentir une loco pour qu'elle franchisse un contact à la vitesse donnée.
+      * \param numLoco le numéro de la loco.
+      * \param vitesseLoco la vitesse au contact.
+      * \param numContact le numéro du contact.
+      */
+    void setProfilVitesseLoco(int numLoco, int vitesseLoco, int numContact);
+
     /** modifie l'etat d'une voie variable.
       * \param numVoieVariable le numéro de la voie variable.
       * \param direction la nouvelle direction de la voie (DEVIE ou TOUT_DROIT)
       */
     void setVoieVariable(int numVoieVariable, int direction);
 
+    /** confie le choix du chemin d'une loco au simulateur.
+      * \param numLoco le numéro de la loco.
+      * \param contact le contact à atteindre, 0 pour arrêter le routage.
+      */
+    void setDestinationLoco(int numLoco, int contact);
+
     /** reçoit l'information qu'une loco a changé de segment.
       * \param ctc1 et ctc2 définissent le segment.
       * \param l la loco ayant changé de segment.
@@ -196,6 +310,7 @@ public slots:
 
 
 private:
+    TrainSimSettings* reglages;
     QTimer* timer;
     QGraphicsScene * scene;
     QMap<int, Voie*> Voies;
@@ -204,6 +319,49 @@ private:
     Voie* premiereVoie;
     QMap<int, Loco*> Locos;
     QList<Segment*> segments;
+    QVector<Voie*> voiesSegments;  //!< voies de tous les segments, à la suite
+    ReseauVoies reseau;            //!< copie compacte des voies, pour l'alerte de proximité
+    GrapheTroncons graphe;         //!< segments parcourus dans chaque sens, pour le routage
+    QVector<int> occupationVoies;  //!< nombre de locos dont le segment passe par chaque voie
+    QHash<Loco*, QVector<int> > voiesOccupees;
+    QHash<Loco*, Routeur*> routeurs;
+    std::atomic<qint64> tempsSimulationUs{0};  //!< temps simulé, en microsecondes
+    std::multimap<qint64, std::function<void()> > delais;  //!< rappels par échéance, en microsecondes
+    QElapsedTimer horloge;          //!< temps réel depuis le démarrage de l'animation
+    qint64 tempsReelPrecedent{0};   //!< temps réel de la dernière image, en ms
+    qint64 enRetard{0};             //!< temps réel pas encore simulé, en microsecondes
+    ExportImages* exportImages{nullptr};
+    int periodeImages{0};           //!< pas de simulation entre deux images exportées
+    int pasDepuisImage{0};
+    MesuresBatch* mesures{nullptr};
+    bool cantonMobile{false};
+    void (*rappelCanton)(int, int, void *){nullptr};
+    void* donneesCanton{nullptr};
+    QHash<Loco*, int> locosGenantes;  //!< loco qui limite la vitesse de chaque loco, 0 sans limite
+    EtatSimulation etat;
+    QHash<const Segment*, int> indicesSegments;
+
+    //! voies réservées devant une loco par le canton mobile.
+    struct ReservationCanton
+    {
+        QVarLengthArray<int, 16> voies;
+        QVarLengthArray<qreal, 16> distances;  //!< distance de l'avant de la loco à l'entrée de chaque voie
+    };
+
+    /** réserve les voies devant une loco, sur sa distance de freinage et une longueur de loco.
+      * \param l la loco.
+      * \param voie l'indice de sa voie actuelle.
+      * \param voieSuivante l'indice de la voie vers laquelle elle se dirige.
+      * \param r la réservation à remplir.
+      */
+    void reserverCanton(Loco* l, int voie, int voieSuivante, ReservationCanton& r) const;
+
+    /** publie la position des locos et l'occupation des segments à la fin d'un pas.
+      * \param locos et numeros les locos et leurs numéros.
+      * \param voiesLocos et voiesSuivantes les indices de leurs voies dans le réseau.
+      */
+    void publierEtat(const QList<Loco*>& locos, const QList<int>& numeros,
+                     const QVector<int>& voiesLocos, const QVector<int>& voiesSuivantes);
 
     /** retourne le segment correspondant à la paire de contacts passée en paramètre
       * \param contactA et contactB les contacts définissant les segment.
@@ -211,6 +369,17 @@ private:
       */
     Segment* getSegmentByContacts(int contactA, int contactB);
 
+    /** enregistre qu'une loco occupe désormais un segment et prévient les routeurs.
+      * \param l la loco.
+      * \param s son segment, nullptr s'il n'est pas connu.
+      */
+    void occuperSegment(Loco* l, Segment* s);
+
+    /** arrête la simulation et affiche l'explosion de deux locos entrées en collision.
+      * \param l et otherLoco les deux locos.
+      */
+    void collision(Loco* l, Loco* otherLoco);
+
     bool checkLoco(int numLoco);
 
     bool checkVoieVariable(int numVoie);
@@ -0,0 +1,134 @@
+#include "solveurgeometrie.h"
+
+//! Ecart en dessous duquel deux extrémités sont considérées comme confondues.
+#define TOLERANCE_LIAISON 1e-10
+
+SolveurGeometrie::SolveurGeometrie(Voie *premiereVoie)
+{
+    if (premiereVoie == nullptr)
+        return;
+
+    voies.append(premiereVoie);
+    parent.append(-1);
+    profondeur.append(0);
+    indices.insert(premiereVoie, 0);
+
+    // Le tableau sert lui-même de file du parcours en largeur
+    for (int i = 0; i < voies.size(); i++)
+    {
+        Voie* v = voies.at(i);
+        for (int n = 0; n < v->getNbreLiaisons(); n++)
+        {
+            Voie* voisine = v->getVoieVoisineDOrdre(n);
+            if (voisine == nullptr || indices.contains(voisine))
+                continue;
+
+            indices.insert(voisine, voies.size());
+            voies.append(voisine);
+            parent.append(i);
+            profondeur.append(profondeur.at(i) + 1);
+        }
+    }
+    decalage.fill(QPointF(0.0, 0.0), voies.size());
+}
+
+void SolveurGeometrie::orienter()
+{
+    for (int i = 0; i < voies.size(); i++)
+    {
+        voies.at(i)->calculerAnglesEtCoordonnees(parent.at(i) < 0 ? nullptr : voies.at(parent.at(i)));
+    }
+}
+
+QPointF SolveurGeometrie::ecart(Voie *a, Voie *b)
+{
+    return a->getPosAbsLiaison(b) - b->getPosAbsLiaison(a);
+}
+
+void SolveurGeometrie::repartirBoucle(int a, int b)
+{
+    // Nombre de liaisons de la boucle : la liaison fermante et les liaisons de l'arbre
+    // entre a et b.
+    int ia = a, ib = b, k = 1;
+    while (ia != ib)
+    {
+        if (profondeur.at(ia) >= profondeur.at(ib))
+            ia = parent.at(ia);
+        else
+            ib = parent.at(ib);
+        k++;
+    }
+
+    // Chaque liaison de l'arbre absorbe 1/k de l'écart en translatant son sous-arbre ;
+    // l'écart restant sur la liaison fermante est aussi de 1/k.
+    QPointF part = ecart(voies.at(a), voies.at(b)) / k;
+    ia = a;
+    ib = b;
+    while (ia != ib)
+    {
+        if (profondeur.at(ia) >= profondeur.at(ib))
+        {
+            decalage[ia] -= part;
+            ia = parent.at(ia);
+        }
+        else
+        {
+            decalage[ib] += part;
+            ib = parent.at(ib);
+        }
+    }
+}
+
+void SolveurGeometrie::poser()
+{
+    if (voies.isEmpty())
+        return;
+
+    // Pose le long de l'arbre de parcours
+    voies.at(0)->calculerPosition();
+    for (int i = 1; i < voies.size(); i++)
+        voies.at(i)->calculerPosition(voies.at(parent.at(i)));
+
+    // Répartition des écarts de fermeture, mesurés sur la pose initiale
+    for (int i = 0; i < voies.size(); i++)
+    {
+        Voie* v = voies.at(i);
+        for (int n = 0; n < v->getNbreLiaisons(); n++)
+        {
+            int j = indices.value(v->getVoieVoisineDOrdre(n), -1);
+            if (j > i && parent.at(j) != i && parent.at(i) != j)
+                repartirBoucle(i, j);
+        }
+    }
+
+    // Translation des sous-arbres, cumulée de la racine vers les feuilles
+    for (int i = 1; i < voies.size(); i++)
+    {
+        decalage[i] += decalage.at(parent.at(i));
+        if (!decalage.at(i).isNull())
+            voies.at(i)->setPos(voies.at(i)->pos() + decalage.at(i));
+    }
+
+    // Chaque liaison ouverte est refermée par moitié sur ses deux voies
+    for (int i = 0; i < voies.size(); i++)
+    {
+        Voie* v = voies.at(i);
+        for (int n = 0; n < v->getNbreLiaisons(); n++)
+        {
+            Voie* voisine = v->getVoieVoisineDOrdre(n);
+            if (indices.value(voisine, -1) <= i)
+                continue;
+
+            QPointF delta = ecart(v, voisine);
+            if (qAbs(delta.x()) > TOLERANCE_LIAISON || qAbs(delta.y()) > TOLERANCE_LIAISON)
+            {
+                voisine->correctionPosition(delta.x() / 2.0, delta.y() / 2.0, v);
+                v->correctionPosition(- delta.x() / 2.0, - delta.y() / 2.0, voisine);
+            }
+        }
+    }
+
+    // Les voies ne bougent plus : longueurs et positions des extrémités sont figées
+    for (Voie* v : voies)
+        v->precalculer();
+}
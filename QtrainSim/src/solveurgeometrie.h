@@ -0,0 +1,50 @@
+#ifndef SOLVEURGEOMETRIE_H
+#define SOLVEURGEOMETRIE_H
+
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+
+#include "voie.h"
+
+/** Calcule l'orientation et la position de toutes les voies d'une maquette.
+  * Les voies sont parcourues en largeur à partir de la première voie et rangées dans
+  * un tableau, sans récursion. Chaque voie est orientée et posée à partir de sa voie
+  * parente dans l'arbre de parcours. Les liaisons hors de l'arbre ferment des boucles :
+  * l'écart de fermeture de chaque boucle est réparti uniformément sur toutes les
+  * liaisons de la boucle, puis chaque liaison est refermée par moitié sur ses deux voies.
+  */
+class SolveurGeometrie
+{
+public:
+    /** Constructeur de classe. Parcourt toutes les voies reliées à la première voie.
+      * \param premiereVoie la voie à partir de laquelle la maquette est construite.
+      */
+    explicit SolveurGeometrie(Voie* premiereVoie);
+
+    /** Oriente toutes les voies (calculerAnglesEtCoordonnees), dans l'ordre du parcours.
+      */
+    void orienter();
+
+    /** Pose toutes les voies, referme les boucles puis précalcule les tables de
+      * chaque voie. A appeler après orienter().
+      */
+    void poser();
+
+private:
+    /** retourne l'écart entre les extrémités de deux voies liées.
+      */
+    static QPointF ecart(Voie* a, Voie* b);
+
+    /** répartit l'écart de la boucle fermée par la liaison entre les voies d'indices a et b.
+      */
+    void repartirBoucle(int a, int b);
+
+    QVector<Voie*> voies;       //!< voies dans l'ordre du parcours en largeur
+    QVector<int> parent;        //!< indice de la voie parente dans l'arbre, -1 pour la racine
+    QVector<int> profondeur;    //!< profondeur dans l'arbre de parcours
+    QVector<QPointF> decalage;  //!< translation du sous-arbre, relative à la voie parente
+    QHash<Voie*, int> indices;
+};
+
+#endif // SOLVEURGEOMETRIE_H
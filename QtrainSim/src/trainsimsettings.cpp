@@ -6,6 +6,7 @@ TrainSimSettings::TrainSimSettings()
     viewContactNumber = false;
     viewAiguillageNumber = false;
     inertie = true;
+    modeRapide = false;
 }
 
 
@@ -55,3 +56,13 @@ void TrainSimSettings::setInertie(bool enable)
     inertie = enable;
 }
 
+bool TrainSimSettings::getModeRapide()
+{
+    return modeRapide;
+}
+
+void TrainSimSettings::setModeRapide(bool enable)
+{
+    modeRapide = enable;
+}
+
@@ -1,6 +1,10 @@
 #ifndef TRAINSIMSETTINGS_H
 #define TRAINSIMSETTINGS_H
 
+/** Réglages du simulateur. getInstance() retourne ceux de l'interface, qui
+  * s'appliquent au contexte par défaut ; chaque autre contexte de simulation
+  * travaille sur sa propre copie. L'affichage des numéros reste commun.
+  */
 class TrainSimSettings
 {
 
@@ -20,6 +24,9 @@ public:
     bool getInertie();
     void setInertie(bool enable);
 
+    bool getModeRapide();
+    void setModeRapide(bool enable);
+
 protected:
     TrainSimSettings();
 
@@ -27,6 +34,7 @@ protected:
     bool viewAiguillageNumber;
     bool viewLocoLog;
     bool inertie;
+    bool modeRapide;
 };
 
 
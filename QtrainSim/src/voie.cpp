@@ -7,6 +7,10 @@
 Voie::Voie()
 {
     this->contact = nullptr;
+    this->precalculee = false;
+    for (int i = 0; i < NB_ETATS_VOIE; i++)
+        this->longueurs[i] = 0.0;
+    this->indiceLongueur = DEVIE + 1;
     setZValue(ZVAL_VOIE);
 }
 
@@ -31,62 +35,54 @@ void Voie::calculerPosition(Voie *v)
     {
         QPointF positionLiaison = v->getPosAbsLiaison(this);
 
-        setPos(positionLiaison.x() - coordonneesLiaison[ordreLiaison.key(v)]->x(),
-               positionLiaison.y() - coordonneesLiaison[ordreLiaison.key(v)]->y());
+        setPos(positionLiaison.x() - coordonneesLiaison[getOrdreLiaison(v)]->x(),
+               positionLiaison.y() - coordonneesLiaison[getOrdreLiaison(v)]->y());
     }
 
     posee = true;
+}
 
-    qreal deltaX, deltaY;
 
-    for(int i =0; i < ordreLiaison.size(); i++)
+int Voie::getOrdreLiaison(Voie *voisine) const
+{
+    // Au plus quatre voisines : un parcours du tableau est plus rapide qu'une recherche
+    for (int i = 0; i < voisines.size(); i++)
     {
-        if(!ordreLiaison[i]->estPosee())
-            ordreLiaison[i]->calculerPosition(this);
-        else
-        {
-            if((getPosAbsLiaison(ordreLiaison[i]).x() - ordreLiaison[i]->getPosAbsLiaison(this).x()) < -1e-10 ||
-               (getPosAbsLiaison(ordreLiaison[i]).y() - ordreLiaison[i]->getPosAbsLiaison(this).y()) < -1e-10 ||
-               (getPosAbsLiaison(ordreLiaison[i]).x() - ordreLiaison[i]->getPosAbsLiaison(this).x()) > 1e-10 ||
-               (getPosAbsLiaison(ordreLiaison[i]).y() - ordreLiaison[i]->getPosAbsLiaison(this).y()) > 1e-10)
-            {
-                deltaX = getPosAbsLiaison(ordreLiaison[i]).x() - ordreLiaison[i]->getPosAbsLiaison(this).x();
-                deltaY = getPosAbsLiaison(ordreLiaison[i]).y() - ordreLiaison[i]->getPosAbsLiaison(this).y();
-
-
-                ordreLiaison[i]->correctionPosition(deltaX / 2.0, deltaY / 2.0, this);
-                this->correctionPosition(- deltaX / 2.0, - deltaY / 2.0, ordreLiaison[i]);
-
-                deltaX = getPosAbsLiaison(ordreLiaison[i]).x() - ordreLiaison[i]->getPosAbsLiaison(this).x();
-                deltaY = getPosAbsLiaison(ordreLiaison[i]).y() - ordreLiaison[i]->getPosAbsLiaison(this).y();
-            }
-        }
+        if (voisines.at(i) == voisine)
+            return i;
     }
+    return 0;
 }
 
-
-QList<QList<Voie*>*> Voie::startExplorationContactAContact()
+void Voie::lier(Voie *v, int ordre)
 {
-    QList<QList<Voie*>*> temp;
+    if (voisines.size() <= ordre)
+        voisines.resize(ordre + 1);
+    voisines[ordre] = v;
+    coordonneesLiaison.insert(ordre, new QPointF());
+    angleLiaison.insert(ordre, 0.0);
+}
 
-    for(int i=0; i<ordreLiaison.size(); i++)
-    {
-        temp.append(ordreLiaison[i]->explorationContactAContact(this));
-    }
+void Voie::precalculer()
+{
+    calculerLongueurs();
 
-    foreach(QList<Voie*>* lv, temp)
-    {
-        lv->prepend(this);
-    }
+    posAbsLiaisons.resize(voisines.size());
+    for (int i = 0; i < voisines.size(); i++)
+        posAbsLiaisons[i] = scenePos() + *coordonneesLiaison.value(i);
+    precalculee = true;
+}
 
-    return temp;
+void Voie::setLongueurs(qreal longueurDevie, qreal longueurToutDroit, qreal longueurTroisieme)
+{
+    longueurs[DEVIE + 1] = longueurDevie;
+    longueurs[TOUT_DROIT + 1] = longueurToutDroit;
+    longueurs[-1 + 1] = longueurTroisieme;
 }
 
-void Voie::lier(Voie *v, int ordre)
+void Voie::selectionnerLongueur(int etat)
 {
-    ordreLiaison.insert(ordre, v);
-    coordonneesLiaison.insert(ordre, new QPointF());
-    angleLiaison.insert(ordre, 0.0);
+    indiceLongueur = qBound(0, etat + 1, NB_ETATS_VOIE - 1);
 }
 
 bool Voie::estOrientee()
@@ -112,8 +108,11 @@ double Voie::normaliserAngle(double angle) const
 
 QPointF Voie::getPosAbsLiaison(Voie *v)
 {
-    return QPointF(this->scenePos().x() + coordonneesLiaison[ordreLiaison.key(v)]->x(),
-                                this->scenePos().y() + coordonneesLiaison[ordreLiaison.key(v)]->y());
+    if (precalculee)
+        return posAbsLiaisons.at(getOrdreLiaison(v));
+
+    return QPointF(this->scenePos().x() + coordonneesLiaison[getOrdreLiaison(v)]->x(),
+                                this->scenePos().y() + coordonneesLiaison[getOrdreLiaison(v)]->y());
 }
 
 void Voie::setContact(Contact *c)
@@ -129,7 +128,7 @@ Contact* Voie::getContact() const
 
 int Voie::getNbreLiaisons() const
 {
-    return ordreLiaison.size();
+    return voisines.size();
 }
 
 qreal Voie::getXmin() const
@@ -154,12 +153,12 @@ qreal Voie::getYmax() const
 
 qreal Voie::getAngleVoisin(Voie *voisin) const
 {
-    return angleLiaison[ordreLiaison.key(voisin)];
+    return angleLiaison[getOrdreLiaison(voisin)];
 }
 
 qreal Voie::getNouvelAngle(Voie *voisin) const
 {
-    return normaliserAngle(angleLiaison[ordreLiaison.key(voisin)] + 180.0);
+    return normaliserAngle(angleLiaison[getOrdreLiaison(voisin)] + 180.0);
 }
 
 qreal Voie::getAngleDeg(int liaison) const
@@ -199,9 +198,20 @@ void Voie::setAngleRad(int liaison, qreal angle)
 
 }
 
+void Voie::decrireGeometrie(GeometrieVoie &g) const
+{
+    g = GeometrieVoie();
+    g.position = pos();
+    for (int i = 0; i < voisines.size() && i < MAX_LIAISONS_VOIE; i++)
+    {
+        g.liaisons[i] = posAbsLiaisons.value(i);
+        g.angles[i] = angleLiaison.value(i);
+    }
+}
+
 Voie* Voie::getVoieVoisineDOrdre(int n)
 {
-    return ordreLiaison.value(n);
+    return voisines.value(n);
 }
 
 void Voie::drawBoundingRect(QPainter *
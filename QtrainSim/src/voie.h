@@ -12,11 +12,47 @@
 #include <QAbstractGraphicsShapeItem>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
-#include <QMap>
+#include <QVector>
 
 #include "general.h"
 #include "contact.h"
 
+//! Genre de voie, pour les traitements qui ne passent pas par les méthodes virtuelles.
+enum class TypeVoie : quint8
+{
+    DROITE,
+    COURBE,
+    BUTTOIR,
+    AIGUILLAGE,
+    AIGUILLAGE_ENROULE,
+    AIGUILLAGE_TRIPLE,
+    CROISEMENT,
+    TRAVERSEE_JONCTION
+};
+
+//! Nombre d'états d'une voie : -1 (aiguillage triple), DEVIE et TOUT_DROIT.
+#define NB_ETATS_VOIE 3
+
+//! Nombre maximal de liaisons d'une voie.
+#define MAX_LIAISONS_VOIE 4
+
+/** Géométrie d'une voie, relevée une fois la voie posée, pour déplacer les locos sans
+  * appel virtuel (voir ReseauVoies::avancerLoco()). Les champs propres à un genre de
+  * voie sont remplis par la méthode decrireGeometrie() de ce genre.
+  */
+struct GeometrieVoie
+{
+    QPointF position;                       //!< position de la voie dans la scène
+    QPointF liaisons[MAX_LIAISONS_VOIE];    //!< position absolue de chaque extrémité
+    qreal angles[MAX_LIAISONS_VOIE] = {};   //!< angle de chaque extrémité, en degrés
+    qreal angle{0.0};                       //!< angle de la partie courbe, en degrés
+    qreal longueur{0.0};                    //!< longueur de la partie droite
+    qreal rayon{0.0};                       //!< rayon de la courbe (intérieure, gauche ou 0-3)
+    qreal rayon2{0.0};                      //!< rayon de la seconde courbe (extérieure, droite ou 1-2)
+    QPointF centre;                         //!< centre de la courbe de rayon, relatif à la voie
+    QPointF extremite0, extremite1;         //!< voie droite : extrémités, relatives à la voie
+};
+
 class Voie : public QObject, public QAbstractGraphicsShapeItem
 {
     Q_OBJECT
@@ -28,14 +64,15 @@ public:
 
     /** Méthode permettant de calculer la position de la voie, en fonction d'une voie
       * voisine déjà posée. S'il s'agit de la première voie posée, on lui attribue une position
-      * par défaut.
+      * par défaut. Les voisines ne sont pas posées : c'est le rôle de SolveurGeometrie.
       * \param v pointeur sur la voie voisine déjà posée.
       */
     void calculerPosition(Voie* v = nullptr);
 
     /** méthode virtuelle visant à calculer les angles et coordonnées (locales) de chaque extrémité
       * de la voie.
-      * Cette méthode est appelée récursivement, jusqu'à ce que toutes les voies aient été orientées.
+      * Les voisines ne sont pas orientées : SolveurGeometrie appelle cette méthode pour chaque
+      * voie, à partir d'une voisine déjà orientée.
       * \param v pointeur sur la voie voisine déjà orientée.
       */
     virtual void calculerAnglesEtCoordonnees(Voie* v = nullptr) = 0;
@@ -80,18 +117,18 @@ public:
       */
     virtual void calculerPositionContact()=0;
 
-    /** Permet l'exploration récursive des voies en vue de la création des segments.
-      * \param voieAppelante pointeur sur la voie appelant récursivement celle-ci.
-      * \return Une liste de liste de voies, correspondant à tous chemins partant de cette voie
-      *         et terminant sur un contact, sauf le chemin partant depuis la voie appelante.
+    /** indique par quelles extrémités une locomotive entrée par l'extrémité donnée peut
+      * ressortir, quel que soit l'état de la voie. Utilisé pour la création des segments.
+      * \param liaisonEntree l'ordre de l'extrémité d'entrée.
+      * \return un masque de bits : le bit n est à 1 si l'extrémité d'ordre n est une sortie.
       */
-    virtual QList<QList<Voie*>*> explorationContactAContact(Voie* voieAppelante)=0;
+    virtual int getSortiesPossibles(int liaisonEntree) const=0;
 
-    /** Démarre l'exploration contact à contact en vue de la création des segments.
-      * \return Une liste de liste de voies, correspondant à tous chemins partant de cette voie
-      *         et terminant sur un contact.
+    /** retourne l'ordre de l'extrémité reliée à la voie voisine.
+      * \param voisine la voie voisine.
+      * \return l'ordre de l'extrémité, 0 si la voie n'est pas voisine.
       */
-    QList<QList<Voie*>*> startExplorationContactAContact();
+    int getOrdreLiaison(Voie* voisine) const;
 
     /** retourne le nombre de liaisons (en d'autres termes d'extrémités) de la voie.
       * \return le nombre de liaisons de la voie.
@@ -156,10 +193,27 @@ public:
       */
     void setAngleRad(int liaison, qreal angle);
 
-    /** retourne la longueur a parcourir pour traverser la voie.
+    /** retourne la longueur a parcourir pour traverser la voie, dans son état actuel.
+      * La longueur est lue dans la table remplie par precalculer().
       * \return la longueur a parcourir pour traverser la voie.
       */
-    virtual qreal getLongueurAParcourir()=0;
+    qreal getLongueurAParcourir() const { return longueurs[indiceLongueur]; }
+
+    /** retourne la longueur a parcourir pour traverser la voie dans l'état donné.
+      * \param etat l'état (-1, DEVIE ou TOUT_DROIT).
+      * \return la longueur a parcourir.
+      */
+    qreal getLongueurEtat(int etat) const { return longueurs[qBound(0, etat + 1, NB_ETATS_VOIE - 1)]; }
+
+    /** retourne le genre de la voie.
+      * \return le genre de la voie.
+      */
+    virtual TypeVoie getType() const=0;
+
+    /** calcule les tables de la voie : longueur à parcourir dans chaque état et position
+      * absolue de chaque extrémité. A appeler une fois la voie posée définitivement.
+      */
+    void precalculer();
 
     /** retourne la voie suivante, en fonction de la voie d'arrivee.
       * \param voieArrivee la voie d'arrivee
@@ -167,15 +221,11 @@ public:
       */
     virtual Voie* getVoieSuivante(Voie* voieArrivee)=0;
 
-    /** fournit les informations nécessaires a l'avancement de la locomotive d'une certaine distance.
-      * \param dist la distance à parcourir
-      * \param angle l'angle de rotation
-      * \param rayon le rayon de rotation
-      * \param angleCumule l'angle actuel de la loco
-      * \param posActuelle la position actuelle de la loco en coordonnees absolues.
-      * \param voieSuivante la voie vers laquelle se dirige la loco.
+    /** relève la géométrie nécessaire au déplacement des locos sur la voie. A appeler
+      * une fois la voie posée et précalculée.
+      * \param g la géométrie à remplir. Chaque genre de voie complète la partie commune.
       */
-    virtual void avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie* voieSuivante)=0;
+    virtual void decrireGeometrie(GeometrieVoie& g) const;
 
     /** retourne la voie voisine spécifiée par son ordre.
       * \param n l'ordre de la voie
@@ -205,17 +255,28 @@ public:
       */
     void drawBoundingRect(QPainter *painter);
 
-    /** permet de corriger la position d'une locomotive par rapport à une voie.
-      * \param x la correction en X
-      * \param y la correction en Y
-      */
-    virtual void correctionPositionLoco(qreal &x, qreal &y)=0;
-
     void setIdVoie(int id);
 
     int getIdVoie();
 protected:
-    QMap<int, Voie*> ordreLiaison;
+    /** calcule la longueur à parcourir dans chaque état, avec setLongueurs().
+      * Appelée par precalculer().
+      */
+    virtual void calculerLongueurs()=0;
+
+    /** remplit la table des longueurs à parcourir.
+      * \param longueurDevie la longueur dans l'état DEVIE.
+      * \param longueurToutDroit la longueur dans l'état TOUT_DROIT.
+      * \param longueurTroisieme la longueur dans l'état -1 (aiguillage triple).
+      */
+    void setLongueurs(qreal longueurDevie, qreal longueurToutDroit, qreal longueurTroisieme);
+
+    /** sélectionne la longueur à parcourir correspondant à l'état de la voie.
+      * \param etat le nouvel état.
+      */
+    void selectionnerLongueur(int etat);
+
+    QVector<Voie*> voisines;    //!< voies voisines, indexées par ordre de liaison
     QMap<int, QPointF*> coordonneesLiaison;
     bool orientee, posee;
 
@@ -232,6 +293,10 @@ protected:
     //virtual void mousePressEvent ( QGraphicsSceneMouseEvent * event );
 private:
     QMap<int, qreal> angleLiaison;
+    qreal longueurs[NB_ETATS_VOIE];
+    int indiceLongueur;
+    QVector<QPointF> posAbsLiaisons;
+    bool precalculee;
 };
 
 #endif // VOIE_H
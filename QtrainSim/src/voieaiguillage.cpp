@@ -20,7 +20,6 @@ VoieAiguillage::VoieAiguillage(qreal angle, qreal rayon, qreal longueur, qreal d
     this->etat = 0;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 #include "ctrain_handler.h"
 
@@ -50,7 +49,7 @@ void VoieAiguillage::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
 
@@ -86,13 +85,6 @@ void VoieAiguillage::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[2]->estOrientee())
-        ordreLiaison[2]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieAiguillage::calculerPositionContact()
@@ -101,211 +93,30 @@ void VoieAiguillage::calculerPositionContact()
     this->contact->setPos(0.0,0.0);
 }
 
-QList<QList<Voie*>*> VoieAiguillage::explorationContactAContact(Voie* voieAppelante)
+int VoieAiguillage::getSortiesPossibles(int liaisonEntree) const
 {
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
-    {
-        if(ordreLiaison.key(voieAppelante) == 0)
-        {
-            temp.append(ordreLiaison[1]->explorationContactAContact(this));
-            temp.append(ordreLiaison[2]->explorationContactAContact(this));
-        }
-        else
-        {
-            temp.append(ordreLiaison[0]->explorationContactAContact(this));
-        }
-
-        foreach(QList<Voie*>* lv, temp)
-        {
-            lv->prepend(this);
-        }
-    }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
+    if(liaisonEntree == 0)
+        return (1 << 1) | (1 << 2);
+    return (1 << 0);
 }
 
-qreal VoieAiguillage::getLongueurAParcourir()
+void VoieAiguillage::calculerLongueurs()
 {
-    if(etat == TOUT_DROIT)
-    {
-        return longueur;
-    }
-    else
-    {
-        return 2.0 * (angle * PI / 180.0) * rayon;
-    }
+    qreal devie = 2.0 * (angle * PI / 180.0) * rayon;
+    setLongueurs(devie, longueur, devie);
 }
 
-void VoieAiguillage::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante)
+void VoieAiguillage::decrireGeometrie(GeometrieVoie &g) const
 {
-    if(ordreLiaison.key(voieSuivante) == 0)
-    {
-        if(normaliserAngle(angleCumule - getAngleDeg(1) - 180.0) < 1.0 &&
-           normaliserAngle(angleCumule - getAngleDeg(1) - 180.0) > -1.0)
-        {
-            angle = 0.0;
-            rayon = 0.0;
-
-            if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                    (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) < dist)
-            {
-                dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                             (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()));
-            }
-            else
-            {
-                dist = 0.0;
-            }
-        }
-        else
-        {
-            rayon = this->rayon;
-
-            qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-            qreal angleRestant = (getAngleDeg(0) + 360.0) - (angleCumule + 360.0);
-
-            while(angleRestant < - this->angle)
-            {
-                angleRestant += 360.0;
-            }
-            if(angleRestant > this->angle)
-            {
-                angleRestant -= 360.0;
-            }
-
-            if(angleRestant < 0.0)
-            {
-                if(- angleRestant < angleAParcourir)
-                {
-                    dist -= - angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = - angleAParcourir;
-                }
-            }
-            else
-            {
-                if(angleRestant < angleAParcourir)
-                {
-                    dist -= angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = angleAParcourir;
-                }
-            }
-        }
-    }
-    else
-    {
-        if(etat == TOUT_DROIT)
-        {
-            angle = 0.0;
-            rayon = 0.0;
-
-            if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                    (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) < dist)
-            {
-                dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                             (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()));
-            }
-            else
-            {
-                dist = 0.0;
-            }
-        }
-        else
-        {
-            rayon = this->rayon;
-
-            qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-            qreal angleRestant = (getAngleDeg(2) + 360.0) - (angleCumule + 360.0);
-
-            while(angleRestant < - this->angle)
-            {
-                angleRestant += 360.0;
-            }
-            if(angleRestant > this->angle)
-            {
-                angleRestant -= 360.0;
-            }
-
-            if(angleRestant < 0.0)
-            {
-                if(- angleRestant < angleAParcourir)
-                {
-                    dist -= - angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = - angleAParcourir;
-                }
-            }
-            else
-            {
-                if(angleRestant < angleAParcourir)
-                {
-                    dist -= angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = angleAParcourir;
-                }
-            }
-        }
-    }
-
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
-    else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-    {
-        lastDistDel = 1000.0;
-    }
+    Voie::decrireGeometrie(g);
+    g.rayon = rayon;
+    g.angle = angle;
 }
 
 void VoieAiguillage::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //correction
-    if(ordreLiaison.key(v) == 0)
+    if(getOrdreLiaison(v) == 0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -315,8 +126,8 @@ void VoieAiguillage::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
     }
     else
     {
-        coordonneesLiaison[ordreLiaison.key(v)]->setX(coordonneesLiaison[ordreLiaison.key(v)]->x() + deltaX);
-        coordonneesLiaison[ordreLiaison.key(v)]->setY(coordonneesLiaison[ordreLiaison.key(v)]->y() + deltaY);
+        coordonneesLiaison[getOrdreLiaison(v)]->setX(coordonneesLiaison[getOrdreLiaison(v)]->x() + deltaX);
+        coordonneesLiaison[getOrdreLiaison(v)]->setY(coordonneesLiaison[getOrdreLiaison(v)]->y() + deltaY);
     }
 
     qreal nouvelleCorde = sqrt(coordonneesLiaison[2]->x() *
@@ -342,12 +153,6 @@ void VoieAiguillage::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 }
 
 
-void VoieAiguillage::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
-{
-    //TODO
-}
-
-
 #define min(a,b) (a<b?a:b)
 #define min3(a,b,c) (a<min(b,c)?a:min(b,c))
 
@@ -433,18 +238,18 @@ Voie* VoieAiguillage::getVoieSuivante(Voie *voieArrivee)
 {
     //gestion des deraillements!
 
-    int ordreVoieArrivee = ordreLiaison.key(voieArrivee);
+    int ordreVoieArrivee = getOrdreLiaison(voieArrivee);
 
     if(ordreVoieArrivee == 0)
     {
         if(etat == TOUT_DROIT)
         {
-            return ordreLiaison.value(1);
+            return voisines.value(1);
         }
         else
         {
-            return ordreLiaison.value(2);
+            return voisines.value(2);
         }
     }
-    else return ordreLiaison.value(0);
+    else return voisines.value(0);
 }
@@ -13,7 +13,6 @@ VoieAiguillageEnroule::VoieAiguillageEnroule(qreal angle, qreal rayon, qreal lon
     this->etat = 0;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 
 void VoieAiguillageEnroule::mousePressEvent ( QGraphicsSceneMouseEvent * /*event*/ )
@@ -37,7 +36,7 @@ void VoieAiguillageEnroule::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
 
@@ -77,19 +76,6 @@ void VoieAiguillageEnroule::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[2]->estOrientee())
-        ordreLiaison[2]->calculerAnglesEtCoordonnees(this);
-}
-
-
-void VoieAiguillageEnroule::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
-{
-    //TODO
 }
 
 
@@ -99,309 +85,33 @@ void VoieAiguillageEnroule::calculerPositionContact()
     this->contact->setPos(0.0,0.0);
 }
 
-QList<QList<Voie*>*> VoieAiguillageEnroule::explorationContactAContact(Voie* voieAppelante)
+int VoieAiguillageEnroule::getSortiesPossibles(int liaisonEntree) const
 {
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
-    {
-        if(ordreLiaison.key(voieAppelante) == 0)
-        {
-            temp.append(ordreLiaison[1]->explorationContactAContact(this));
-            temp.append(ordreLiaison[2]->explorationContactAContact(this));
-        }
-        else
-        {
-            temp.append(ordreLiaison[0]->explorationContactAContact(this));
-        }
-
-        foreach(QList<Voie*>* lv, temp)
-        {
-            lv->prepend(this);
-        }
-    }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
+    if(liaisonEntree == 0)
+        return (1 << 1) | (1 << 2);
+    return (1 << 0);
 }
 
-qreal VoieAiguillageEnroule::getLongueurAParcourir()
+void VoieAiguillageEnroule::calculerLongueurs()
 {
-    if(etat == TOUT_DROIT)
-    {
-        return longueur + 2.0 * (angle * PI / 180.0) * rayonExterieur;
-    }
-    else
-    {
-        return 2.0 * (angle * PI / 180.0) * rayonInterieur;
-    }
+    qreal devie = 2.0 * (angle * PI / 180.0) * rayonInterieur;
+    setLongueurs(devie, longueur + 2.0 * (angle * PI / 180.0) * rayonExterieur, devie);
 }
 
-void VoieAiguillageEnroule::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante)
+void VoieAiguillageEnroule::decrireGeometrie(GeometrieVoie &g) const
 {
-    QPointF positionLocoRelative = mapFromParent(posActuelle);
-
-    if(ordreLiaison.key(voieSuivante) == 0)
-    {
-        if(sqrt((positionLocoRelative.x() - centreInterieur.x()) * (positionLocoRelative.x() - centreInterieur.x()) +
-                (positionLocoRelative.y() - centreInterieur.y()) * (positionLocoRelative.y() - centreInterieur.y())) - this->rayonInterieur < 0.1 &&
-           sqrt((positionLocoRelative.x() - centreInterieur.x()) * (positionLocoRelative.x() - centreInterieur.x()) +
-                (positionLocoRelative.y() - centreInterieur.y()) * (positionLocoRelative.y() - centreInterieur.y())) - this->rayonInterieur > -0.1)
-        {
-            rayon = this->rayonInterieur;
-
-            qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-            qreal angleRestant = (getAngleDeg(0) + 360.0) - (angleCumule + 360.0);
-
-            while(angleRestant < - this->angle)
-            {
-                angleRestant += 360.0;
-            }
-            if(angleRestant > this->angle)
-            {
-                angleRestant -= 360.0;
-            }
-
-            if(angleRestant < 0.0)
-            {
-                if(- angleRestant < angleAParcourir)
-                {
-                    dist -= - angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = - angleAParcourir;
-                }
-            }
-            else
-            {
-                if(angleRestant < angleAParcourir)
-                {
-                    dist -= angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = angleAParcourir;
-                }
-            }
-        }
-        else
-        {
-            if(sqrt((positionLocoRelative.x()) * (positionLocoRelative.x()) +
-                    (positionLocoRelative.y()) * (positionLocoRelative.y())) < longueur)
-            {
-                angle = 0.0;
-                rayon = 0.0;
-
-                if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                        (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                        (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                        (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) < dist)
-                {
-                    dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                                 (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                                 (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                                 (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()));
-                }
-                else
-                {
-                    dist = 0.0;
-                }
-            }
-            else
-            {
-                rayon = this->rayonExterieur;
-
-                qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-                qreal angleRestant = (getAngleDeg(ordreLiaison.key(voieSuivante)) + 360.0) - (angleCumule + 360.0);
-
-                while(angleRestant < - this->angle * 2.0)
-                {
-                    angleRestant += 360.0;
-                }
-                while(angleRestant > this->angle * 2.0)
-                {
-                    angleRestant -= 360.0;
-                }
-
-                if(angleRestant < 0.0)
-                {
-                    if(- angleRestant < angleAParcourir)
-                    {
-                        dist -= - angleRestant * (PI / 180.0) * rayon;
-                        angle = angleRestant;
-                    }
-                    else
-                    {
-                        dist = 0.0;
-                        angle = - angleAParcourir;
-                    }
-                }
-                else
-                {
-                    if(angleRestant < angleAParcourir)
-                    {
-                        dist -= angleRestant * (PI / 180.0) * rayon;
-                        angle = angleRestant;
-                    }
-                    else
-                    {
-                        dist = 0.0;
-                        angle = angleAParcourir;
-                    }
-                }
-            }
-        }
-    }
-    else
-    {
-        if(etat == TOUT_DROIT)
-        {
-            if(sqrt((positionLocoRelative.x()) * (positionLocoRelative.x()) +
-                    (positionLocoRelative.y()) * (positionLocoRelative.y())) < longueur)
-            {
-                angle = 0.0;
-                rayon = 0.0;
-
-                if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                        (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                        (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                        (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) - longueur < dist)
-                {
-                    dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                                 (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                                 (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                                 (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) - longueur;
-                }
-                else
-                {
-                    dist = 0.0;
-                }
-            }
-            else
-            {
-                rayon = this->rayonExterieur;
-
-                qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-                qreal angleRestant = (getAngleDeg(ordreLiaison.key(voieSuivante)) + 360.0) - (angleCumule + 360.0);
-
-                while(angleRestant < - this->angle * 2.0)
-                {
-                    angleRestant += 360.0;
-                }
-                while(angleRestant > this->angle * 2.0)
-                {
-                    angleRestant -= 360.0;
-                }
-
-                if(angleRestant < 0.0)
-                {
-                    if(- angleRestant < angleAParcourir)
-                    {
-                        dist -= - angleRestant * (PI / 180.0) * rayon;
-                        angle = angleRestant;
-                    }
-                    else
-                    {
-                        dist = 0.0;
-                        angle = - angleAParcourir;
-                    }
-                }
-                else
-                {
-                    if(angleRestant < angleAParcourir)
-                    {
-                        dist -= angleRestant * (PI / 180.0) * rayon;
-                        angle = angleRestant;
-                    }
-                    else
-                    {
-                        dist = 0.0;
-                        angle = angleAParcourir;
-                    }
-                }
-            }
-        }
-        else
-        {
-            rayon = this->rayonInterieur;
-
-            qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-            qreal angleRestant = (getAngleDeg(2) + 360.0) - (angleCumule + 360.0);
-
-            while(angleRestant < - this->angle)
-            {
-                angleRestant += 360.0;
-            }
-            if(angleRestant > this->angle)
-            {
-                angleRestant -= 360.0;
-            }
-
-            if(angleRestant < 0.0)
-            {
-                if(- angleRestant < angleAParcourir)
-                {
-                    dist -= - angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = - angleAParcourir;
-                }
-            }
-            else
-            {
-                if(angleRestant < angleAParcourir)
-                {
-                    dist -= angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = angleAParcourir;
-                }
-            }
-        }
-    }
-
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
-    else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-        lastDistDel = 1000.0;
+    Voie::decrireGeometrie(g);
+    g.rayon = rayonInterieur;
+    g.rayon2 = rayonExterieur;
+    g.angle = angle;
+    g.longueur = longueur;
+    g.centre = centreInterieur;
 }
 
 void VoieAiguillageEnroule::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //correction
-    if(ordreLiaison.key(v) == 0)
+    if(getOrdreLiaison(v) == 0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -411,8 +121,8 @@ void VoieAiguillageEnroule::correctionPosition(qreal deltaX, qreal deltaY, Voie
     }
     else
     {
-        coordonneesLiaison[ordreLiaison.key(v)]->setX(coordonneesLiaison[ordreLiaison.key(v)]->x() + deltaX);
-        coordonneesLiaison[ordreLiaison.key(v)]->setY(coordonneesLiaison[ordreLiaison.key(v)]->y() + deltaY);
+        coordonneesLiaison[getOrdreLiaison(v)]->setX(coordonneesLiaison[getOrdreLiaison(v)]->x() + deltaX);
+        coordonneesLiaison[getOrdreLiaison(v)]->setY(coordonneesLiaison[getOrdreLiaison(v)]->y() + deltaY);
     }
 
     qreal nouvelleCorde = sqrt(coordonneesLiaison[2]->x() *
@@ -548,18 +258,18 @@ Voie* VoieAiguillageEnroule::getVoieSuivante(Voie *voieArrivee)
 {
     //gestion des deraillements!
 
-    int ordreVoieArrivee = ordreLiaison.key(voieArrivee);
+    int ordreVoieArrivee = getOrdreLiaison(voieArrivee);
 
     if(ordreVoieArrivee == 0)
     {
         if(etat == TOUT_DROIT)
         {
-            return ordreLiaison.value(1);
+            return voisines.value(1);
         }
         else
         {
-            return ordreLiaison.value(2);
+            return voisines.value(2);
         }
     }
-    else return ordreLiaison.value(0);
+    else return voisines.value(0);
 }
@@ -19,7 +19,6 @@ VoieAiguillageTriple::VoieAiguillageTriple(qreal angle, qreal rayon, qreal longu
     this->etat = 0;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 
 void VoieAiguillageTriple::mousePressEvent ( QGraphicsSceneMouseEvent * /*event*/ )
@@ -45,7 +44,7 @@ void VoieAiguillageTriple::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
 
@@ -94,15 +93,6 @@ void VoieAiguillageTriple::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[2]->estOrientee())
-        ordreLiaison[2]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[3]->estOrientee())
-        ordreLiaison[3]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieAiguillageTriple::calculerPositionContact()
@@ -111,250 +101,34 @@ void VoieAiguillageTriple::calculerPositionContact()
     this->contact->setPos(0.0,0.0);
 }
 
-QList<QList<Voie*>*> VoieAiguillageTriple::explorationContactAContact(Voie* voieAppelante)
-{
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
-    {
-        if(ordreLiaison.key(voieAppelante) == 0)
-        {
-            temp.append(ordreLiaison[1]->explorationContactAContact(this));
-            temp.append(ordreLiaison[2]->explorationContactAContact(this));
-            temp.append(ordreLiaison[3]->explorationContactAContact(this));
-        }
-        else
-        {
-            temp.append(ordreLiaison[0]->explorationContactAContact(this));
-        }
-
-        foreach(QList<Voie*>* lv, temp)
-        {
-            lv->prepend(this);
-        }
-    }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
-}
-
-qreal VoieAiguillageTriple::getLongueurAParcourir()
+int VoieAiguillageTriple::getSortiesPossibles(int liaisonEntree) const
 {
-    if(etat == TOUT_DROIT)
-    {
-        return longueur;
-    }
-    else if(etat == -1)
-    {
-        return 2.0 * (angle * PI / 180.0) * rayonDroite;
-    }
-    else
-    {
-        return 2.0 * (angle * PI / 180.0) * rayonGauche;
-    }
+    if(liaisonEntree == 0)
+        return (1 << 1) | (1 << 2) | (1 << 3);
+    return (1 << 0);
 }
 
-void VoieAiguillageTriple::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante)
+void VoieAiguillageTriple::calculerLongueurs()
 {
-    QPointF positionLocoRelative = mapFromParent(posActuelle);
-
-    if(ordreLiaison.key(voieSuivante) == 0)
-    {
-        if(angleCumule == normaliserAngle(getAngleDeg(1) - 180.0))
-        {
-            angle = 0.0;
-            rayon = 0.0;
-
-            if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                    (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) < dist)
-            {
-                dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                             (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()));
-            }
-            else
-            {
-                dist = 0.0;
-            }
-        }
-        else
-        {
-            if(sqrt((positionLocoRelative.x() - centreGauche.x()) *
-                    (positionLocoRelative.x() - centreGauche.x()) +
-                    (positionLocoRelative.y() - centreGauche.y()) *
-                    (positionLocoRelative.y() - centreGauche.y())) - rayonGauche < 0.1 &&
-               sqrt((positionLocoRelative.x() - centreGauche.x()) *
-                    (positionLocoRelative.x() - centreGauche.x()) +
-                    (positionLocoRelative.y() - centreGauche.y()) *
-                    (positionLocoRelative.y() - centreGauche.y())) - rayonGauche > -0.1)
-            {
-                rayon = this->rayonGauche;
-            }
-            else
-            {
-                rayon = this->rayonDroite;
-            }
-
-            qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-            qreal angleRestant = (getAngleDeg(0) + 360.0) - (angleCumule + 360.0);
-
-            while(angleRestant < - this->angle)
-            {
-                angleRestant += 360.0;
-            }
-            if(angleRestant > this->angle)
-            {
-                angleRestant -= 360.0;
-            }
-
-            if(angleRestant < 0.0)
-            {
-                if(- angleRestant < angleAParcourir)
-                {
-                    dist -= - angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = - angleAParcourir;
-                }
-            }
-            else
-            {
-                if(angleRestant < angleAParcourir)
-                {
-                    dist -= angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = angleAParcourir;
-                }
-            }
-        }
-    }
-    else
-    {
-        if(etat == TOUT_DROIT)
-        {
-            angle = 0.0;
-            rayon = 0.0;
-
-            if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                    (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                    (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) < dist)
-            {
-                dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                             (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                             (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()));
-            }
-            else
-            {
-                dist = 0.0;
-            }
-        }
-        else
-        {
-            if(sqrt((positionLocoRelative.x() - centreGauche.x()) *
-                    (positionLocoRelative.x() - centreGauche.x()) +
-                    (positionLocoRelative.y() - centreGauche.y()) *
-                    (positionLocoRelative.y() - centreGauche.y())) - rayonGauche < 0.1 &&
-               sqrt((positionLocoRelative.x() - centreGauche.x()) *
-                    (positionLocoRelative.x() - centreGauche.x()) +
-                    (positionLocoRelative.y() - centreGauche.y()) *
-                    (positionLocoRelative.y() - centreGauche.y())) - rayonGauche > -0.1)
-            {
-                rayon = this->rayonGauche;
-            }
-            else
-            {
-                rayon = this->rayonDroite;
-            }
-
-            qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-            qreal angleRestant = (getAngleDeg(ordreLiaison.key(voieSuivante)) + 360.0) - (angleCumule + 360.0);
-
-            while(angleRestant < - this->angle)
-            {
-                angleRestant += 360.0;
-            }
-            if(angleRestant > this->angle)
-            {
-                angleRestant -= 360.0;
-            }
-
-            if(angleRestant < 0.0)
-            {
-                if(- angleRestant < angleAParcourir)
-                {
-                    dist -= - angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = - angleAParcourir;
-                }
-            }
-            else
-            {
-                if(angleRestant < angleAParcourir)
-                {
-                    dist -= angleRestant * (PI / 180.0) * rayon;
-                    angle = angleRestant;
-                }
-                else
-                {
-                    dist = 0.0;
-                    angle = angleAParcourir;
-                }
-            }
-        }
-    }
-
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
-    else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-        lastDistDel = 1000.0;
+    setLongueurs(2.0 * (angle * PI / 180.0) * rayonGauche,
+                 longueur,
+                 2.0 * (angle * PI / 180.0) * rayonDroite);
 }
 
-
-void VoieAiguillageTriple::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
+void VoieAiguillageTriple::decrireGeometrie(GeometrieVoie &g) const
 {
-    //TODO
+    Voie::decrireGeometrie(g);
+    g.rayon = rayonGauche;
+    g.rayon2 = rayonDroite;
+    g.angle = angle;
+    g.centre = centreGauche;
 }
 
 
 void VoieAiguillageTriple::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //correction
-    if(ordreLiaison.key(v) == 0)
+    if(getOrdreLiaison(v) == 0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -366,8 +140,8 @@ void VoieAiguillageTriple::correctionPosition(qreal deltaX, qreal deltaY, Voie *
     }
     else
     {
-        coordonneesLiaison[ordreLiaison.key(v)]->setX(coordonneesLiaison[ordreLiaison.key(v)]->x() + deltaX);
-        coordonneesLiaison[ordreLiaison.key(v)]->setY(coordonneesLiaison[ordreLiaison.key(v)]->y() + deltaY);
+        coordonneesLiaison[getOrdreLiaison(v)]->setX(coordonneesLiaison[getOrdreLiaison(v)]->x() + deltaX);
+        coordonneesLiaison[getOrdreLiaison(v)]->setY(coordonneesLiaison[getOrdreLiaison(v)]->y() + deltaY);
     }
 
     //modifications pour courbe gauche.
@@ -509,18 +283,18 @@ Voie* VoieAiguillageTriple::getVoieSuivante(Voie *voieArrivee)
 {
     //gestion des deraillements!
 
-    int ordreVoieArrivee = ordreLiaison.key(voieArrivee);
+    int ordreVoieArrivee = getOrdreLiaison(voieArrivee);
 
     if(ordreVoieArrivee == 0)
     {
         if(etat == TOUT_DROIT)
         {
-            return ordreLiaison.value(1);
+            return voisines.value(1);
         }
         else
         {
-            return ordreLiaison.value(2);
+            return voisines.value(2);
         }
     }
-    else return ordreLiaison.value(0);
+    else return voisines.value(0);
 }
@@ -11,12 +11,12 @@ public:
     void setNumVoieVariable(int numVoieVariable) override;
     void calculerAnglesEtCoordonnees(Voie *v) override;
     void calculerPositionContact() override;
-    QList<QList<Voie*>*> explorationContactAContact(Voie* voieAppelante) override;
-    qreal getLongueurAParcourir() override;
+    int getSortiesPossibles(int liaisonEntree) const override;
+    TypeVoie getType() const override { return TypeVoie::AIGUILLAGE_TRIPLE; }
+    void calculerLongueurs() override;
     Voie* getVoieSuivante(Voie* voieArrivee) override;
-    void avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante) override;
+    void decrireGeometrie(GeometrieVoie& g) const override;
     void correctionPosition(qreal deltaX, qreal deltaY, Voie *v) override;
-    void correctionPositionLoco(qreal &, qreal &) override;
     QRectF boundingRect() const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *) override;
 
@@ -25,7 +25,6 @@ private:
     qreal rayonGauche, rayonDroite, angle, longueur;
     QPointF centreGauche;
     QPointF centreDroite;
-    qreal lastDistDel;
 };
 
 #endif // VOIEAIGUILLAGETRIPLE_H
@@ -28,9 +28,6 @@ void VoieButtoir::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieButtoir::calculerPositionContact()
@@ -39,19 +36,15 @@ void VoieButtoir::calculerPositionContact()
     this->contact->setPos(0.0,0.0);
 }
 
-QList<QList<Voie*>*> VoieButtoir::explorationContactAContact(Voie */*voieAppelante*/)
+int VoieButtoir::getSortiesPossibles(int /*liaisonEntree*/) const
 {
-    QList<QList<Voie*>*> temp;
-
-    temp.append(new QList<Voie*>);
-    temp.at(0)->append(this);
-
-    return temp;
+    // Fin de voie : aucune sortie
+    return 0;
 }
 
-qreal VoieButtoir::getLongueurAParcourir()
+void VoieButtoir::calculerLongueurs()
 {
-    return longueur;
+    setLongueurs(longueur, longueur, longueur);
 }
 
 Voie* VoieButtoir::getVoieSuivante(Voie */*voieArrivee*/)
@@ -60,37 +53,10 @@ Voie* VoieButtoir::getVoieSuivante(Voie */*voieArrivee*/)
     return nullptr;
 }
 
-void VoieButtoir::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal /*angleCumule*/, QPointF posActuelle, Voie *voieSuivante)
+void VoieButtoir::decrireGeometrie(GeometrieVoie &g) const
 {
-    angle = 0.0;
-    rayon = 0.0;
-
-    qreal distanceAuContact = sqrt((posActuelle.x() - this->pos().x()) *
-                                   (posActuelle.x() - this->pos().x()) +
-                                   (posActuelle.y() - this->pos().y()) *
-                                   (posActuelle.y() - this->pos().y()));
-    if (distanceAuContact + LONGUEUR_LOCO / 2.0 > longueur)
-    {
-        //déclarer un deraillement.
-    }
-    else
-    {
-        if(voieSuivante == nullptr)
-        {
-            dist = 0.0;
-        }
-        else
-        {
-            if(distanceAuContact < dist)
-            {
-                dist -= distanceAuContact;
-            }
-            else
-            {
-                dist = 0.0;
-            }
-        }
-    }
+    Voie::decrireGeometrie(g);
+    g.longueur = longueur;
 }
 
 
@@ -105,12 +71,6 @@ void VoieButtoir::correctionPosition(qreal deltaX, qreal deltaY, Voie */*v*/)
 }
 
 
-void VoieButtoir::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
-{
-    //TODO
-}
-
-
 #define min(a,b) ((a<b)?(a):(b))
 
 QRectF VoieButtoir::boundingRect() const
@@ -12,12 +12,12 @@ public:
     VoieButtoir(qreal longueur);
     void calculerAnglesEtCoordonnees(Voie *v) override;
     void calculerPositionContact() override;
-    QList<QList<Voie*>*> explorationContactAContact(Voie *) override;
-    qreal getLongueurAParcourir() override;
+    int getSortiesPossibles(int liaisonEntree) const override;
+    TypeVoie getType() const override { return TypeVoie::BUTTOIR; }
+    void calculerLongueurs() override;
     Voie* getVoieSuivante(Voie*) override;
-    void avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal, QPointF posActuelle, Voie *voieSuivante) override;
+    void decrireGeometrie(GeometrieVoie& g) const override;
     void correctionPosition(qreal deltaX, qreal deltaY, Voie *) override;
-    void correctionPositionLoco(qreal &, qreal &) override;
     QRectF boundingRect() const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *) override;
     void setEtat(int) override;
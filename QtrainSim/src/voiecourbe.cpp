@@ -9,7 +9,6 @@ VoieCourbe::VoieCourbe(qreal angle, qreal rayon, int direction)
     this->direction = direction;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 
 void VoieCourbe::calculerAnglesEtCoordonnees(Voie *v)
@@ -22,7 +21,7 @@ void VoieCourbe::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
 
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
@@ -52,11 +51,6 @@ void VoieCourbe::calculerAnglesEtCoordonnees(Voie *v)
     }
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieCourbe::calculerPositionContact()
@@ -66,108 +60,33 @@ void VoieCourbe::calculerPositionContact()
     this->contact->setAngle(atan2(- coordonneesLiaison[1]->y(), - coordonneesLiaison[1]->x()) + direction * PI / 2.0);
 }
 
-QList<QList<Voie*>*> VoieCourbe::explorationContactAContact(Voie* voieAppelante)
+int VoieCourbe::getSortiesPossibles(int liaisonEntree) const
 {
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
-    {
-        if(ordreLiaison.key(voieAppelante) == 0)
-            temp.append(ordreLiaison.value(1)->explorationContactAContact(this));
-        else
-            temp.append(ordreLiaison.value(0)->explorationContactAContact(this));
-
-        for(int i=0; i< temp.length(); i++)
-        {
-            temp.at(i)->prepend(this);
-        }
-    }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
+    return liaisonEntree == 0 ? (1 << 1) : (1 << 0);
 }
 
-qreal VoieCourbe::getLongueurAParcourir()
+void VoieCourbe::calculerLongueurs()
 {
-    return 2.0 * (angle * PI / 180.0) * rayon;
+    qreal l = 2.0 * (angle * PI / 180.0) * rayon;
+    setLongueurs(l, l, l);
 }
 
 Voie* VoieCourbe::getVoieSuivante(Voie *voieArrivee)
 {
-    return ordreLiaison.value((ordreLiaison.key(voieArrivee) +1) % 2);
+    return voisines.value((getOrdreLiaison(voieArrivee) +1) % 2);
 }
 
-void VoieCourbe::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante)
+void VoieCourbe::decrireGeometrie(GeometrieVoie &g) const
 {
-    rayon = this->rayon;
-
-    qreal angleAParcourir = (dist / this->rayon) * (180.0 / PI);
-
-    qreal angleRestant = (getAngleDeg(ordreLiaison.key(voieSuivante)) + 360.0) - (angleCumule + 360.0);
-
-    while(angleRestant < - this->angle * 2.0)
-    {
-        angleRestant += 360.0;
-    }
-    while(angleRestant > this->angle * 2.0)
-    {
-        angleRestant -= 360.0;
-    }
-
-    if(angleRestant < 0.0)
-    {
-        if(- angleRestant < angleAParcourir)
-        {
-            dist -= - angleRestant * (PI / 180.0) * rayon;
-            angle = angleRestant;
-        }
-        else
-        {
-            dist = 0.0;
-            angle = - angleAParcourir;
-        }
-    }
-    else
-    {
-        if(angleRestant < angleAParcourir)
-        {
-            dist -= angleRestant * (PI / 180.0) * rayon;
-            angle = angleRestant;
-        }
-        else
-        {
-            dist = 0.0;
-            angle = angleAParcourir;
-        }
-    }
-
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
-    else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-        lastDistDel = 1000.0;
+    Voie::decrireGeometrie(g);
+    g.rayon = rayon;
+    g.angle = angle;
 }
 
 void VoieCourbe::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //correction...
-    if(ordreLiaison.key(v) ==0)
+    if(getOrdreLiaison(v) ==0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -201,12 +120,6 @@ void VoieCourbe::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 }
 
 
-void VoieCourbe::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
-{
-    //TODO
-}
-
-
 QRectF VoieCourbe::boundingRect() const
 {
     return QRectF(QPointF(-200.0, -200.0),
@@ -12,12 +12,12 @@ public:
     VoieCourbe(qreal angle, qreal rayon, int direction);
     void calculerAnglesEtCoordonnees(Voie *v) override;
     void calculerPositionContact() override;
-    QList<QList<Voie*>*> explorationContactAContact(Voie* voieAppelante) override;
-    qreal getLongueurAParcourir() override;
+    int getSortiesPossibles(int liaisonEntree) const override;
+    TypeVoie getType() const override { return TypeVoie::COURBE; }
+    void calculerLongueurs() override;
     Voie* getVoieSuivante(Voie* voieArrivee) override;
-    void avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante) override;
+    void decrireGeometrie(GeometrieVoie& g) const override;
     void correctionPosition(qreal deltaX, qreal deltaY, Voie *v) override;
-    void correctionPositionLoco(qreal &, qreal &) override;
     QRectF boundingRect() const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *) override;
     void setEtat(int) override;
@@ -26,7 +26,6 @@ private:
     QPointF centre;
     qreal rayon, angle;
     int direction;
-    qreal lastDistDel;
 };
 
 #endif // VOIECOURBE_H
@@ -8,7 +8,6 @@ VoieCroisement::VoieCroisement(qreal angle, qreal longueur)
     this->longueur = longueur;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 
 void VoieCroisement::calculerAnglesEtCoordonnees(Voie *v)
@@ -21,7 +20,7 @@ void VoieCroisement::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
 
@@ -64,15 +63,6 @@ void VoieCroisement::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[2]->estOrientee())
-        ordreLiaison[2]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[3]->estOrientee())
-        ordreLiaison[3]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieCroisement::calculerPositionContact()
@@ -81,99 +71,42 @@ void VoieCroisement::calculerPositionContact()
     this->contact->setPos(0.0,0.0);
 }
 
-QList<QList<Voie*>*> VoieCroisement::explorationContactAContact(Voie* voieAppelante)
+int VoieCroisement::getSortiesPossibles(int liaisonEntree) const
 {
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
+    // 0 <-> 1 et 2 <-> 3
+    switch(liaisonEntree)
     {
-        if(ordreLiaison.key(voieAppelante) == 0)
-        {
-            temp.append(ordreLiaison[1]->explorationContactAContact(this));
-        }
-        else if(ordreLiaison.key(voieAppelante) == 1)
-        {
-            temp.append(ordreLiaison[0]->explorationContactAContact(this));
-        }
-        else if(ordreLiaison.key(voieAppelante) == 2)
-        {
-            temp.append(ordreLiaison[3]->explorationContactAContact(this));
-        }
-        else if(ordreLiaison.key(voieAppelante) == 3)
-        {
-            temp.append(ordreLiaison[2]->explorationContactAContact(this));
-        }
-
-        foreach(QList<Voie*>* lv, temp)
-        {
-            lv->prepend(this);
-        }
+    case 0: return (1 << 1);
+    case 1: return (1 << 0);
+    case 2: return (1 << 3);
+    case 3: return (1 << 2);
     }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
+    return 0;
 }
 
-qreal VoieCroisement::getLongueurAParcourir()
+void VoieCroisement::calculerLongueurs()
 {
-    return longueur;
+    setLongueurs(longueur, longueur, longueur);
 }
 
 Voie* VoieCroisement::getVoieSuivante(Voie *voieArrivee)
 {
-    int ordreVoieArrivee = ordreLiaison.key(voieArrivee);
+    int ordreVoieArrivee = getOrdreLiaison(voieArrivee);
 
     if( ordreVoieArrivee == 0)
-        return ordreLiaison.value(1);
+        return voisines.value(1);
     else if (ordreVoieArrivee == 1)
-        return ordreLiaison.value(0);
+        return voisines.value(0);
     else if (ordreVoieArrivee == 2)
-        return ordreLiaison.value(3);
-    else
-        return ordreLiaison.value(2);
-}
-
-void VoieCroisement::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal /*angleCumule*/, QPointF posActuelle, Voie *voieSuivante)
-{
-    angle = 0.0;
-    rayon = 0.0;
-
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(distDel < dist)
-    {
-        dist -= distDel;
-    }
-    else
-    {
-        dist = 0.0;
-    }
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
+        return voisines.value(3);
     else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-        lastDistDel = 1000.0;
+        return voisines.value(2);
 }
 
 void VoieCroisement::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //correction
-    if(ordreLiaison.key(v) == 0)
+    if(getOrdreLiaison(v) == 0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -185,8 +118,8 @@ void VoieCroisement::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
     }
     else
     {
-        coordonneesLiaison[ordreLiaison.key(v)]->setX(coordonneesLiaison[ordreLiaison.key(v)]->x() + deltaX);
-        coordonneesLiaison[ordreLiaison.key(v)]->setY(coordonneesLiaison[ordreLiaison.key(v)]->y() + deltaY);
+        coordonneesLiaison[getOrdreLiaison(v)]->setX(coordonneesLiaison[getOrdreLiaison(v)]->x() + deltaX);
+        coordonneesLiaison[getOrdreLiaison(v)]->setY(coordonneesLiaison[getOrdreLiaison(v)]->y() + deltaY);
     }
 
     if(this->contact != nullptr)
@@ -194,12 +127,6 @@ void VoieCroisement::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 }
 
 
-void VoieCroisement::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
-{
-    //TODO
-}
-
-
 QRectF VoieCroisement::boundingRect() const
 {
     return QRectF(QPointF(-200.0, -200.0),
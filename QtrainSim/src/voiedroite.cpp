@@ -7,7 +7,6 @@ VoieDroite::VoieDroite(qreal longueur)
     this->longueur = longueur;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 
 void VoieDroite::calculerAnglesEtCoordonnees(Voie *v)
@@ -20,7 +19,7 @@ void VoieDroite::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
 
@@ -43,11 +42,6 @@ void VoieDroite::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieDroite::calculerPositionContact()
@@ -56,72 +50,32 @@ void VoieDroite::calculerPositionContact()
     this->contact->setAngle(atan2(- coordonneesLiaison[1]->y(), - coordonneesLiaison[1]->x()) + PI / 2.0);
 }
 
-QList<QList<Voie*>*> VoieDroite::explorationContactAContact(Voie* voieAppelante)
+int VoieDroite::getSortiesPossibles(int liaisonEntree) const
 {
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
-    {
-        if(ordreLiaison.key(voieAppelante) == 0)
-            temp.append(ordreLiaison.value(1)->explorationContactAContact(this));
-        else
-            temp.append(ordreLiaison.value(0)->explorationContactAContact(this));
-
-        for(int i=0; i< temp.length(); i++)
-        {
-            temp.at(i)->prepend(this);
-        }
-    }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
+    return liaisonEntree == 0 ? (1 << 1) : (1 << 0);
 }
 
-qreal VoieDroite::getLongueurAParcourir()
+void VoieDroite::calculerLongueurs()
 {
-    return longueur;
+    setLongueurs(longueur, longueur, longueur);
 }
 
 Voie* VoieDroite::getVoieSuivante(Voie *voieArrivee)
 {
-    return ordreLiaison.value((ordreLiaison.key(voieArrivee) +1) % 2);
+    return voisines.value((getOrdreLiaison(voieArrivee) +1) % 2);
 }
 
-void VoieDroite::avanceLoco(qreal &dist, qreal &/*angle*/, qreal &/*rayon*/, qreal /*angleCumule*/, QPointF posActuelle, Voie *voieSuivante)
+void VoieDroite::decrireGeometrie(GeometrieVoie &g) const
 {
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(distDel < dist)
-        dist -= distDel;
-    else
-        dist = 0.0;
-
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
-    else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-        lastDistDel = 1000.0;
+    Voie::decrireGeometrie(g);
+    g.extremite0 = *coordonneesLiaison[0];
+    g.extremite1 = *coordonneesLiaison[1];
 }
 
 void VoieDroite::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //Correction...
-    if(ordreLiaison.key(v) == 0)
+    if(getOrdreLiaison(v) == 0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -142,40 +96,6 @@ void VoieDroite::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 }
 
 
-void VoieDroite::correctionPositionLoco(qreal &x, qreal &y)
-{
-    QPointF p0(x, y);
-    QPointF p1 = *coordonneesLiaison[0];
-    QPointF p2 = *coordonneesLiaison[1];
-
-    qreal distP1P0 = sqrt((p1.x()-p0.x())*(p1.x()-p0.x()) + (p1.y()-p0.y())*(p1.y()-p0.y()));
-    qreal dx = p1.x()-p2.x();
-    qreal dy = p1.y()-p2.y();
-    qreal distP1P2 = sqrt(dx*dx + dy*dy);
-
-    qreal add   = (p0.x()-p1.x())*(p2.x()-p1.x())+(p0.y()-p1.y())*(p2.y()-p1.y());
-    qreal sqrt1 = sqrt((p0.x()-p1.x())*(p0.x()-p1.x())+(p0.y()-p1.y())*(p0.y()-p1.y()));
-    qreal sqrt2 = sqrt((p2.x()-p1.x())*(p2.x()-p1.x())+(p2.y()-p1.y())*(p2.y()-p1.y()));
-    qreal angleP2P1P0 = add/(sqrt1*sqrt2);
-
-    // This situation can happen if two points are equal, for instance if
-    // (x,y) are just exactly on a coordonneesLiaison. In that case, no
-    // need to adjust, so that's all right
-    if (isnan(angleP2P1P0)) {
-        return;
-    }
-
-    qreal distP1P3 = distP1P0*angleP2P1P0;
-    qreal rapport = distP1P3/distP1P2;
-
-    qreal dxP0 = rapport*dx;
-    qreal dyP0 = rapport*dy;
-
-    x = -dxP0;
-    y = -dyP0;
-}
-
-
 #define min(a,b) ((a<b)?(a):(b))
 
 QRectF VoieDroite::boundingRect() const
@@ -10,7 +10,6 @@ VoieTraverseeJonction::VoieTraverseeJonction(qreal angle, qreal rayon, qreal lon
     this->etat = 0;
     this->orientee = false;
     this->posee = false;
-    this->lastDistDel = 1000.0;
 }
 
 void VoieTraverseeJonction::setNumVoieVariable(int numVoieVariable)
@@ -28,7 +27,7 @@ void VoieTraverseeJonction::calculerAnglesEtCoordonnees(Voie *v)
     }
     else
     {
-        ordreVoieFixe = ordreLiaison.key(v);
+        ordreVoieFixe = getOrdreLiaison(v);
         setAngleDeg(ordreVoieFixe, normaliserAngle(v->getAngleVoisin(this) + 180.0));
     }
 
@@ -79,15 +78,6 @@ void VoieTraverseeJonction::calculerAnglesEtCoordonnees(Voie *v)
         calculerPositionContact();
 
     orientee = true;
-
-    if(!ordreLiaison[0]->estOrientee())
-        ordreLiaison[0]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[1]->estOrientee())
-        ordreLiaison[1]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[2]->estOrientee())
-        ordreLiaison[2]->calculerAnglesEtCoordonnees(this);
-    if(!ordreLiaison[3]->estOrientee())
-        ordreLiaison[3]->calculerAnglesEtCoordonnees(this);
 }
 
 void VoieTraverseeJonction::calculerPositionContact()
@@ -96,182 +86,60 @@ void VoieTraverseeJonction::calculerPositionContact()
     this->contact->setPos(0.0,0.0);
 }
 
-QList<QList<Voie*>*> VoieTraverseeJonction::explorationContactAContact(Voie* voieAppelante)
+int VoieTraverseeJonction::getSortiesPossibles(int liaisonEntree) const
 {
-    QList<QList<Voie*>*> temp;
-
-    if(this->contact == nullptr)
-    {
-        if(ordreLiaison.key(voieAppelante) == 0 || ordreLiaison.key(voieAppelante) == 2)
-        {
-            temp.append(ordreLiaison[1]->explorationContactAContact(this));
-            temp.append(ordreLiaison[3]->explorationContactAContact(this));
-        }
-        else if(ordreLiaison.key(voieAppelante) == 1 || ordreLiaison.key(voieAppelante) == 3)
-        {
-            temp.append(ordreLiaison[0]->explorationContactAContact(this));
-            temp.append(ordreLiaison[2]->explorationContactAContact(this));
-        }
-
-        foreach(QList<Voie*>* lv, temp)
-        {
-            lv->prepend(this);
-        }
-    }
-    else
-    {
-        QList<Voie*>* temp2 = new QList<Voie*>();
-        temp2->append(this);
-        temp.append(temp2);
-    }
-
-    return temp;
+    if(liaisonEntree == 0 || liaisonEntree == 2)
+        return (1 << 1) | (1 << 3);
+    return (1 << 0) | (1 << 2);
 }
 
-qreal VoieTraverseeJonction::getLongueurAParcourir()
+void VoieTraverseeJonction::calculerLongueurs()
 {
-    if(etat == TOUT_DROIT)
-    {
-        return longueur;
-    }
-    else
-    {
-        return (angle * PI / 180.0) * (rayon12 + rayon03); //approximation suffisante.
-    }
+    qreal devie = (angle * PI / 180.0) * (rayon12 + rayon03); //approximation suffisante.
+    setLongueurs(devie, longueur, devie);
 }
 
 Voie* VoieTraverseeJonction::getVoieSuivante(Voie *voieArrivee)
 {
-    int ordreVoieArrivee = ordreLiaison.key(voieArrivee);
+    int ordreVoieArrivee = getOrdreLiaison(voieArrivee);
 
     if(this->etat == TOUT_DROIT)
     {
         if( ordreVoieArrivee == 0)
-            return ordreLiaison.value(1);
+            return voisines.value(1);
         else if (ordreVoieArrivee == 1)
-            return ordreLiaison.value(0);
+            return voisines.value(0);
         else if (ordreVoieArrivee == 2)
-            return ordreLiaison.value(3);
+            return voisines.value(3);
         else
-            return ordreLiaison.value(2);
+            return voisines.value(2);
     }
     else
     {
         if( ordreVoieArrivee == 0)
-            return ordreLiaison.value(3);
+            return voisines.value(3);
         else if (ordreVoieArrivee == 1)
-            return ordreLiaison.value(2);
+            return voisines.value(2);
         else if (ordreVoieArrivee == 2)
-            return ordreLiaison.value(1);
+            return voisines.value(1);
         else
-            return ordreLiaison.value(0);
+            return voisines.value(0);
     }
 }
 
-void VoieTraverseeJonction::avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante)
+void VoieTraverseeJonction::decrireGeometrie(GeometrieVoie &g) const
 {
-    QPointF positionLocoRelative = mapFromParent(posActuelle);
-
-    if(etat == TOUT_DROIT)
-    {
-        angle = 0.0;
-        rayon = 0.0;
-
-        if(sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                (posActuelle.y() - getPosAbsLiaison(voieSuivante).y())) < dist)
-        {
-            dist -= sqrt((posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) *
-                         (posActuelle.x() - getPosAbsLiaison(voieSuivante).x()) +
-                         (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()) *
-                         (posActuelle.y() - getPosAbsLiaison(voieSuivante).y()));
-        }
-        else
-        {
-            dist = 0.0;
-        }
-    }
-    else
-    {
-        if(sqrt((positionLocoRelative.x() - centre03.x()) *
-                (positionLocoRelative.x() - centre03.x()) +
-                (positionLocoRelative.y() - centre03.y()) *
-                (positionLocoRelative.y() - centre03.y())) - rayon03 < 0.1 &&
-           sqrt((positionLocoRelative.x() - centre03.x()) *
-                (positionLocoRelative.x() - centre03.x()) +
-                (positionLocoRelative.y() - centre03.y()) *
-                (positionLocoRelative.y() - centre03.y())) - rayon03 > -0.1)
-        {
-            rayon = this->rayon03;
-        }
-        else
-        {
-            rayon = this->rayon12;
-        }
-        qreal angleAParcourir = (dist / rayon) * (180.0 / PI);
-
-        qreal angleRestant = (getAngleDeg(ordreLiaison.key(voieSuivante)) + 360.0) - (angleCumule + 360.0);
-
-        while(angleRestant < - this->angle)
-        {
-            angleRestant += 360.0;
-        }
-        if(angleRestant > this->angle)
-        {
-            angleRestant -= 360.0;
-        }
-
-        if(angleRestant < 0.0)
-        {
-            if(- angleRestant < angleAParcourir)
-            {
-                dist -= - angleRestant * (PI / 180.0) * rayon;
-                angle = angleRestant;
-            }
-            else
-            {
-                dist = 0.0;
-                angle = - angleAParcourir;
-            }
-        }
-        else
-        {
-            if(angleRestant < angleAParcourir)
-            {
-                dist -= angleRestant * (PI / 180.0) * rayon;
-                angle = angleRestant;
-            }
-            else
-            {
-                dist = 0.0;
-                angle = angleAParcourir;
-            }
-        }
-    }
-
-    qreal xLiaison = getPosAbsLiaison(voieSuivante).x();
-    qreal yLiaison = getPosAbsLiaison(voieSuivante).y();
-    qreal x = posActuelle.x() - xLiaison;
-    qreal y = posActuelle.y() - yLiaison;
-    qreal distDel = sqrt((x*x) + (y*y));
-
-    if(lastDistDel > distDel)
-    {
-        lastDistDel = distDel;
-    }
-    else
-    {
-        dist = 0.1;
-    }
-    if(dist > 0.0)
-        lastDistDel = 1000.0;
+    Voie::decrireGeometrie(g);
+    g.rayon = rayon03;
+    g.rayon2 = rayon12;
+    g.angle = angle;
+    g.centre = centre03;
 }
 
 void VoieTraverseeJonction::correctionPosition(qreal deltaX, qreal deltaY, Voie *v)
 {
     //Correction
-    if(ordreLiaison.key(v) == 0)
+    if(getOrdreLiaison(v) == 0)
     {
         setPos(this->pos().x() + deltaX, this->pos().y() + deltaY);
         coordonneesLiaison[1]->setX(coordonneesLiaison[1]->x() - deltaX);
@@ -283,8 +151,8 @@ void VoieTraverseeJonction::correctionPosition(qreal deltaX, qreal deltaY, Voie
     }
     else
     {
-        coordonneesLiaison[ordreLiaison.key(v)]->setX(coordonneesLiaison[ordreLiaison.key(v)]->x() + deltaX);
-        coordonneesLiaison[ordreLiaison.key(v)]->setY(coordonneesLiaison[ordreLiaison.key(v)]->y() + deltaY);
+        coordonneesLiaison[getOrdreLiaison(v)]->setX(coordonneesLiaison[getOrdreLiaison(v)]->x() + deltaX);
+        coordonneesLiaison[getOrdreLiaison(v)]->setY(coordonneesLiaison[getOrdreLiaison(v)]->y() + deltaY);
     }
 
     //modifications pour courbe 03.
@@ -333,12 +201,6 @@ void VoieTraverseeJonction::correctionPosition(qreal deltaX, qreal deltaY, Voie
 }
 
 
-void VoieTraverseeJonction::correctionPositionLoco(qreal &/*x*/, qreal &/*y*/)
-{
-    //TODO
-}
-
-
 QRectF VoieTraverseeJonction::boundingRect() const
 {
     return QRectF(QPointF(-200.0, -200.0),
@@ -13,12 +13,12 @@ public:
     VoieTraverseeJonction(qreal angle, qreal rayon, qreal longueur);
     void calculerAnglesEtCoordonnees(Voie *v) override;
     void calculerPositionContact() override;
-    QList<QList<Voie*>*> explorationContactAContact(Voie* voieAppelante) override;
-    qreal getLongueurAParcourir() override;
+    int getSortiesPossibles(int liaisonEntree) const override;
+    TypeVoie getType() const override { return TypeVoie::TRAVERSEE_JONCTION; }
+    void calculerLongueurs() override;
     Voie* getVoieSuivante(Voie* voieArrivee) override;
-    void avanceLoco(qreal &dist, qreal &angle, qreal &rayon, qreal angleCumule, QPointF posActuelle, Voie *voieSuivante) override;
+    void decrireGeometrie(GeometrieVoie& g) const override;
     void correctionPosition(qreal deltaX, qreal deltaY, Voie *v) override;
-    void correctionPositionLoco(qreal &, qreal &) override;
     QRectF boundingRect() const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *) override;
     void setNumVoieVariable(int numVoieVariable) override;
@@ -28,7 +28,6 @@ private:
     qreal rayon03, rayon12, angle, longueur;
     QPointF centre03;
     QPointF centre12;
-    qreal lastDistDel;
 };
 
 #endif // VOIETRAVERSEEJONCTION_H
@@ -8,6 +8,7 @@ VoieVariable::VoieVariable()
 void VoieVariable::setEtat(int nouvelEtat)
 {
     this->etat = nouvelEtat;
+    selectionnerLongueur(nouvelEtat);
     this->update(boundingRect());
     etatModifie(this);
 }
@@ -12,10 +12,21 @@ public:
     VoieVariable();
 
     void setEtat(int nouvelEtat) override;
+
+    /** retourne l'état de la voie variable.
+      * \return l'état (DEVIE, TOUT_DROIT, ou -1 pour l'aiguillage triple).
+      */
+    int getEtat() const { return etat; }
+
     /** permet d'indiquer à la voie variable quel est son numéro.
       * \param numVoieVariable le numéro de la voie variable.
       */
     virtual void setNumVoieVariable(int numVoieVariable) = 0;
+
+    /** retourne le numéro de la voie variable.
+      * \return le numéro de l'aiguillage.
+      */
+    int getNumVoieVariable() const { return numVoieVariable; }
 signals:
     /** signale que la voie variable a été modifiée.
       * \param v la voie modifiée.
@@ -0,0 +1,302 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+// Lance les simulations d'une grille de paramètres en parallèle, sans interface,
+// et rassemble leurs mesures dans <sortie>.csv et <sortie>.json.
+//
+// Chaque simulation est un processus pco_lab04 distinct : le simulateur et
+// l'interface C reposent sur des instances uniques, un processus par simulation
+// leur donne un état propre sans rien partager entre les workers.
+
+#include "scenariogrid.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+
+// Paramètres de la grille, et variables d'environnement qui les transmettent au programme
+static const std::map<std::string, QString> environmentOf = {
+    {"vitesse", "PCO_VITESSE"},
+    {"flotte", "PCO_FLOTTE"},
+    {"maquette", "PCO_MAQUETTE"},
+    {"reservation", "PCO_RESERVATION"},
+    {"executeur", "PCO_EXECUTOR"},
+};
+
+/**
+ * @brief Une simulation de la grille et son résultat
+ */
+struct Run
+{
+    Scenario scenario;
+    QString resultFile;
+    int exitCode{-1};
+    QJsonObject results;
+};
+
+/**
+ * @brief La classe BatchRunner lance les simulations, au plus jobs à la fois
+ */
+class BatchRunner
+{
+public:
+    BatchRunner(std::vector<Run>& runs, QString simulator, QString duration,
+                QProcessEnvironment baseEnvironment, int jobs, int timeoutMs)
+        : runs(runs), simulator(std::move(simulator)), duration(std::move(duration)),
+          baseEnvironment(std::move(baseEnvironment)), jobs(jobs), timeoutMs(timeoutMs) {}
+
+    /**
+     * @brief start Lance les premières simulations ; l'application se termine
+     * quand toutes sont finies
+     */
+    void start()
+    {
+        if (runs.empty()) {
+            QCoreApplication::exit(0);
+            return;
+        }
+        for (int i = 0; i < jobs; ++i) {
+            launchNext();
+        }
+    }
+
+private:
+    void launchNext()
+    {
+        if (next >= runs.size()) {
+            return;
+        }
+        Run& run = runs[next++];
+        running++;
+
+        QProcessEnvironment environment = baseEnvironment;
+        for (const auto& parameter : run.scenario.parameters) {
+            QString value = QString::fromStdString(parameter.second);
+            // Un executeur à 0 garde un thread par locomotive
+            if (parameter.first == "executeur" && value == "0") {
+                environment.remove("PCO_EXECUTOR");
+                continue;
+            }
+            environment.insert(environmentOf.at(parameter.first), value);
+        }
+
+        auto* process = new QProcess();
+        process->setProcessEnvironment(environment);
+        process->setProcessChannelMode(QProcess::MergedChannels);
+        process->setStandardOutputFile(QProcess::nullDevice());
+
+        // Filet de sécurité si la simulation ne se termine pas d'elle-même
+        auto* timeout = new QTimer(process);
+        timeout->setSingleShot(true);
+        QObject::connect(timeout, &QTimer::timeout, process, &QProcess::kill);
+
+        QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                         [this, process, &run](int exitCode, QProcess::ExitStatus status) {
+            run.exitCode = (status == QProcess::NormalExit) ? exitCode : -1;
+            QFile file(run.resultFile);
+            if (file.open(QIODevice::ReadOnly)) {
+                run.results = QJsonDocument::fromJson(file.readAll()).object();
+            }
+            process->deleteLater();
+            finished();
+        });
+        QObject::connect(process, &QProcess::errorOccurred, [this, process, &run](QProcess::ProcessError error) {
+            if (error != QProcess::FailedToStart) {
+                return;
+            }
+            std::cerr << "Impossible de lancer " << qPrintable(simulator) << std::endl;
+            run.exitCode = -1;
+            process->deleteLater();
+            finished();
+        });
+
+        process->start(simulator, {"--batch", run.resultFile, "--duree", duration});
+        timeout->start(timeoutMs);
+    }
+
+    void finished()
+    {
+        running--;
+        done++;
+        std::cout << "\r" << done << "/" << runs.size() << " simulations" << std::flush;
+        launchNext();
+        if (running == 0) {
+            std::cout << std::endl;
+            QCoreApplication::exit(0);
+        }
+    }
+
+    std::vector<Run>& runs;
+    QString simulator;
+    QString duration;
+    QProcessEnvironment baseEnvironment;
+    int jobs;
+    int timeoutMs;
+    size_t next{0};
+    size_t done{0};
+    int running{0};
+};
+
+static QString csvField(const QJsonValue& value)
+{
+    if (value.isBool()) {
+        return value.toBool() ? "1" : "0";
+    }
+    if (value.isDouble()) {
+        return QString::number(value.toDouble());
+    }
+    return value.toString();
+}
+
+/**
+ * @brief writeResults Ecrit une ligne par simulation dans <sortie>.csv, et toutes
+ * les mesures dans <sortie>.json
+ */
+static bool writeResults(const QString& output, const std::vector<std::string>& names,
+                         const std::vector<Run>& runs)
+{
+    static const QStringList measures = {"temps_simule_ms", "collisions", "interblocage",
+                                         "contacts", "debit_contacts_par_minute"};
+    static const QStringList waits = {"nombre", "moyenne_ms", "max_ms"};
+
+    QFile csvFile(output + ".csv");
+    QFile jsonFile(output + ".json");
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) ||
+        !jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QTextStream csv(&csvFile);
+    QStringList header;
+    for (const std::string& name : names) {
+        header << QString::fromStdString(name);
+    }
+    header << "repetition" << "code" << measures;
+    for (const QString& wait : waits) {
+        header << "attente_section_" + wait;
+    }
+    csv << header.join(',') << "\n";
+
+    QJsonArray all;
+    for (const Run& run : runs) {
+        QStringList line;
+        QJsonObject parameters;
+        for (const auto& parameter : run.scenario.parameters) {
+            line << QString::fromStdString(parameter.second);
+            parameters[QString::fromStdString(parameter.first)] = QString::fromStdString(parameter.second);
+        }
+        line << QString::number(run.scenario.repetition) << QString::number(run.exitCode);
+        for (const QString& measure : measures) {
+            line << csvField(run.results.value(measure));
+        }
+        QJsonObject sectionWait = run.results.value("mesures").toObject().value("attente_section").toObject();
+        for (const QString& wait : waits) {
+            line << csvField(sectionWait.value(wait));
+        }
+        csv << line.join(',') << "\n";
+
+        QJsonObject entry;
+        entry["parametres"] = parameters;
+        entry["repetition"] = run.scenario.repetition;
+        entry["code"] = run.exitCode;
+        entry["resultats"] = run.results;
+        all.append(entry);
+    }
+
+    jsonFile.write(QJsonDocument(all).toJson());
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption gridOption("grille", "Grille de paramètres des simulations.", "fichier");
+    QCommandLineOption fleetOption("flotte", "Flotte de locomotives, si la grille ne la fait pas varier.", "fichier");
+    QCommandLineOption layoutOption("maquette", "Maquette (A ou B), si la grille ne la fait pas varier.", "maquette", "A");
+    QCommandLineOption durationOption("duree", "Durée de chaque simulation, en millisecondes de temps simulé.", "ms", "600000");
+    QCommandLineOption jobsOption("jobs", "Nombre de simulations en parallèle.", "nombre",
+                                  QString::number(QThread::idealThreadCount()));
+    QCommandLineOption timeoutOption("delai", "Temps réel maximal d'une simulation, en secondes.", "s", "600");
+    QCommandLineOption outputOption("sortie", "Préfixe des fichiers de résultats.", "prefixe", "resultats");
+    QCommandLineOption simulatorOption("simulateur", "Programme de contrôle à lancer.", "programme",
+                                       QCoreApplication::applicationDirPath() + "/pco_lab04");
+    parser.addOptions({gridOption, fleetOption, layoutOption, durationOption, jobsOption,
+                       timeoutOption, outputOption, simulatorOption});
+    parser.process(app);
+
+    ScenarioGrid grid;
+    if (parser.isSet(gridOption)) {
+        std::ifstream in(parser.value(gridOption).toStdString());
+        std::string error;
+        if (!in) {
+            std::cerr << "Grille introuvable : " << qPrintable(parser.value(gridOption)) << std::endl;
+            return 1;
+        }
+        if (!grid.parse(in, error)) {
+            std::cerr << qPrintable(parser.value(gridOption)) << ", " << error << std::endl;
+            return 1;
+        }
+    }
+    for (const std::string& name : grid.names()) {
+        if (environmentOf.count(name) == 0) {
+            std::cerr << "Paramètre inconnu : " << name << std::endl;
+            return 1;
+        }
+    }
+
+    QTemporaryDir resultsDir;
+    if (!resultsDir.isValid()) {
+        std::cerr << "Impossible de créer un dossier temporaire" << std::endl;
+        return 1;
+    }
+
+    std::vector<Run> runs;
+    for (const Scenario& scenario : grid.expand()) {
+        Run run;
+        run.scenario = scenario;
+        run.resultFile = resultsDir.filePath(QString("simulation_%1.json").arg(runs.size()));
+        runs.push_back(std::move(run));
+    }
+
+    // Valeurs communes, remplacées par celles de la grille ; les simulations
+    // tournent sans affichage
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("QT_QPA_PLATFORM", "offscreen");
+    environment.insert("PCO_MAQUETTE", parser.value(layoutOption));
+    if (parser.isSet(fleetOption)) {
+        environment.insert("PCO_FLOTTE", QDir().absoluteFilePath(parser.value(fleetOption)));
+    }
+
+    BatchRunner runner(runs, parser.value(simulatorOption), parser.value(durationOption), environment,
+                       qMax(parser.value(jobsOption).toInt(), 1), parser.value(timeoutOption).toInt() * 1000);
+    QTimer::singleShot(0, [&runner] { runner.start(); });
+    app.exec();
+
+    if (!writeResults(parser.value(outputOption), grid.names(), runs)) {
+        std::cerr << "Impossible d'écrire les résultats : " << qPrintable(parser.value(outputOption)) << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+
+//  Mesures de performance des primitives de la section partagée.
+//  Lancer avec --benchmark_out=fichier.json --benchmark_out_format=json
+//  pour conserver les résultats et les comparer d'une version à l'autre.
+
+#include <benchmark/benchmark.h>
+#include <memory>
+
+#include <pcosynchro/pcothread.h>
+
+#include "sharedsection.h"
+#include "sharedsectioninterface.h"
+
+using Direction = SharedSectionInterface::Direction;
+
+/**
+ * @brief Section partagée commune aux threads d'un même benchmark multi-thread,
+ * créée par le thread 0 avant la boucle de mesure.
+ */
+static std::unique_ptr<SharedSection> section;
+
+static Direction directionOf(int threadIndex) {
+    return (threadIndex % 2 == 0) ? Direction::D1 : Direction::D2;
+}
+
+// Latence d'un cycle complet access + leave + release sans concurrence
+static void BM_UncontendedAccessLeaveRelease(benchmark::State& state) {
+    SharedSection localSection;
+    Locomotive loco(1, 10, 0);
+
+    for (auto _ : state) {
+        localSection.access(loco, Direction::D1);
+        localSection.leave(loco, Direction::D1);
+        localSection.release(loco);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["errors"] = localSection.nbErrors();
+}
+BENCHMARK(BM_UncontendedAccessLeaveRelease);
+
+// Latence de transmission de la section entre locomotives de directions alternées,
+// et débit lorsque le nombre de locomotives concurrentes augmente
+static void BM_ContendedHandoff(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        section = std::make_unique<SharedSection>();
+    }
+    Locomotive loco(state.thread_index() + 1, 10, 0);
+    Direction d = directionOf(state.thread_index());
+
+    for (auto _ : state) {
+        section->access(loco, d);
+        section->leave(loco, d);
+        section->release(loco);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        state.counters["errors"] = section->nbErrors();
+    }
+}
+BENCHMARK(BM_ContendedHandoff)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -13,32 +13,210 @@
 #include "locomotivebehavior.h"
 #include "sharedsectioninterface.h"
 #include "sharedsection.h"
+#include "fleetconfig.h"
+#include "routecompiler.h"
+#include "executor.h"
 
+#include <pcosynchro/pcothread.h>
+
+#include <QCoreApplication>
+#include <QDebug>
 #include <memory>
-#include <thread>
+#include <vector>
 
-// Variables globales pour la section partagée et les threads
-static std::shared_ptr<SharedSection> sharedSection;
-static std::unique_ptr<LocomotiveBehavior> locoBehavA;
-static std::unique_ptr<LocomotiveBehavior> locoBehavB;
-static std::thread threadA;
-static std::thread threadB;
+// Pool de threads optionnel : si la variable d'environnement PCO_EXECUTOR est
+// définie, les comportements sont pilotés par les activations de contacts sur un
+// pool de PCO_EXECUTOR threads (le nombre de coeurs si la valeur n'est pas un
+// nombre positif) au lieu d'un thread par locomotive.
+static std::unique_ptr<Executor> createExecutor()
+{
+    if (!qEnvironmentVariableIsSet("PCO_EXECUTOR")) {
+        return nullptr;
+    }
+    bool ok = false;
+    int nbWorkers = qEnvironmentVariableIntValue("PCO_EXECUTOR", &ok);
+    if (ok && nbWorkers > 0) {
+        return std::make_unique<Executor>(nbWorkers);
+    }
+    return std::make_unique<Executor>();
+}
 
 // Locomotives :
-// Vous pouvez changer les vitesses initiales, ou utiliser la fonction loco.fixerVitesse(vitesse);
-// Laissez les numéros des locos à 0 et 1 pour ce laboratoire
+// La flotte est décrite par le fichier data/flotte.txt (ou celui désigné par la
+// variable d'environnement PCO_FLOTTE). Sans fichier, la flotte du laboratoire
+// (locos 7 et 42) est utilisée.
+
+// Retourne la flotte à lancer
+static FleetConfig loadFleet()
+{
+    QString fileName = qEnvironmentVariable("PCO_FLOTTE");
+    if (fileName.isEmpty() && QCoreApplication::instance() != nullptr) {
+        fileName = QCoreApplication::applicationDirPath() + "/data/flotte.txt";
+    }
+
+    FleetConfig fleet;
+    if (!fileName.isEmpty() && fleet.load(fileName)) {
+        return fleet;
+    }
+    return FleetConfig::defaultFleet();
+}
+
+// Paramètres des simulations lancées par qtrainsim_batch, par variables
+// d'environnement : PCO_MAQUETTE (A ou B), PCO_VITESSE (vitesse de toutes les
+// locos) et PCO_RESERVATION=0 pour attendre la section à son entrée, sans
+// réservation anticipée ni freinage.
+static const char* layout()
+{
+    return qEnvironmentVariable("PCO_MAQUETTE") == "B" ? MAQUETTE_B : MAQUETTE_A;
+}
+
+static void applyBatchParameters(FleetConfig& fleet)
+{
+    bool ok = false;
+    int speed = qEnvironmentVariableIntValue("PCO_VITESSE", &ok);
+    bool reservation = qEnvironmentVariable("PCO_RESERVATION") != "0";
+    const std::uint16_t anticipation = Route::PreEntryClockwise | Route::PreEntryCounterClockwise |
+                                       Route::BrakeClockwise | Route::BrakeCounterClockwise;
+
+    for (LocoConfig& config : fleet.locos) {
+        if (ok && speed > 0) {
+            config.speed = speed;
+        }
+        if (!reservation) {
+            if (config.route.flags.size() != config.route.path.size()) {
+                RouteCompiler::tabulate(config.route);
+            }
+            for (std::uint16_t& flags : config.route.flags) {
+                flags &= ~anticipation;
+            }
+        }
+    }
+}
+
+/**
+ * @brief simulatorLeg Calcul d'un tronçon d'itinéraire par le simulateur
+ */
+static bool simulatorLeg(TrainContext* context, int previous, int from, int to,
+                         std::vector<int>& contacts, std::vector<SwitchSetting>& switches)
+{
+    int pathContacts[MAX_CONTACTS];
+    int numbers[MAX_AIGUILLAGES];
+    int directions[MAX_AIGUILLAGES];
+    int nbSwitches = 0;
+
+    int nbContacts = calculer_itineraire_ctx(context, previous, from, to, pathContacts, MAX_CONTACTS,
+                                             numbers, directions, MAX_AIGUILLAGES, &nbSwitches);
+    if (nbContacts == 0) {
+        return false;
+    }
+    contacts.assign(pathContacts, pathContacts + nbContacts);
+    switches.clear();
+    for (int i = 0; i < nbSwitches; ++i) {
+        switches.push_back({numbers[i], directions[i]});
+    }
+    return true;
+}
+
+/**
+ * @brief compileRoutes Complète les itinéraires de la flotte à partir de la maquette
+ * et dirige les aiguillages en conséquence
+ * @return false si les itinéraires ne peuvent pas être suivis avec une seule position
+ * des aiguillages ; la flotte est alors laissée telle quelle
+ */
+static bool compileRoutes(TrainContext* context, FleetConfig& fleet)
+{
+    RouteCompiler compiler([context](int previous, int from, int to,
+                                     std::vector<int>& contacts, std::vector<SwitchSetting>& switches) {
+        return simulatorLeg(context, previous, from, to, contacts, switches);
+    });
+    std::vector<Route> routes;
+    std::vector<SwitchSetting> switches;
+
+    for (const LocoConfig& config : fleet.locos) {
+        Route route = config.route;
+        if (!compiler.compile(route) || !RouteCompiler::mergeSwitches(switches, route.switches)) {
+            qWarning() << "Itinéraire de la loco" << config.number << "incompatible avec la maquette";
+            return false;
+        }
+        routes.push_back(std::move(route));
+    }
+
+    for (size_t i = 0; i < routes.size(); ++i) {
+        fleet.locos[i].route = std::move(routes[i]);
+    }
+    for (const SwitchSetting& setting : switches) {
+        diriger_aiguillage_ctx(context, setting.number, setting.direction, 0);
+    }
+    return true;
+}
+
+// Fonction pour initialiser les aiguillages
+void initializeSwitches(TrainContext* context) {
+    // Configuration des aiguillages pour la maquette A
+    // Ajustez ces valeurs selon votre configuration de maquette
+    diriger_aiguillage_ctx(context, 1,  TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 2,  DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 3,  DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 4,  TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 5,  TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 6,  TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 7,  TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 8,  DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 9,  DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 10, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 11, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 12, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 13, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 14, DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 15, DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 16, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 17, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 18, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 19, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 20, DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 21, DEVIE     , 0);
+    diriger_aiguillage_ctx(context, 22, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 23, TOUT_DROIT, 0);
+    diriger_aiguillage_ctx(context, 24, TOUT_DROIT, 0);
+    // diriger_aiguillage(/*NUMERO*/, /*TOUT_DROIT | DEVIE*/, /*0*/);
+}
+
+/**
+ * @brief La classe TrainProgram regroupe l'état du programme de contrôle d'une
+ * simulation : ses locomotives, leurs comportements et la section partagée.
+ * Chaque contexte de simulation a le sien.
+ */
+class TrainProgram
+{
+public:
+    explicit TrainProgram(TrainContext* context) : context(context) {}
+
+    /**
+     * @brief run Lance la flotte et attend la fin de ses comportements
+     */
+    int run();
 
-// Locomotive A
-static Locomotive locoA(7 /* Numéro (pour commande trains sur maquette réelle) */, 10 /* Vitesse */);
-// Locomotive B
-static Locomotive locoB(42 /* Numéro (pour commande trains sur maquette réelle) */, 12 /* Vitesse */);
+    /**
+     * @brief emergencyStop Arrête toutes les locomotives et libère la section
+     */
+    void emergencyStop();
+
+private:
+    TrainContext* context;
+    std::shared_ptr<SharedSection> sharedSection;
+    std::vector<std::unique_ptr<Locomotive>> locos;
+    std::unique_ptr<Executor> executor;
+    // Détruits en premier : ils utilisent les locomotives et le pool
+    std::vector<std::unique_ptr<LocomotiveBehavior>> locoBehaviors;
+};
 
 //Arret d'urgence
-void emergency_stop()
+void TrainProgram::emergencyStop()
 {
     // Arrêter toutes les locomotives
-    locoA.arreter();
-    locoB.arreter();
+    for (auto& loco : locos) {
+        loco->arreter();
+    }
     
     // Libérer la section partagée
     if (sharedSection) {
@@ -46,73 +224,47 @@ void emergency_stop()
     }
     
     // Afficher un message d'arrêt
-    afficher_message("\nARRÊT D'URGENCE !");
+    afficher_message_ctx(context, "\nARRÊT D'URGENCE !");
 }
 
-// Fonction pour initialiser les aiguillages
-void initializeSwitches() {
-    // Configuration des aiguillages pour la maquette A
-    // Ajustez ces valeurs selon votre configuration de maquette
-    diriger_aiguillage(1,  TOUT_DROIT, 0);
-    diriger_aiguillage(2,  DEVIE     , 0);
-    diriger_aiguillage(3,  DEVIE     , 0);
-    diriger_aiguillage(4,  TOUT_DROIT, 0);
-    diriger_aiguillage(5,  TOUT_DROIT, 0);
-    diriger_aiguillage(6,  TOUT_DROIT, 0);
-    diriger_aiguillage(7,  TOUT_DROIT, 0);
-    diriger_aiguillage(8,  DEVIE     , 0);
-    diriger_aiguillage(9,  DEVIE     , 0);
-    diriger_aiguillage(10, TOUT_DROIT, 0);
-    diriger_aiguillage(11, TOUT_DROIT, 0);
-    diriger_aiguillage(12, TOUT_DROIT, 0);
-    diriger_aiguillage(13, TOUT_DROIT, 0);
-    diriger_aiguillage(14, DEVIE     , 0);
-    diriger_aiguillage(15, DEVIE     , 0);
-    diriger_aiguillage(16, TOUT_DROIT, 0);
-    diriger_aiguillage(17, TOUT_DROIT, 0);
-    diriger_aiguillage(18, TOUT_DROIT, 0);
-    diriger_aiguillage(19, TOUT_DROIT, 0);
-    diriger_aiguillage(20, DEVIE     , 0);
-    diriger_aiguillage(21, DEVIE     , 0);
-    diriger_aiguillage(22, TOUT_DROIT, 0);
-    diriger_aiguillage(23, TOUT_DROIT, 0);
-    diriger_aiguillage(24, TOUT_DROIT, 0);
-    // diriger_aiguillage(/*NUMERO*/, /*TOUT_DROIT | DEVIE*/, /*0*/);
-}
-
-// Fonction principale
-int cmain()
+int TrainProgram::run()
 {
     /************
      * Maquette *
      ************/
 
     // Choix de la maquette (A ou B)
-    selection_maquette(MAQUETTE_A);
+    selection_maquette_ctx(context, layout());
+
+    FleetConfig fleet = loadFleet();
 
     /**********************************
      * Initialisation des aiguillages *
      **********************************/
-    initializeSwitches();
+
+    // Les aiguillages sont déduits des itinéraires ; à défaut, positions fixes
+    if (!compileRoutes(context, fleet)) {
+        afficher_message_ctx(context, "Itinéraires incompatibles sur les aiguillages, positions par défaut utilisées");
+        initializeSwitches(context);
+    }
+    applyBatchParameters(fleet);
 
     /********************************
      * Position de départ des locos *
      ********************************/
 
-    // Loco 0
-    // Exemple de position de départ
-    locoA.fixerPosition(34, 5);
-
-    // Loco 1
-    // Exemple de position de départ
-    locoB.fixerPosition(31, 1);
+    for (const LocoConfig& config : fleet.locos) {
+        auto loco = std::make_unique<Locomotive>(config.number, config.speed, context);
+        loco->fixerPosition(config.frontContact, config.backContact);
+        locos.push_back(std::move(loco));
+    }
 
     /***********
      * Message *
      **********/
 
     // Affiche un message dans la console de l'application graphique
-    afficher_message("Hit play to start the simulation...");
+    afficher_message_ctx(context, "Hit play to start the simulation...");
 
     /*********************
      * Section partagée  *
@@ -125,24 +277,85 @@ int cmain()
      * Threads des locos *
      *******************/
 
-    // Création des comportements des locomotives
-    locoBehavA = std::make_unique<LocomotiveBehavior>(locoA, sharedSection);
-    locoBehavB = std::make_unique<LocomotiveBehavior>(locoB, sharedSection);
+    // Création des comportements des locomotives, un par entrée de la flotte
+    for (size_t i = 0; i < locos.size(); ++i) {
+        locoBehaviors.push_back(std::make_unique<LocomotiveBehavior>(*locos[i], sharedSection, fleet.locos[i].route));
+    }
 
     // Démarrage des threads
-    locoBehavA->startThread();
-    locoBehavB->startThread();
+    executor = createExecutor();
+    for (auto& behavior : locoBehaviors) {
+        behavior->setExecutor(executor.get());
+        behavior->startThread();
+    }
+
+    // Sans interface, la simulation démarre sans attendre l'utilisateur
+    demarrer_simulation_ctx(context);
 
     /******************
      * Attente fin    *
      *****************/
 
     // Attente de la fin des threads (ne devrait jamais arriver)
-    locoBehavA->join();
-    locoBehavB->join();
+    for (auto& behavior : locoBehaviors) {
+        behavior->join();
+    }
 
     //Fin de la simulation
-    mettre_maquette_hors_service();
+    mettre_maquette_hors_service_ctx(context);
 
     return EXIT_SUCCESS;
 }
+
+// Programme de la simulation de l'application
+static TrainProgram& defaultProgram()
+{
+    static TrainProgram program(contexte_defaut());
+    return program;
+}
+
+// Programmes des contextes créés par creer_contexte(), arrêtés avec celui de l'application
+static std::vector<std::unique_ptr<TrainProgram>> contextPrograms;
+static std::vector<std::unique_ptr<PcoThread>> contextThreads;
+
+/**
+ * @brief cmain_ctx Programme de contrôle d'un contexte : lance sa flotte et attend
+ * la fin de ses comportements, comme cmain() pour le contexte de l'application
+ */
+int cmain_ctx(TrainContext* context)
+{
+    if (context == contexte_defaut()) {
+        return defaultProgram().run();
+    }
+    TrainProgram program(context);
+    return program.run();
+}
+
+// Simulations supplémentaires : si la variable d'environnement PCO_CONTEXTES vaut
+// N > 1, N - 1 contextes sans fenêtre sont créés, chacun avec son programme dans
+// son propre thread. Leurs simulateurs avancent dans le thread de l'interface.
+static void startContextPrograms()
+{
+    bool ok = false;
+    int nbContexts = qEnvironmentVariableIntValue("PCO_CONTEXTES", &ok);
+    for (int i = 1; ok && i < nbContexts; ++i) {
+        TrainContext* context = creer_contexte();
+        contextPrograms.push_back(std::make_unique<TrainProgram>(context));
+        contextThreads.push_back(std::make_unique<PcoThread>(&TrainProgram::run, contextPrograms.back().get()));
+    }
+}
+
+void emergency_stop()
+{
+    defaultProgram().emergencyStop();
+    for (auto& program : contextPrograms) {
+        program->emergencyStop();
+    }
+}
+
+// Fonction principale
+int cmain()
+{
+    startContextPrograms();
+    return cmain_ctx(contexte_defaut());
+}
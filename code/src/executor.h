@@ -0,0 +1,179 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <pcosynchro/pcomutex.h>
+#include <pcosynchro/pcoconditionvariable.h>
+#include <pcosynchro/pcothread.h>
+
+/**
+ * @brief La classe Executor est un pool de threads à vol de tâches (work stealing).
+ *
+ * Chaque thread possède sa propre file de tâches. Une tâche soumise depuis un thread
+ * du pool est ajoutée à la file de ce thread, qui la traite en priorité (LIFO) ; les
+ * threads inactifs volent les tâches les plus anciennes des autres files (FIFO).
+ * Les tâches ne doivent pas bloquer longtemps : elles sont destinées à être reprises
+ * par des événements (activations de contacts, accès à la section partagée).
+ */
+class Executor
+{
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Executor Crée le pool et lance ses threads
+     * @param nbWorkers Nombre de threads, par défaut le nombre de coeurs
+     */
+    explicit Executor(unsigned nbWorkers = std::thread::hardware_concurrency())
+    {
+        if (nbWorkers == 0) {
+            nbWorkers = 1;
+        }
+        for (unsigned i = 0; i < nbWorkers; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (unsigned i = 0; i < nbWorkers; ++i) {
+            workers[i]->thread = std::make_unique<PcoThread>(&Executor::workerLoop, this, i);
+        }
+    }
+
+    /**
+     * @brief ~Executor Termine les tâches en attente puis arrête les threads
+     */
+    ~Executor()
+    {
+        idleMutex.lock();
+        stopping = true;
+        idle.notifyAll();
+        idleMutex.unlock();
+
+        for (auto& worker : workers) {
+            worker->thread->join();
+        }
+    }
+
+    /**
+     * @brief post Soumet une tâche au pool. Peut être appelée depuis n'importe quel thread.
+     * @param task La tâche à exécuter
+     */
+    void post(Task task)
+    {
+        size_t index;
+        if (currentExecutor() == this) {
+            index = currentIndex();
+        }
+        else {
+            index = next.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        }
+
+        Worker& worker = *workers[index];
+        worker.mutex.lock();
+        worker.tasks.push_back(std::move(task));
+        worker.mutex.unlock();
+
+        idleMutex.lock();
+        pending++;
+        idle.notifyOne();
+        idleMutex.unlock();
+    }
+
+    /**
+     * @brief size Retourne le nombre de threads du pool
+     */
+    size_t size() const { return workers.size(); }
+
+private:
+    struct Worker {
+        PcoMutex mutex;
+        std::deque<Task> tasks;
+        std::unique_ptr<PcoThread> thread;
+    };
+
+    static Executor*& currentExecutor() { static thread_local Executor* executor = nullptr; return executor; }
+    static size_t& currentIndex() { static thread_local size_t index = 0; return index; }
+
+    bool popLocal(size_t index, Task& task)
+    {
+        Worker& worker = *workers[index];
+        worker.mutex.lock();
+        bool found = !worker.tasks.empty();
+        if (found) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        worker.mutex.unlock();
+        return found;
+    }
+
+    bool steal(size_t index, Task& task)
+    {
+        for (size_t i = 1; i < workers.size(); ++i) {
+            Worker& victim = *workers[(index + i) % workers.size()];
+            victim.mutex.lock();
+            bool found = !victim.tasks.empty();
+            if (found) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+            victim.mutex.unlock();
+            if (found) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index)
+    {
+        currentExecutor() = this;
+        currentIndex() = index;
+
+        while (true) {
+            idleMutex.lock();
+            while (pending == 0 && !stopping) {
+                idle.wait(&idleMutex);
+            }
+            if (pending == 0 && stopping) {
+                idleMutex.unlock();
+                return;
+            }
+            idleMutex.unlock();
+
+            Task task;
+            if (popLocal(index, task) || steal(index, task)) {
+                idleMutex.lock();
+                pending--;
+                idleMutex.unlock();
+                task();
+            }
+            else {
+                // La tâche annoncée vient d'être prise par un autre thread
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> next{0};     // Répartition des tâches soumises hors du pool
+    PcoMutex idleMutex;              // Protège pending et stopping
+    PcoConditionVariable idle;       // Attente des threads sans tâche
+    size_t pending{0};               // Nombre de tâches dans les files
+    bool stopping{false};            // Le pool doit-il s'arrêter ?
+};
+
+#endif // EXECUTOR_H
@@ -0,0 +1,140 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#include "fleetconfig.h"
+#include "ctrain_handler.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+
+FleetConfig FleetConfig::defaultFleet()
+{
+    FleetConfig fleet;
+
+    Route common;
+    // Section partagée (contacts 5, 7, 19, 21, 23)
+    common.sharedSectionContacts = {5, 7, 19, 21, 23};
+    // Contacts où les locomotives changent de direction
+    common.directionChangePoints = {1, 29};
+
+    // Locomotive A (sens horaire)
+    LocoConfig locoA{7, 10, 34, 5, common};
+    locoA.route.path = {34, 1, 5, 7, 9, 11, 19, 21, 23, 25, 27, 29, 31, 33};
+    locoA.route.clockwise = true;
+
+    // Locomotive B (sens anti-horaire)
+    LocoConfig locoB{42, 12, 31, 1, common};
+    locoB.route.path = {31, 33, 1, 3, 5, 7, 15, 17, 19, 21, 23, 25, 27, 29};
+    locoB.route.clockwise = false;
+
+    fleet.locos = {locoA, locoB};
+    return fleet;
+}
+
+static bool parseContacts(const QStringList& words, int first, std::vector<int>& contacts)
+{
+    for (int i = first; i < words.size(); ++i) {
+        bool ok = false;
+        int contact = words.at(i).toInt(&ok);
+        if (!ok || contact < 1 || contact > MAX_CONTACTS) {
+            return false;
+        }
+        contacts.push_back(contact);
+    }
+    return true;
+}
+
+bool FleetConfig::load(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    std::vector<LocoConfig> loaded;
+    std::set<int> numbers;
+    std::set<int> sharedSection;
+    std::set<int> directionChanges;
+    std::set<int> stations;
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        lineNumber++;
+
+        int comment = line.indexOf('#');
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+        QStringList words = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        if (words.isEmpty()) {
+            continue;
+        }
+
+        const QString directive = words.at(0);
+        std::vector<int> contacts;
+
+        if (directive == "section" || directive == "inversion" || directive == "gare") {
+            if (!parseContacts(words, 1, contacts)) {
+                qWarning() << fileName << "ligne" << lineNumber << ": contact invalide";
+                continue;
+            }
+            std::set<int>& target = (directive == "section") ? sharedSection :
+                                    (directive == "inversion") ? directionChanges : stations;
+            target.insert(contacts.begin(), contacts.end());
+        }
+        else if (directive == "loco") {
+            LocoConfig loco;
+            bool ok = words.size() >= 8 && words.at(6) == ":";
+            bool okNumber, okSpeed, okFront, okBack;
+            if (ok) {
+                loco.number = words.at(1).toInt(&okNumber);
+                loco.speed = words.at(2).toInt(&okSpeed);
+                loco.frontContact = words.at(3).toInt(&okFront);
+                loco.backContact = words.at(4).toInt(&okBack);
+                loco.route.clockwise = (words.at(5) == "horaire");
+                ok = okNumber && okSpeed && okFront && okBack &&
+                     loco.number >= 1 && loco.number <= MAX_LOCOS &&
+                     loco.speed >= 1 && loco.speed <= VITESSE_MAXIMUM &&
+                     loco.frontContact >= 1 && loco.frontContact <= MAX_CONTACTS &&
+                     loco.backContact >= 1 && loco.backContact <= MAX_CONTACTS &&
+                     (words.at(5) == "horaire" || words.at(5) == "antihoraire") &&
+                     parseContacts(words, 7, loco.route.path);
+            }
+            if (!ok) {
+                qWarning() << fileName << "ligne" << lineNumber << ": description de locomotive invalide";
+                continue;
+            }
+            // Deux comportements pilotant la même locomotive se contrediraient
+            if (!numbers.insert(loco.number).second) {
+                qWarning() << fileName << "ligne" << lineNumber << ": locomotive" << loco.number << "déjà décrite, ignorée";
+                continue;
+            }
+            loaded.push_back(loco);
+        }
+        else {
+            qWarning() << fileName << "ligne" << lineNumber << ": directive inconnue" << directive;
+        }
+    }
+
+    if (loaded.empty()) {
+        return false;
+    }
+
+    for (LocoConfig& loco : loaded) {
+        loco.route.sharedSectionContacts = sharedSection;
+        loco.route.directionChangePoints = directionChanges;
+        loco.route.stations = stations;
+    }
+    locos = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,63 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#ifndef FLEETCONFIG_H
+#define FLEETCONFIG_H
+
+#include <QString>
+#include <vector>
+
+#include "route.h"
+
+/**
+ * @brief Description d'une locomotive de la flotte
+ */
+struct LocoConfig
+{
+    int number{-1};
+    int speed{0};
+    int frontContact{-1};   // Contact vers lequel la locomotive se dirige au départ
+    int backContact{-1};    // Contact à l'arrière de la locomotive au départ
+    Route route;
+};
+
+/**
+ * @brief La classe FleetConfig décrit la flotte de locomotives à lancer.
+ *
+ * Format du fichier (une directive par ligne, # pour les commentaires) :
+ *
+ *     section 5 7 19 21 23
+ *     inversion 1 29
+ *     gare 11 27
+ *     loco <numéro> <vitesse> <contact avant> <contact arrière> <horaire|antihoraire> : <contacts du parcours>
+ *
+ * Les directives section, inversion et gare s'appliquent à toutes les locomotives.
+ */
+class FleetConfig
+{
+public:
+    /**
+     * @brief defaultFleet Retourne la flotte du laboratoire (deux locomotives sur la maquette A)
+     */
+    static FleetConfig defaultFleet();
+
+    /**
+     * @brief load Charge la flotte depuis un fichier. Au plus MAX_LOCOS locomotives
+     * sont retenues, les lignes invalides sont signalées et ignorées. Une locomotive
+     * doit avoir un numéro entre 1 et MAX_LOCOS, qui n'est pas déjà pris, et une
+     * vitesse entre 1 et VITESSE_MAXIMUM.
+     * @param fileName Chemin du fichier de flotte
+     * @return false si le fichier ne peut pas être lu ou ne décrit aucune locomotive
+     */
+    bool load(const QString& fileName);
+
+    std::vector<LocoConfig> locos;
+};
+
+#endif // FLEETCONFIG_H
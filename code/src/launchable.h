@@ -14,6 +14,9 @@
 #include <QDebug>
 
 #include <pcosynchro/pcothread.h>
+#include <pcosynchro/pcosemaphore.h>
+
+#include "executor.h"
 
 /*!
  * \brief La classe Launchable est une classe abstraite qui représente le fait d'avoir un thread
@@ -26,23 +29,43 @@ public:
     Launchable() {}
 
     /*!
-     * \brief startThread Lance un thread avec la fonction run()
+     * \brief setExecutor Choisit d'exécuter le comportement sur un pool de threads
+     * plutôt que sur un thread dédié. A appeler avant startThread().
+     * \param executor Le pool, ou nullptr pour un thread dédié
+     */
+    void setExecutor(Executor* executor) {
+        this->executor = executor;
+    }
+
+    /*!
+     * \brief startThread Lance un thread avec la fonction run(), ou soumet start()
+     * au pool si un exécuteur a été choisi
      */
     void startThread() {
-        if (thread == nullptr) {
+        if (thread == nullptr && !started) {
             printStartMessage();
-            thread = std::make_unique<PcoThread>(&Launchable::run, this);
+            if (executor != nullptr) {
+                started = true;
+                executor->post([this] { start(); });
+            }
+            else {
+                thread = std::make_unique<PcoThread>(&Launchable::run, this);
+            }
         }
     }
 
     /*!
-     * \brief join Attend la fin du thread lancé
+     * \brief join Attend la fin du thread lancé, ou l'appel à finish() sur le pool
      */
     void join() {
         if (thread != nullptr) {
             thread->join();
             printCompletionMessage();
         }
+        else if (started) {
+            finished.acquire();
+            printCompletionMessage();
+        }
     };
 
 protected:
@@ -53,6 +76,23 @@ protected:
      */
     virtual void run() = 0;
 
+    /*!
+     * \brief start Point d'entrée sur le pool. Par défaut, exécute run() sur un thread
+     * du pool ; les classes pilotées par événements la redéfinissent pour ne pas bloquer
+     * et appellent finish() lorsqu'elles ont terminé.
+     */
+    virtual void start() {
+        run();
+        finish();
+    }
+
+    /*!
+     * \brief finish Signale la fin du comportement lancé sur le pool
+     */
+    void finish() {
+        finished.release();
+    }
+
     /*!
      * \brief printStartMessage Message affiché au lancement du thread
      */
@@ -68,6 +108,21 @@ protected:
      */
     std::unique_ptr<PcoThread> thread = nullptr;
 
+    /*!
+     * \brief executor Le pool sur lequel le comportement est exécuté, s'il y en a un
+     */
+    Executor* executor = nullptr;
+
+    /*!
+     * \brief started Le comportement a-t-il été soumis au pool ?
+     */
+    bool started = false;
+
+    /*!
+     * \brief finished Libéré par finish()
+     */
+    PcoSemaphore finished{0};
+
 };
 
 #endif // LAUNCHABLE_H
@@ -14,19 +14,26 @@
 Locomotive::Locomotive() :
     _numero(-1),
     _vitesse(0),
-    _enFonction(false)
+    _enFonction(false),
+    _contexte(contexte_defaut())
 {
 
 }
 
-Locomotive::Locomotive(int numero, int vitesse) :
+Locomotive::Locomotive(int numero, int vitesse, TrainContext *contexte) :
     _numero(numero),
     _vitesse(vitesse),
-    _enFonction(false)
+    _enFonction(false),
+    _contexte(contexte)
 {
 
 }
 
+TrainContext *Locomotive::contexte() const
+{
+    return _contexte;
+}
+
 int Locomotive::numero() const
 {
     return _numero;
@@ -47,42 +54,48 @@ void Locomotive::fixerVitesse(int vitesse)
     _vitesse = vitesse;
 
     if (_enFonction)
-        mettre_vitesse_progressive(_numero, vitesse);
+        mettre_vitesse_progressive_ctx(_contexte, _numero, vitesse);
 }
 
 void Locomotive::fixerPosition(int contactAvant, int contactArriere)
 {
-    assigner_loco(contactAvant, contactArriere, _numero, _vitesse);
+    assigner_loco_ctx(_contexte, contactAvant, contactArriere, _numero, _vitesse);
 }
 
 void Locomotive::afficherMessage(const QString &message)
 {
-    afficher_message_loco(_numero, qPrintable(message));
+    afficher_message_loco_ctx(_contexte, _numero, qPrintable(message));
 }
 
 void Locomotive::allumerPhares()
 {
-    mettre_fonction_loco(_numero, ALLUME);
+    mettre_fonction_loco_ctx(_contexte, _numero, ALLUME);
 }
 
 void Locomotive::eteindrePhares()
 {
-    mettre_fonction_loco(_numero, ETEINT);
+    mettre_fonction_loco_ctx(_contexte, _numero, ETEINT);
 }
 
 void Locomotive::demarrer()
 {
-    mettre_vitesse_progressive(_numero, _vitesse);
+    mettre_vitesse_progressive_ctx(_contexte, _numero, _vitesse);
     _enFonction = true;
 }
 
 void Locomotive::arreter()
 {
-    arreter_loco(_numero);
+    arreter_loco_ctx(_contexte, _numero);
     _enFonction = false;
 }
 
+void Locomotive::vitesseAuContact(int vitesse, int contact)
+{
+    if (_enFonction)
+        mettre_vitesse_au_contact_ctx(_contexte, _numero, vitesse < _vitesse ? vitesse : _vitesse, contact);
+}
+
 void Locomotive::inverserSens()
 {
-    inverser_sens_loco(_numero);
+    inverser_sens_loco_ctx(_contexte, _numero);
 }
@@ -13,6 +13,8 @@
 
 #include <QString>
 
+#include "ctrain_handler.h"
+
 class Locomotive
 {
 
@@ -28,8 +30,14 @@ public:
      * Initialise la locomotive en precisant son numero et sa vitesse initiale.
      * @param numero Numero de la locomotive.
      * @param vitesse Vitesse initiale de la locomotive.
+     * @param contexte Simulation de la locomotive, celle de l'application par defaut.
+     */
+    Locomotive(int numero, int vitesse, TrainContext *contexte = contexte_defaut());
+
+    /** Retourne la simulation de la locomotive.
+     * @return Contexte a passer aux fonctions de ctrain_handler.h.
      */
-    Locomotive(int numero, int vitesse);
+    TrainContext *contexte() const;
 
     /** Retourne le numero de la locomotive.
      * @return Numero de la locomotive.
@@ -76,6 +84,15 @@ public:
     //! Arrete la locomotive.
     void arreter();
 
+    /** Ralentit la locomotive pour qu'elle franchisse un contact a la vitesse
+     * donnee, sans changer sa vitesse de consigne : demarrer() la lui rend.
+     * Le simulateur la fait freiner juste assez tot pour atteindre cette vitesse
+     * au contact.
+     * @param vitesse Vitesse au contact, bornee par la vitesse de consigne.
+     * @param contact Contact devant la locomotive.
+     */
+    void vitesseAuContact(int vitesse, int contact);
+
     //! Change le sens de marche de la locomotive.
     void inverserSens();
 
@@ -83,6 +100,7 @@ private:
     int _numero;
     int _vitesse;
     bool _enFonction;
+    TrainContext *_contexte;
 };
 
 #endif // LOCOMOTIVE_H
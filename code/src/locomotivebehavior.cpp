@@ -10,89 +10,203 @@
 
 #include "locomotivebehavior.h"
 #include "ctrain_handler.h"
-#include <set>
-
-// Définition des contacts pour chaque itinéraire
-// Chemin de la locomotive A (sens horaire)
-static const std::vector<int> pathA = {34, 1, 5, 7, 9, 11, 19, 21, 23, 25, 27, 29, 31, 33};
-// Chemin de la locomotive B (sens anti-horaire)
-static const std::vector<int> pathB = {31, 33, 1, 3, 5, 7, 15, 17, 19, 21, 23, 25, 27, 29};
-// Section partagée (contacts 5, 7, 19, 21, 23)
-static const std::set<int> sharedSectionContacts = {5, 7, 19, 21, 23};
-// Contacts où les locomotives changent de direction
-static const std::set<int> directionChangePoints = {1, 29};
+
+#include <pcosynchro/pcothread.h>
 
 void LocomotiveBehavior::run()
 {
     //Initialisation de la locomotive
-    loco.allumerPhares();
-    loco.demarrer();
-    loco.afficherMessage("Ready!");
-
-    /* A vous de jouer ! */
+    if (!initialize()) {
+        return;
+    }
 
     // Vous pouvez appeler les méthodes de la section partagée comme ceci :
     //sharedSection->access(loco);
     //sharedSection->leave(loco);
     //sharedSection->stopAtStation(loco);
 
-    // Déterminer l'itinéraire en fonction du numéro de la locomotive
-    const std::vector<int>& path = (loco.numero() == 7) ? pathA : pathB;
-    bool isClockwise = (loco.numero() == 7); // Loco A dans le sens horaire
-    
-    // Position initiale
-    size_t currentIndex = 0;
-    int currentContact = path[currentIndex];
-    bool inSharedSection = false;
-    
     while (true) {
-        // On attend qu'une locomotive arrive sur le contact 1.
-        // Pertinent de faire ça dans les deux threads? Pas sûr...
-        attendre_contact(currentContact);
-        loco.afficherMessage(QString("Contact %1").arg(currentContact));
-        
-        // Vérifier si on entre dans la section partagée
-        if (sharedSectionContacts.find(currentContact) != sharedSectionContacts.end() && !inSharedSection) {
-            sharedSection->access(loco, isClockwise ? SharedSectionInterface::Direction::D1 : SharedSectionInterface::Direction::D2);
-            inSharedSection = true;
-            loco.afficherMessage("Entrée en section partagée");
+        // On attend qu'une locomotive arrive sur le prochain contact du parcours
+        attendre_contact_ctx(loco.contexte(), route.path[currentIndex]);
+
+        if (handleContact()) {
+            sharedSection->access(loco, direction());
+            enterSharedSection();
         }
-        // Vérifier si on sort de la section partagée
-        else if (inSharedSection && sharedSectionContacts.find(currentContact) == sharedSectionContacts.end()) {
-            sharedSection->leave(loco, isClockwise ? SharedSectionInterface::Direction::D1 : SharedSectionInterface::Direction::D2);
-            inSharedSection = false;
-            loco.afficherMessage("Sortie de la section partagée");
-            
-            // Si une autre locomotive attend, on la laisse passer
-            sharedSection->release(loco);
+        else {
+            anticipate();
         }
-        
-        // Vérifier si c'est un point de changement de direction
-        if (directionChangePoints.find(currentContact) != directionChangePoints.end()) {
-            // Changer de direction (inverser le sens de parcours)
-            isClockwise = !isClockwise;
-            loco.inverserSens();
-            loco.afficherMessage(QString("Changement de direction: %1")
-                               .arg(isClockwise ? "Horaire" : "Anti-horaire"));
-            
-            // Ajuster l'index pour le prochain contact
-            if (isClockwise) {
-                currentIndex = (currentIndex + 1) % path.size();
-            } else {
-                currentIndex = (currentIndex == 0) ? path.size() - 1 : currentIndex - 1;
-            }
-        } else {
-            // Passer au prochain contact dans la direction actuelle
-            if (isClockwise) {
-                currentIndex = (currentIndex + 1) % path.size();
-            } else {
-                currentIndex = (currentIndex == 0) ? path.size() - 1 : currentIndex - 1;
-            }
+        if (stopsAtStation()) {
+            PcoThread::usleep(STATION_STOP_MS * 1000);
+            leaveStation();
+        }
+        advance();
+    }
+}
+
+void LocomotiveBehavior::start()
+{
+    if (!initialize()) {
+        finish();
+        return;
+    }
+    task = routine();
+    task.start(*executor, [this] { finish(); });
+}
+
+LocoTask LocomotiveBehavior::routine()
+{
+    // Même parcours que run(), sans bloquer de thread pendant les attentes
+    while (true) {
+        co_await contact(loco.contexte(), route.path[currentIndex]);
+
+        if (handleContact()) {
+            co_await sectionAccess(*sharedSection, loco, direction());
+            enterSharedSection();
         }
-        
-        // Mettre à jour le prochain contact à surveiller
-        currentContact = path[currentIndex];
+        else {
+            anticipate();
+        }
+        if (stopsAtStation()) {
+            co_await delay(loco.contexte(), STATION_STOP_MS);
+            leaveStation();
+        }
+        advance();
+    }
+}
+
+bool LocomotiveBehavior::initialize()
+{
+    loco.allumerPhares();
+    loco.demarrer();
+    loco.afficherMessage("Ready!");
+
+    // Position initiale
+    currentIndex = 0;
+    isClockwise = route.clockwise;
+    inSharedSection = false;
+    reservationPending = false;
+    reserved = false;
+    braking = false;
+
+    if (route.path.empty()) {
+        loco.afficherMessage("Aucun parcours défini");
+        return false;
+    }
+    return true;
+}
+
+SharedSectionInterface::Direction LocomotiveBehavior::direction() const
+{
+    return isClockwise ? SharedSectionInterface::Direction::D1 : SharedSectionInterface::Direction::D2;
+}
+
+bool LocomotiveBehavior::handleContact()
+{
+    int currentContact = route.path[currentIndex];
+    loco.afficherMessage(QString("Contact %1").arg(currentContact));
+
+    // Entrée et sortie de la section, selon le contact d'où l'on arrive
+    const std::uint16_t flags = route.flags[currentIndex];
+    const std::uint16_t entryFlag = isClockwise ? Route::EntryClockwise : Route::EntryCounterClockwise;
+    const std::uint16_t exitFlag = isClockwise ? Route::ExitClockwise : Route::ExitCounterClockwise;
+
+    // Vérifier si on entre dans la section partagée
+    if (!inSharedSection && (flags & entryFlag) != 0) {
+        debut_mesure_ctx(loco.contexte(), "attente_section", loco.numero());
+        return true;
+    }
+    // Vérifier si on sort de la section partagée
+    if (inSharedSection && (flags & exitFlag) != 0) {
+        sharedSection->leave(loco, direction());
+        inSharedSection = false;
+        loco.afficherMessage("Sortie de la section partagée");
+
+        // Si une autre locomotive attend, on la laisse passer
+        sharedSection->release(loco);
+    }
+    return false;
+}
+
+void LocomotiveBehavior::enterSharedSection()
+{
+    inSharedSection = true;
+    fin_mesure_ctx(loco.contexte(), "attente_section", loco.numero());
+    reservationPending = false;
+    reserved = false;
+    // Freinée en approche : elle reprend sa vitesse dans la section
+    if (braking.exchange(false)) {
+        loco.demarrer();
+    }
+    loco.afficherMessage("Entrée en section partagée");
+}
+
+void LocomotiveBehavior::anticipate()
+{
+    const std::uint16_t flags = route.flags[currentIndex];
+    const std::uint16_t reserveFlag = isClockwise ? Route::PreEntryClockwise : Route::PreEntryCounterClockwise;
+    const std::uint16_t brakeFlag = isClockwise ? Route::BrakeClockwise : Route::BrakeCounterClockwise;
+
+    if (!reservationPending && (flags & reserveFlag) != 0) {
+        reservationPending = true;
+        reserved = false;
+        sharedSection->reserveAsync(loco, direction(), [this] { reservationGranted(); });
+    }
+
+    // Un freinage annulé par reservationGranted() entre les deux lignes est repris
+    // à l'entrée de la section par enterSharedSection()
+    if (reservationPending && !reserved && (flags & brakeFlag) != 0) {
+        braking = true;
+        loco.vitesseAuContact(BRAKING_SPEED, route.path[nextIndex()]);
+        loco.afficherMessage("Section pas encore réservée : ralentissement");
+    }
+}
+
+void LocomotiveBehavior::reservationGranted()
+{
+    reserved = true;
+    if (braking.exchange(false)) {
+        loco.demarrer();
+    }
+}
+
+bool LocomotiveBehavior::stopsAtStation()
+{
+    if ((route.flags[currentIndex] & Route::Station) == 0) {
+        return false;
+    }
+    loco.arreter();
+    loco.afficherMessage(QString("Arrêt en gare au contact %1").arg(route.path[currentIndex]));
+    return true;
+}
+
+void LocomotiveBehavior::leaveStation()
+{
+    loco.demarrer();
+}
+
+void LocomotiveBehavior::advance()
+{
+    // Vérifier si c'est un point de changement de direction
+    if (route.flags[currentIndex] & Route::Reverse) {
+        // Changer de direction (inverser le sens de parcours)
+        isClockwise = !isClockwise;
+        loco.inverserSens();
+        loco.afficherMessage(QString("Changement de direction: %1")
+                           .arg(isClockwise ? "Horaire" : "Anti-horaire"));
+    }
+
+    // Passer au prochain contact dans la direction actuelle
+    currentIndex = nextIndex();
+}
+
+size_t LocomotiveBehavior::nextIndex() const
+{
+    const size_t size = route.path.size();
+    if (isClockwise) {
+        return (currentIndex + 1) % size;
     }
+    return (currentIndex == 0) ? size - 1 : currentIndex - 1;
 }
 
 void LocomotiveBehavior::printStartMessage()
@@ -13,6 +13,22 @@
 #include "locomotive.h"
 #include "launchable.h"
 #include "sharedsectioninterface.h"
+#include "fleetconfig.h"
+#include "routecompiler.h"
+#include "locotask.h"
+
+#include <atomic>
+
+/**
+ * @brief STATION_STOP_MS Durée de l'arrêt en gare
+ */
+constexpr int STATION_STOP_MS = 2000;
+
+/**
+ * @brief BRAKING_SPEED Vitesse d'approche de la section tant que la réservation
+ * n'a pas abouti
+ */
+constexpr int BRAKING_SPEED = VITESSE_MINIMUM;
 
 /**
  * @brief La classe LocomotiveBehavior représente le comportement d'une locomotive
@@ -23,12 +39,17 @@ public:
     /*!
      * \brief locomotiveBehavior Constructeur de la classe
      * \param loco la locomotive dont on représente le comportement
+     * \param route l'itinéraire suivi par la locomotive
      */
-    LocomotiveBehavior(Locomotive& loco, std::shared_ptr<SharedSectionInterface> sharedSection):
+    LocomotiveBehavior(Locomotive& loco, std::shared_ptr<SharedSectionInterface> sharedSection, Route route):
         loco(loco),
-        sharedSection(sharedSection)
+        sharedSection(sharedSection),
+        route(std::move(route))
     {
-        // Eventuel code supplémentaire du constructeur
+        // Itinéraire non compilé : table tirée de ses ensembles de contacts
+        if (this->route.flags.size() != this->route.path.size()) {
+            RouteCompiler::tabulate(this->route);
+        }
     }
 
 
@@ -38,6 +59,12 @@ protected:
      */
     void run() override;
 
+    /*!
+     * \brief start Version coroutine de run(), exécutée sur le pool : la coroutine
+     * est reprise sur le pool à chaque activation de contact ou accès obtenu
+     */
+    void start() override;
+
     /*!
      * \brief printStartMessage Message affiché lors du démarrage du thread
      */
@@ -58,6 +85,85 @@ protected:
      */
     std::shared_ptr<SharedSectionInterface> sharedSection;
 
+    /**
+     * @brief route L'itinéraire de la locomotive
+     */
+    Route route;
+
+private:
+    /*!
+     * \brief initialize Démarre la locomotive et se place au début du parcours
+     * \return false si le parcours est vide
+     */
+    bool initialize();
+
+    /*!
+     * \brief handleContact Traite l'arrivée sur le contact courant : sortie de la
+     * section partagée si nécessaire
+     * \return true si la locomotive doit demander l'accès à la section partagée
+     */
+    bool handleContact();
+
+    /*!
+     * \brief enterSharedSection Appelée une fois l'accès à la section obtenu
+     */
+    void enterSharedSection();
+
+    /*!
+     * \brief anticipate Réserve la section aux contacts qui précèdent son entrée, et
+     * ralentit la locomotive au point de freinage si la réservation n'a pas abouti
+     */
+    void anticipate();
+
+    /*!
+     * \brief reservationGranted Appelée, éventuellement par un autre thread, lorsque
+     * la section est attribuée à la locomotive
+     */
+    void reservationGranted();
+
+    /*!
+     * \brief stopsAtStation Arrête la locomotive si le contact courant est une gare
+     * \return true si la locomotive doit attendre STATION_STOP_MS avant leaveStation()
+     */
+    bool stopsAtStation();
+
+    /*!
+     * \brief leaveStation Redémarre la locomotive après l'arrêt en gare
+     */
+    void leaveStation();
+
+    /*!
+     * \brief advance Passe au contact suivant, en changeant de sens si nécessaire
+     */
+    void advance();
+
+    /*!
+     * \brief nextIndex Position du prochain contact du parcours dans la direction actuelle
+     */
+    size_t nextIndex() const;
+
+    /*!
+     * \brief direction Direction de la locomotive pour la section partagée
+     */
+    SharedSectionInterface::Direction direction() const;
+
+    /*!
+     * \brief routine Comportement de la locomotive, sous forme de coroutine (mode pool)
+     */
+    LocoTask routine();
+
+    /*!
+     * \brief task La coroutine en cours d'exécution (mode pool)
+     */
+    LocoTask task;
+
+    size_t currentIndex{0};
+    bool isClockwise{true};
+    bool inSharedSection{false};
+    bool reservationPending{false};
+    std::atomic<bool> reserved{false};
+    std::atomic<bool> braking{false};
+
     /*
      * Vous êtes libres d'ajouter des méthodes ou attributs
      *
@@ -0,0 +1,178 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#ifndef LOCOTASK_H
+#define LOCOTASK_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <utility>
+
+#include "executor.h"
+#include "sharedsectioninterface.h"
+#include "ctrain_handler.h"
+
+/**
+ * @brief La classe LocoTask est le type de retour des coroutines de comportement.
+ *
+ * La coroutine est créée suspendue ; start() la soumet à un Executor. Chaque reprise
+ * (contact activé, accès obtenu, délai écoulé) est soumise au même Executor, ce qui
+ * permet de faire tourner un grand nombre de comportements sur quelques threads.
+ */
+class LocoTask
+{
+public:
+    struct promise_type
+    {
+        Executor* executor{nullptr};
+        std::function<void()> onDone;
+
+        LocoTask get_return_object() {
+            return LocoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                // Le cadre reste valide jusqu'à la destruction de la LocoTask
+                if (handle.promise().onDone) {
+                    handle.promise().onDone();
+                }
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    LocoTask() = default;
+    explicit LocoTask(Handle handle) : handle(handle) {}
+    LocoTask(LocoTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    LocoTask& operator=(LocoTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    LocoTask(const LocoTask&) = delete;
+    LocoTask& operator=(const LocoTask&) = delete;
+
+    ~LocoTask() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /**
+     * @brief start Lance la coroutine sur l'exécuteur
+     * @param executor L'exécuteur sur lequel la coroutine est reprise
+     * @param onDone Fonction appelée lorsque la coroutine se termine
+     */
+    void start(Executor& executor, std::function<void()> onDone = nullptr) {
+        handle.promise().executor = &executor;
+        handle.promise().onDone = std::move(onDone);
+        resume(handle);
+    }
+
+    /**
+     * @brief resume Soumet la reprise d'une coroutine à son exécuteur
+     */
+    static void resume(Handle handle) {
+        handle.promise().executor->post([handle] { handle.resume(); });
+    }
+
+private:
+    Handle handle{nullptr};
+};
+
+/**
+ * @brief contact Attend l'activation d'un contact de la simulation contexte :
+ * co_await contact(contexte, n);
+ */
+inline auto contact(TrainContext* contexte, int numero)
+{
+    struct ContactAwaiter
+    {
+        TrainContext* contexte;
+        int numero;
+        LocoTask::Handle handle{nullptr};
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(LocoTask::Handle h) {
+            handle = h;
+            // Rien ne doit suivre : la coroutine peut être reprise avant le retour
+            attendre_contact_async_ctx(contexte, numero, &ContactAwaiter::reached, this);
+        }
+        void await_resume() const noexcept {}
+
+        static void reached(int /*contact*/, void* data) {
+            LocoTask::resume(static_cast<ContactAwaiter*>(data)->handle);
+        }
+    };
+    return ContactAwaiter{contexte, numero};
+}
+
+/**
+ * @brief delay Attend un délai, mesuré par la boucle d'événements du simulateur :
+ * co_await delay(contexte, ms);
+ */
+inline auto delay(TrainContext* contexte, int ms)
+{
+    struct DelayAwaiter
+    {
+        TrainContext* contexte;
+        int ms;
+        LocoTask::Handle handle{nullptr};
+
+        bool await_ready() const noexcept { return ms <= 0; }
+        void await_suspend(LocoTask::Handle h) {
+            handle = h;
+            attendre_delai_async_ctx(contexte, ms, &DelayAwaiter::elapsed, this);
+        }
+        void await_resume() const noexcept {}
+
+        static void elapsed(void* data) {
+            LocoTask::resume(static_cast<DelayAwaiter*>(data)->handle);
+        }
+    };
+    return DelayAwaiter{contexte, ms};
+}
+
+/**
+ * @brief sectionAccess Demande l'accès à une section partagée sans bloquer de thread :
+ * co_await sectionAccess(section, loco, d);
+ */
+inline auto sectionAccess(SharedSectionInterface& section, Locomotive& loco, SharedSectionInterface::Direction d)
+{
+    struct AccessAwaiter
+    {
+        SharedSectionInterface& section;
+        Locomotive& loco;
+        SharedSectionInterface::Direction d;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(LocoTask::Handle h) {
+            section.accessAsync(loco, d, [h] { LocoTask::resume(h); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return AccessAwaiter{section, loco, d};
+}
+
+#endif // LOCOTASK_H
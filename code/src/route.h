@@ -0,0 +1,76 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Position d'un aiguillage requise par un itinéraire
+ */
+struct SwitchSetting
+{
+    int number;
+    int direction;   // DEVIE ou TOUT_DROIT
+
+    bool operator==(const SwitchSetting& other) const
+    {
+        return number == other.number && direction == other.direction;
+    }
+};
+
+/**
+ * @brief RESERVATION_LOOKAHEAD Nombre de contacts avant l'entrée de la section
+ * auquel la locomotive en demande la réservation
+ */
+constexpr int RESERVATION_LOOKAHEAD = 2;
+
+/**
+ * @brief Itinéraire d'une locomotive : la suite des contacts à parcourir et
+ * les contacts particuliers de la maquette.
+ */
+struct Route
+{
+    /**
+     * @brief Propriétés d'un contact du parcours, un bit chacune. L'entrée et la
+     * sortie de la section, la réservation anticipée et le freinage dépendent du
+     * sens dans lequel le contact est atteint.
+     */
+    enum Flag : std::uint16_t {
+        Shared                  = 1 << 0,   // Contact de la section partagée
+        Reverse                 = 1 << 1,   // La locomotive y change de sens
+        Station                 = 1 << 2,   // La locomotive s'y arrête
+        SwitchAhead             = 1 << 3,   // Un aiguillage à diriger suit, dans le sens initial
+        EntryClockwise          = 1 << 4,   // Entrée dans la section, en sens horaire
+        ExitClockwise           = 1 << 5,   // Sortie de la section, en sens horaire
+        EntryCounterClockwise   = 1 << 6,   // Entrée dans la section, en sens anti-horaire
+        ExitCounterClockwise    = 1 << 7,   // Sortie de la section, en sens anti-horaire
+        PreEntryClockwise       = 1 << 8,   // Réserver la section, en sens horaire
+        PreEntryCounterClockwise = 1 << 9,  // Réserver la section, en sens anti-horaire
+        BrakeClockwise          = 1 << 10,  // Ralentir si la réservation n'a pas abouti, en sens horaire
+        BrakeCounterClockwise   = 1 << 11   // Ralentir si la réservation n'a pas abouti, en sens anti-horaire
+    };
+
+    std::vector<int> path;                 // Contacts parcourus, dans l'ordre
+    bool clockwise{true};                  // Sens de parcours initial de path
+    std::set<int> sharedSectionContacts;   // Contacts de la section partagée
+    std::set<int> directionChangePoints;   // Contacts où la locomotive change de sens
+    std::set<int> stations;                // Contacts où la locomotive s'arrête
+
+    // Table produite par RouteCompiler, indexée par la position dans path : les
+    // Flag de chaque contact, que le comportement lit sans chercher dans les
+    // ensembles. Elle n'est plus modifiée une fois le comportement construit.
+    std::vector<std::uint16_t> flags;
+    std::vector<SwitchSetting> switches;   // Aiguillages à diriger pour suivre path
+};
+
+#endif // ROUTE_H
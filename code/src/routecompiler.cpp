@@ -0,0 +1,173 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#include "routecompiler.h"
+
+#include <algorithm>
+
+bool RouteCompiler::mergeSwitches(std::vector<SwitchSetting>& merged, const std::vector<SwitchSetting>& added)
+{
+    for (const SwitchSetting& setting : added) {
+        auto known = std::find_if(merged.begin(), merged.end(),
+                                  [&](const SwitchSetting& s) { return s.number == setting.number; });
+        if (known == merged.end()) {
+            merged.push_back(setting);
+        }
+        else if (known->direction != setting.direction) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RouteCompiler::tabulate(Route& route, const std::vector<std::uint8_t>& switchAhead)
+{
+    const size_t size = route.path.size();
+    auto shared = [&](size_t i) { return route.sharedSectionContacts.count(route.path[i]) > 0; };
+
+    route.flags.assign(size, 0);
+    for (size_t i = 0; i < size; ++i) {
+        std::uint16_t& flags = route.flags[i];
+        bool here = shared(i);
+        // Contacts d'où l'on arrive en i, dans chaque sens
+        bool before = shared((i + size - 1) % size);
+        bool after = shared((i + 1) % size);
+
+        if (here) {
+            flags |= Route::Shared;
+        }
+        if (route.directionChangePoints.count(route.path[i])) {
+            flags |= Route::Reverse;
+        }
+        if (route.stations.count(route.path[i])) {
+            flags |= Route::Station;
+        }
+        if (i < switchAhead.size() && switchAhead[i]) {
+            flags |= Route::SwitchAhead;
+        }
+        if (here != before) {
+            flags |= here ? Route::EntryClockwise : Route::ExitClockwise;
+        }
+        if (here != after) {
+            flags |= here ? Route::EntryCounterClockwise : Route::ExitCounterClockwise;
+        }
+    }
+
+    // Réservation RESERVATION_LOOKAHEAD contacts avant chaque entrée, freinage au
+    // contact qui la précède. On ne remonte ni dans la section (la locomotive ne
+    // l'a pas encore libérée) ni au-delà d'un changement de sens (la locomotive
+    // n'atteindrait pas l'entrée).
+    auto markAhead = [&](size_t entry, bool clockwise, std::uint16_t reserve, std::uint16_t brake) {
+        for (size_t k = 1; k <= RESERVATION_LOOKAHEAD && k < size; ++k) {
+            size_t i = clockwise ? (entry + size - k) % size : (entry + k) % size;
+            if (route.flags[i] & (Route::Shared | Route::Reverse)) {
+                return;
+            }
+            if (k == 1) {
+                route.flags[i] |= brake;
+            }
+            if (k == RESERVATION_LOOKAHEAD) {
+                route.flags[i] |= reserve;
+            }
+        }
+    };
+    for (size_t i = 0; i < size; ++i) {
+        if (route.flags[i] & Route::EntryClockwise) {
+            markAhead(i, true, Route::PreEntryClockwise, Route::BrakeClockwise);
+        }
+        if (route.flags[i] & Route::EntryCounterClockwise) {
+            markAhead(i, false, Route::PreEntryCounterClockwise, Route::BrakeCounterClockwise);
+        }
+    }
+}
+
+bool RouteCompiler::expand(const Route& route, const std::vector<int>& waypoints,
+                           std::vector<int>& contacts, std::vector<std::uint8_t>& switchAhead,
+                           std::vector<SwitchSetting>& switches, std::set<int>& shared) const
+{
+    const size_t size = waypoints.size();
+    contacts.clear();
+    switchAhead.clear();
+
+    // Le parcours est une boucle : on arrive au premier point depuis le dernier,
+    // sauf si la locomotive y change de sens.
+    int previous = route.directionChangePoints.count(waypoints.front()) ? 0 : waypoints.back();
+
+    for (size_t i = 0; i < size; ++i) {
+        int from = waypoints[i];
+        int to = waypoints[(i + 1) % size];
+        if (route.directionChangePoints.count(from)) {
+            previous = 0;
+        }
+
+        std::vector<int> leg;
+        std::vector<SwitchSetting> legSwitches;
+        if (!solver(previous, from, to, leg, legSwitches) || leg.size() < 2 ||
+            leg.front() != from || leg.back() != to ||
+            !mergeSwitches(switches, legSwitches)) {
+            return false;
+        }
+
+        // Un tronçon entre deux contacts de la section en fait partie
+        if (route.sharedSectionContacts.count(from) && route.sharedSectionContacts.count(to)) {
+            shared.insert(leg.begin(), leg.end());
+        }
+
+        // Le point d'arrivée est le départ du tronçon suivant
+        contacts.insert(contacts.end(), leg.begin(), leg.end() - 1);
+        switchAhead.push_back(!legSwitches.empty());
+        switchAhead.resize(contacts.size(), 0);
+        previous = leg[leg.size() - 2];
+    }
+    return true;
+}
+
+bool RouteCompiler::compile(Route& route) const
+{
+    if (route.path.size() < 2) {
+        tabulate(route);
+        return true;
+    }
+
+    // Dans le sens de parcours initial
+    std::vector<int> waypoints = route.path;
+    if (!route.clockwise) {
+        std::reverse(waypoints.begin(), waypoints.end());
+    }
+
+    Route compiled = route;
+    std::vector<std::uint8_t> switchAhead;
+    if (!expand(route, waypoints, compiled.path, switchAhead, compiled.switches, compiled.sharedSectionContacts)) {
+        return false;
+    }
+
+    // Au retour, les aiguillages pris en talon à l'aller sont pris en pointe
+    if (!route.directionChangePoints.empty()) {
+        std::vector<int> backWaypoints(waypoints.rbegin(), waypoints.rend());
+        std::vector<int> backContacts;
+        std::vector<std::uint8_t> backSwitchAhead;
+        if (!expand(route, backWaypoints, backContacts, backSwitchAhead,
+                    compiled.switches, compiled.sharedSectionContacts)) {
+            return false;
+        }
+    }
+
+    if (!route.clockwise) {
+        // path reste donné dans le sens horaire, en commençant par le même contact
+        std::reverse(compiled.path.begin(), compiled.path.end());
+        std::reverse(switchAhead.begin(), switchAhead.end());
+        auto first = std::find(compiled.path.begin(), compiled.path.end(), route.path.front());
+        std::rotate(switchAhead.begin(), switchAhead.begin() + (first - compiled.path.begin()), switchAhead.end());
+        std::rotate(compiled.path.begin(), first, compiled.path.end());
+    }
+
+    tabulate(compiled, switchAhead);
+    route = std::move(compiled);
+    return true;
+}
@@ -0,0 +1,82 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#ifndef ROUTECOMPILER_H
+#define ROUTECOMPILER_H
+
+#include <functional>
+#include <vector>
+
+#include "route.h"
+
+/**
+ * @brief La classe RouteCompiler complète un itinéraire à partir du graphe de la
+ * maquette : les contacts donnés dans path servent de points de passage, chaque
+ * tronçon entre deux points est remplacé par la suite exacte des contacts franchis,
+ * et les positions d'aiguillages nécessaires sont relevées.
+ *
+ * Les contacts ajoutés entre deux contacts de la section partagée en font partie.
+ * Si l'itinéraire comporte des changements de sens, il est aussi calculé dans
+ * l'autre sens, pour relever les aiguillages pris en pointe au retour.
+ */
+class RouteCompiler
+{
+public:
+    /**
+     * @brief Calcule un tronçon de from à to, en arrivant en from depuis previous
+     * (0 pour un sens quelconque). Remplit contacts (from et to compris) et les
+     * aiguillages à diriger, et retourne false s'il n'y a pas de chemin.
+     */
+    using LegSolver = std::function<bool(int previous, int from, int to,
+                                         std::vector<int>& contacts,
+                                         std::vector<SwitchSetting>& switches)>;
+
+    /**
+     * @brief RouteCompiler Constructeur
+     * @param solver Calcul des tronçons, en général calculer_itineraire() du simulateur
+     */
+    explicit RouteCompiler(LegSolver solver) : solver(std::move(solver)) {}
+
+    /**
+     * @brief compile Complète l'itinéraire et remplit ses tables
+     * @param route L'itinéraire, laissé intact en cas d'échec
+     * @return false si un tronçon n'a pas de chemin ou si deux tronçons demandent
+     * des positions différentes pour un même aiguillage
+     */
+    bool compile(Route& route) const;
+
+    /**
+     * @brief tabulate Remplit la table de l'itinéraire sans le compléter, à partir
+     * de ses ensembles de contacts
+     * @param switchAhead Positions suivies d'un aiguillage à diriger (vide si inconnues)
+     */
+    static void tabulate(Route& route, const std::vector<std::uint8_t>& switchAhead = {});
+
+    /**
+     * @brief mergeSwitches Ajoute des positions d'aiguillages à celles déjà relevées
+     * @return false si un aiguillage est demandé dans deux positions différentes
+     */
+    static bool mergeSwitches(std::vector<SwitchSetting>& merged, const std::vector<SwitchSetting>& added);
+
+private:
+    /**
+     * @brief expand Calcule les tronçons successifs de waypoints : les contacts
+     * franchis, les aiguillages ajoutés à switches et les contacts ajoutés à la
+     * section partagée shared. switchAhead marque le départ de chaque tronçon
+     * qui demande un aiguillage.
+     * @return false si un tronçon n'a pas de chemin
+     */
+    bool expand(const Route& route, const std::vector<int>& waypoints,
+                std::vector<int>& contacts, std::vector<std::uint8_t>& switchAhead,
+                std::vector<SwitchSetting>& switches, std::set<int>& shared) const;
+
+    LegSolver solver;
+};
+
+#endif // ROUTECOMPILER_H
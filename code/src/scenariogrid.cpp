@@ -0,0 +1,106 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#include "scenariogrid.h"
+
+#include <sstream>
+
+std::string Scenario::value(const std::string& name, const std::string& defaultValue) const
+{
+    for (const auto& parameter : parameters) {
+        if (parameter.first == name) {
+            return parameter.second;
+        }
+    }
+    return defaultValue;
+}
+
+bool ScenarioGrid::parse(std::istream& in, std::string& error)
+{
+    std::vector<std::pair<std::string, std::vector<std::string>>> parsed;
+    int parsedRepetitions = 1;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream words(line);
+        std::string name;
+        if (!(words >> name)) {
+            continue;
+        }
+        std::vector<std::string> values;
+        for (std::string value; words >> value;) {
+            values.push_back(value);
+        }
+
+        const std::string where = "ligne " + std::to_string(lineNumber) + " : ";
+        if (values.empty()) {
+            error = where + "aucune valeur pour " + name;
+            return false;
+        }
+        if (name == "repetitions") {
+            std::istringstream number(values.front());
+            if (values.size() != 1 || !(number >> parsedRepetitions) || !number.eof() || parsedRepetitions < 1) {
+                error = where + "nombre de répétitions invalide";
+                return false;
+            }
+            continue;
+        }
+        for (const auto& axis : parsed) {
+            if (axis.first == name) {
+                error = where + "paramètre " + name + " déjà donné";
+                return false;
+            }
+        }
+        parsed.emplace_back(name, std::move(values));
+    }
+
+    axes = std::move(parsed);
+    repetitions = parsedRepetitions;
+    return true;
+}
+
+std::vector<Scenario> ScenarioGrid::expand() const
+{
+    std::vector<Scenario> scenarios;
+
+    // Compteur en base variable : une position par paramètre
+    std::vector<size_t> positions(axes.size(), 0);
+    while (true) {
+        Scenario scenario;
+        for (size_t i = 0; i < axes.size(); ++i) {
+            scenario.parameters.emplace_back(axes[i].first, axes[i].second[positions[i]]);
+        }
+        for (int r = 0; r < repetitions; ++r) {
+            scenario.repetition = r;
+            scenarios.push_back(scenario);
+        }
+
+        size_t i = axes.size();
+        while (i > 0 && ++positions[i - 1] == axes[i - 1].second.size()) {
+            positions[i - 1] = 0;
+            --i;
+        }
+        if (i == 0) {
+            return scenarios;
+        }
+    }
+}
+
+std::vector<std::string> ScenarioGrid::names() const
+{
+    std::vector<std::string> result;
+    for (const auto& axis : axes) {
+        result.push_back(axis.first);
+    }
+    return result;
+}
@@ -0,0 +1,71 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#ifndef SCENARIOGRID_H
+#define SCENARIOGRID_H
+
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Une simulation de la grille : une valeur par paramètre, et le numéro
+ * de la répétition
+ */
+struct Scenario
+{
+    std::vector<std::pair<std::string, std::string>> parameters;
+    int repetition{0};
+
+    /**
+     * @brief value Retourne la valeur d'un paramètre, ou defaultValue s'il ne
+     * fait pas partie de la grille
+     */
+    std::string value(const std::string& name, const std::string& defaultValue = "") const;
+};
+
+/**
+ * @brief La classe ScenarioGrid décrit les simulations lancées par qtrainsim_batch.
+ *
+ * Format du fichier (une directive par ligne, # pour les commentaires) :
+ *
+ *     <paramètre> <valeur> [<valeur> ...]
+ *     repetitions <nombre>
+ *
+ * Chaque combinaison des valeurs des paramètres est simulée repetitions fois
+ * (une fois par défaut).
+ */
+class ScenarioGrid
+{
+public:
+    /**
+     * @brief parse Lit la grille
+     * @param error Description de la première erreur rencontrée
+     * @return false si une ligne est invalide ou si un paramètre est donné deux fois
+     */
+    bool parse(std::istream& in, std::string& error);
+
+    /**
+     * @brief expand Retourne toutes les simulations de la grille, le premier
+     * paramètre variant le plus lentement et les répétitions le plus vite
+     */
+    std::vector<Scenario> expand() const;
+
+    /**
+     * @brief names Retourne les noms des paramètres, dans l'ordre du fichier
+     */
+    std::vector<std::string> names() const;
+
+private:
+    std::vector<std::pair<std::string, std::vector<std::string>>> axes;
+    int repetitions{1};
+};
+
+#endif // SCENARIOGRID_H
@@ -15,6 +15,9 @@
 
 #include <pcosynchro/pcosemaphore.h>
 
+#include <deque>
+#include <functional>
+
 #ifdef USE_FAKE_LOCO
 #  include "fake_locomotive.h"
 #else
@@ -30,6 +33,9 @@
 /**
  * @brief La classe SharedSection implémente l'interface SharedSectionInterface qui
  * propose les méthodes liées à la section partagée.
+ * Une locomotive doit appeler access(), puis leave() dans la même direction, puis
+ * release(). release() transmet directement la section à une locomotive en attente,
+ * de la direction opposée d'abord. Tout autre enchaînement est compté comme une erreur.
  */
 class SharedSection final : public SharedSectionInterface
 {
@@ -40,43 +46,125 @@ public:
      * Initialisez vos éventuels attributs ici, sémaphores etc.
      */
     SharedSection()
-    : _mutex(1), _semD1(0), _semD2(0), 
-      _waitingD1(0), _waitingD2(0), 
-      _inD1(false), _inD2(false),
+    : _mutex(1),
+      _occupied(false), _occupant(nullptr), _direction(Direction::D1),
+      _left(false), _reserved(false), _stopped(false),
       _errorCount(0) {
     }
 
     /**
-     * @brief Méthode appelée lorsqu'une locomotive souhaite accéder à la section partagée
+     * @brief Méthode appelée lorsqu'une locomotive souhaite accéder à la section partagée.
+     * Si la section est occupée, la locomotive est arrêtée puis redémarrée une fois l'accès
+     * obtenu. Un second accès par la locomotive déjà dans la section est une erreur.
      * @param loco La locomotive qui demande l'accès
      * @param d La direction de la locomotive
      */
     void access(Locomotive& loco, Direction d) override {
+        PcoSemaphore granted(0);
+        accessAsync(loco, d, [&granted] { granted.release(); });
+        granted.acquire();
+    }
+
+    /**
+     * @brief Version non bloquante de access(). Si la section est libre, granted est
+     * appelée immédiatement ; sinon la locomotive est arrêtée, et c'est release() qui
+     * la redémarre puis appelle granted lorsqu'elle lui transmet la section.
+     * @param loco La locomotive qui demande l'accès
+     * @param d La direction de la locomotive
+     * @param granted Fonction appelée une fois l'accès obtenu
+     */
+    void accessAsync(Locomotive& loco, Direction d, std::function<void()> granted) override {
         _mutex.acquire();
-        
-        if ((d == Direction::D1 && _inD1) || (d == Direction::D2 && _inD2)) {
-            // Already in the section in the same direction, no need to wait
+
+        if (_occupant == &loco) {
+            // Section réservée à l'avance : la locomotive entre sans s'arrêter
+            if (_reserved && _direction == d) {
+                _reserved = false;
+                _mutex.release();
+                granted();
+                return;
+            }
+            // Accès consécutifs sans leave() : erreur de protocole
+            _errorCount++;
             _mutex.release();
+            granted();
             return;
         }
 
-        if (d == Direction::D1) {
-            _waitingD1++;
+        if (_stopped) {
             _mutex.release();
-            _semD1.acquire();
-            _mutex.acquire();
-            _waitingD1--;
-            _inD1 = true;
-        } else {
-            _waitingD2++;
+            loco.arreter();
+            granted();
+            return;
+        }
+
+        // Réservation pas encore accordée : la locomotive attend à l'entrée
+        Waiter* reservation = findWaiter(loco, d);
+        if (reservation != nullptr) {
+            reservation->granted = std::move(granted);
+            reservation->stopped = true;
             _mutex.release();
-            _semD2.acquire();
-            _mutex.acquire();
-            _waitingD2--;
-            _inD2 = true;
+            loco.arreter();
+            return;
         }
-        
+
+        if (_occupied) {
+            // La section nous sera transmise directement par release()
+            waitingOf(d).push_back({&loco, std::move(granted), nullptr, true});
+            _mutex.release();
+            loco.arreter();
+            return;
+        }
+
+        _occupied = true;
+        _occupant = &loco;
+        _direction = d;
+        _left = false;
+        _reserved = false;
         _mutex.release();
+
+        granted();
+    }
+
+    /**
+     * @brief Réservation anticipée. Si la section est libre, elle est attribuée à la
+     * locomotive et granted est appelée immédiatement ; sinon la demande prend place
+     * dans la file de sa direction, sans arrêter la locomotive, et c'est release()
+     * qui appelle granted. L'accès à l'entrée est alors immédiat.
+     * @param loco La locomotive qui réserve
+     * @param d La direction de la locomotive
+     * @param granted Fonction appelée une fois la section attribuée
+     */
+    void reserveAsync(Locomotive& loco, Direction d, std::function<void()> granted) override {
+        _mutex.acquire();
+
+        if (_occupant == &loco || findWaiter(loco, d) != nullptr) {
+            // Réservation en double : erreur de protocole
+            _errorCount++;
+            _mutex.release();
+            return;
+        }
+
+        // Après un arrêt d'urgence, c'est l'accès à l'entrée qui arrête la locomotive
+        if (_stopped) {
+            _mutex.release();
+            return;
+        }
+
+        if (_occupied) {
+            waitingOf(d).push_back({&loco, nullptr, std::move(granted), false});
+            _mutex.release();
+            return;
+        }
+
+        _occupied = true;
+        _occupant = &loco;
+        _direction = d;
+        _left = false;
+        _reserved = true;
+        _mutex.release();
+
+        granted();
     }
 
     /**
@@ -86,62 +174,59 @@ public:
      */
     void leave(Locomotive& loco, Direction d) override {
         _mutex.acquire();
-        
-        if (d == Direction::D1) {
-            if (!_inD1) {
-                _errorCount++;
-                _mutex.release();
-                return;
-            }
-            _inD1 = false;
-            
-            // If there are trains waiting in the opposite direction, let them pass first
-            if (_waitingD2 > 0) {
-                _semD2.release();
-            } else if (_waitingD1 > 0) {
-                // If no opposite direction, let same direction pass
-                _semD1.release();
-            } else {
-                _mutex.release();
-            }
-        } else {
-            if (!_inD2) {
-                _errorCount++;
-                _mutex.release();
-                return;
-            }
-            _inD2 = false;
-            
-            // If there are trains waiting in the opposite direction, let them pass first
-            if (_waitingD1 > 0) {
-                _semD1.release();
-            } else if (_waitingD2 > 0) {
-                // If no opposite direction, let same direction pass
-                _semD2.release();
-            } else {
-                _mutex.release();
-            }
+
+        if (_occupant != &loco || _direction != d || _left || _reserved) {
+            _errorCount++;
+            _mutex.release();
+            return;
         }
+        _left = true;
+
+        _mutex.release();
     }
 
     /**
-     * @brief Méthode appelée pour libérer la section partagée après un leave()
+     * @brief Méthode appelée pour libérer la section partagée après un leave().
+     * La section est transmise en priorité à une locomotive attendant dans la direction
+     * opposée, sinon à une locomotive attendant dans la même direction.
      * @param loco La locomotive qui libère la section
      */
     void release(Locomotive& loco) override {
         _mutex.acquire();
-        
-        // If the train was going in D1 direction, check if there are D2 trains waiting
-        if (_inD1 && _waitingD2 > 0) {
-            _semD2.release();
-        } 
-        // If the train was going in D2 direction, check if there are D1 trains waiting
-        else if (_inD2 && _waitingD1 > 0) {
-            _semD1.release();
-        }
-        // If no opposite direction trains, release the mutex
-        else {
+
+        if (_occupant != &loco || !_left) {
+            _errorCount++;
+            _mutex.release();
+            return;
+        }
+
+        _occupant = nullptr;
+        _left = false;
+
+        Direction opposite = (_direction == Direction::D1) ? Direction::D2 : Direction::D1;
+        Direction next = !waitingOf(opposite).empty() ? opposite : _direction;
+        if (waitingOf(next).empty()) {
+            _occupied = false;
             _mutex.release();
+            return;
+        }
+
+        Waiter waiter = std::move(waitingOf(next).front());
+        waitingOf(next).pop_front();
+        _occupant = waiter.loco;
+        _direction = next;
+        // Une locomotive qui n'est pas encore à l'entrée y passera sans s'arrêter
+        _reserved = !waiter.granted;
+        _mutex.release();
+
+        if (waiter.stopped) {
+            waiter.loco->demarrer();
+        }
+        if (waiter.reserved) {
+            waiter.reserved();
+        }
+        if (waiter.granted) {
+            waiter.granted();
         }
     }
 
@@ -150,20 +235,25 @@ public:
      */
     void stopAll() override {
         _mutex.acquire();
-        
-        // Release all waiting locomotives
-        while (_waitingD1 > 0) {
-            _semD1.release();
-            _waitingD1--;
-        }
-        while (_waitingD2 > 0) {
-            _semD2.release();
-            _waitingD2--;
-        }
-        
-        _inD1 = false;
-        _inD2 = false;
+
+        _stopped = true;
+        std::deque<Waiter> waiters;
+        for (Direction d : {Direction::D1, Direction::D2}) {
+            while (!waitingOf(d).empty()) {
+                waiters.push_back(std::move(waitingOf(d).front()));
+                waitingOf(d).pop_front();
+            }
+        }
+
         _mutex.release();
+
+        // Les locomotives en attente sont déjà arrêtées, on les libère sans les redémarrer.
+        // Celles qui n'avaient que réservé seront arrêtées à l'entrée.
+        for (Waiter& waiter : waiters) {
+            if (waiter.granted) {
+                waiter.granted();
+            }
+        }
     }
 
     /**
@@ -171,17 +261,40 @@ public:
      * @return Le nombre d'erreurs
      */
     int nbErrors() override {
-        return _errorCount;
+        _mutex.acquire();
+        int errors = _errorCount;
+        _mutex.release();
+        return errors;
     }
 
 private:
+    struct Waiter {
+        Locomotive* loco;
+        std::function<void()> granted;    // Accès demandé à l'entrée (vide si pas encore arrivée)
+        std::function<void()> reserved;   // Réservation anticipée (vide sinon)
+        bool stopped;                     // La locomotive attend, arrêtée, à l'entrée
+    };
+
+    std::deque<Waiter>& waitingOf(Direction d) { return d == Direction::D1 ? _waitingD1 : _waitingD2; }
+
+    Waiter* findWaiter(Locomotive& loco, Direction d) {
+        for (Waiter& waiter : waitingOf(d)) {
+            if (waiter.loco == &loco) {
+                return &waiter;
+            }
+        }
+        return nullptr;
+    }
+
     PcoSemaphore _mutex;      // Mutex pour les sections critiques
-    PcoSemaphore _semD1;      // Sémaphore pour la direction D1
-    PcoSemaphore _semD2;      // Sémaphore pour la direction D2
-    int _waitingD1;           // Nombre de locomotives en attente en direction D1
-    int _waitingD2;           // Nombre de locomotives en attente en direction D2
-    bool _inD1;               // Une locomotive est-elle dans la section en direction D1 ?
-    bool _inD2;               // Une locomotive est-elle dans la section en direction D2 ?
+    std::deque<Waiter> _waitingD1;  // Locomotives en attente en direction D1
+    std::deque<Waiter> _waitingD2;  // Locomotives en attente en direction D2
+    bool _occupied;           // La section est-elle attribuée à une locomotive ?
+    Locomotive* _occupant;    // Locomotive à qui la section est attribuée
+    Direction _direction;     // Direction de la locomotive dans la section
+    bool _left;               // L'occupant a-t-il physiquement quitté la section ?
+    bool _reserved;           // L'occupant a réservé la section mais n'y est pas encore entré
+    bool _stopped;            // Un arrêt d'urgence a-t-il été demandé ?
     int _errorCount;          // Compteur d'erreurs de synchronisation
 };
 
@@ -14,6 +14,8 @@
 #ifndef SHAREDSECTIONINTERFACE_H
 #define SHAREDSECTIONINTERFACE_H
 
+#include <functional>
+
 /**
  * @brief Forward declaration de la classe Locomotive
  * (permet de déclarer des pointeurs/références vers Locomotive
@@ -43,6 +45,34 @@ public:
      */
     virtual void access(Locomotive& loco, Direction d) = 0;
 
+    /**
+     * @brief Version non bloquante de access() : la fonction granted est appelée
+     * lorsque la locomotive a obtenu l'accès, éventuellement depuis un autre thread.
+     * Par défaut, appelle access() puis granted.
+     *
+     * @param loco      Locomotive demandant l’accès
+     * @param d         Direction de déplacement de la locomotive
+     * @param granted   Fonction appelée une fois l'accès obtenu
+     */
+    virtual void accessAsync(Locomotive& loco, Direction d, std::function<void()> granted) {
+        access(loco, d);
+        granted();
+    }
+
+    /**
+     * @brief Réservation anticipée, demandée avant d'arriver à la section : la
+     * locomotive n'est jamais arrêtée par cet appel. La fonction granted est appelée
+     * lorsque la section lui est attribuée, éventuellement depuis un autre thread.
+     * La locomotive appelle ensuite access() à l'entrée, comme sans réservation :
+     * l'accès est immédiat si la réservation a abouti, sinon elle attend à l'entrée.
+     * Par défaut, ne réserve rien.
+     *
+     * @param loco      Locomotive demandant la réservation
+     * @param d         Direction de déplacement de la locomotive
+     * @param granted   Fonction appelée une fois la section attribuée
+     */
+    virtual void reserveAsync(Locomotive& /*loco*/, Direction /*d*/, std::function<void()> /*granted*/) {}
+
     /**
      * @brief Méthode appelée lorsque la locomotive a quitté physiquement
      * la section
@@ -0,0 +1,108 @@
+//  /$$$$$$$   /$$$$$$   /$$$$$$         /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$ 
+// | $$__  $$ /$$__  $$ /$$__  $$       /$$__  $$ /$$$_  $$ /$$__  $$| $$____/ 
+// | $$  \ $$| $$  \__/| $$  \ $$      |__/  \ $$| $$$$\ $$|__/  \ $$| $$      
+// | $$$$$$$/| $$      | $$  | $$        /$$$$$$/| $$ $$ $$  /$$$$$$/| $$$$$$$ 
+// | $$____/ | $$      | $$  | $$       /$$____/ | $$\ $$$$ /$$____/ |_____  $$
+// | $$      | $$    $$| $$  | $$      | $$      | $$ \ $$$| $$       /$$  \ $$
+// | $$      |  $$$$$$/|  $$$$$$/      | $$$$$$$$|  $$$$$$/| $$$$$$$$|  $$$$$$/
+// |__/       \______/  \______/       |________/ \______/ |________/ \______/ 
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include <QApplication>
+
+#include "ctrain_handler.h"
+
+// Le simulateur lance cmain() pour le contexte par défaut et emergency_stop() depuis
+// sa fenêtre : ni l'un ni l'autre n'est utilisé ici
+int cmain() { return 0; }
+void emergency_stop() {}
+
+/**
+ * @brief runProgram Exécute un programme de contrôle dans son propre thread, comme
+ * cmain(), pendant que le thread principal fait avancer les simulateurs
+ */
+static void runProgram(const std::function<void()>& program)
+{
+    std::atomic<bool> done{false};
+    std::thread thread([&] {
+        program();
+        done = true;
+    });
+    while (!done) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    thread.join();
+}
+
+/**
+ * @brief waitPosition Attend que le simulateur publie la position de la loco
+ */
+static bool waitPosition(TrainContext* context, int numLoco, position_loco& position)
+{
+    for (int i = 0; i < 500; ++i) {
+        if (lire_position_loco_ctx(context, numLoco, &position)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+TEST(TrainContext, TwoContextsRunIndependentlyAndAreDestroyed) {
+    runProgram([] {
+        TrainContext* first = creer_contexte();
+        TrainContext* second = creer_contexte();
+        ASSERT_NE(first, nullptr);
+        ASSERT_NE(second, nullptr);
+        ASSERT_NE(first, second);
+        ASSERT_NE(first, contexte_defaut());
+
+        selection_maquette_ctx(first, MAQUETTE_A);
+        selection_maquette_ctx(second, MAQUETTE_A);
+
+        // Une loco par contexte : seule celle du premier roule
+        assigner_loco_ctx(first, 34, 5, 7, 10);
+        assigner_loco_ctx(second, 31, 1, 42, 0);
+        demarrer_simulation_ctx(first);
+        demarrer_simulation_ctx(second);
+
+        position_loco start7{};
+        position_loco start42{};
+        ASSERT_TRUE(waitPosition(first, 7, start7));
+        ASSERT_TRUE(waitPosition(second, 42, start42));
+        ASSERT_NE(start7.contact_avant, 0);
+
+        // Les locos d'un contexte n'existent pas dans l'autre
+        position_loco position{};
+        EXPECT_EQ(lire_position_loco_ctx(first, 42, &position), 0);
+        EXPECT_EQ(lire_position_loco_ctx(second, 7, &position), 0);
+
+        // Le contact devant la loco du premier contexte est atteint, celle du second
+        // n'a pas bougé
+        attendre_contact_ctx(first, start7.contact_avant);
+        ASSERT_TRUE(waitPosition(second, 42, position));
+        EXPECT_EQ(position.vitesse, 0);
+        EXPECT_EQ(position.contact_avant, start42.contact_avant);
+        EXPECT_EQ(position.distance_contact, start42.distance_contact);
+
+        arreter_loco_ctx(first, 7);
+        mettre_maquette_hors_service_ctx(first);
+        mettre_maquette_hors_service_ctx(second);
+        detruire_contexte(first);
+        detruire_contexte(second);
+    });
+}
+
+int main(int argc, char** argv)
+{
+    // Les contextes n'ont pas de fenêtre visible, mais leurs vues en demandent une
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -9,13 +9,26 @@
 
 #include <gtest/gtest.h>
 #include <atomic>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include <pcosynchro/pcothread.h>
 #include <pcosynchro/pcosemaphore.h>
 
+#include <QApplication>
+#include <QTemporaryFile>
+
 #include "sharedsection.h"
 #include "sharedsectioninterface.h"
+#include "routecompiler.h"
+#include "scenariogrid.h"
+#include "fleetconfig.h"
+#include "executor.h"
+#include "locotask.h"
+#include "ctrain_handler.h"
+#include "simtrace.h"
+#include "contact.h"
 
 static void enterCritical(std::atomic<int>& nbIn) {
     int now = nbIn.fetch_add(1) + 1;
@@ -72,3 +85,385 @@ TEST(SharedSection, LeaveWrongDirection_IsError) {
     ASSERT_EQ(section.nbErrors(), 1);
 }
 
+
+TEST(SharedSection, ReleaseWithoutLeave_IsError) {
+    SharedSection section;
+    Locomotive l1(1, 10, 0);
+
+    section.access(l1, SharedSectionInterface::Direction::D1);
+    section.release(l1);
+
+    ASSERT_EQ(section.nbErrors(), 1);
+}
+
+TEST(SharedSection, Release_HandsOverToOppositeDirectionFirst) {
+    SharedSection section;
+    Locomotive l1(1, 10, 0), l2(2, 10, 0), l3(3, 10, 0);
+    bool granted2 = false, granted3 = false;
+
+    section.access(l1, SharedSectionInterface::Direction::D1);
+    section.accessAsync(l2, SharedSectionInterface::Direction::D1, [&]{ granted2 = true; });
+    section.accessAsync(l3, SharedSectionInterface::Direction::D2, [&]{ granted3 = true; });
+
+    // l3 est arrivée après l2, mais dans la direction opposée : elle passe d'abord
+    section.leave(l1, SharedSectionInterface::Direction::D1);
+    section.release(l1);
+    ASSERT_TRUE(granted3);
+    ASSERT_FALSE(granted2);
+
+    section.leave(l3, SharedSectionInterface::Direction::D2);
+    section.release(l3);
+    ASSERT_TRUE(granted2);
+
+    section.leave(l2, SharedSectionInterface::Direction::D1);
+    section.release(l2);
+    ASSERT_EQ(section.nbErrors(), 0);
+}
+
+
+TEST(SharedSection, AccessAsync_GrantedOnRelease) {
+    SharedSection section;
+    Locomotive l1(1, 10, 0), l2(2, 10, 0);
+    bool granted1 = false, granted2 = false;
+
+    section.accessAsync(l1, SharedSectionInterface::Direction::D1, [&]{ granted1 = true; });
+    ASSERT_TRUE(granted1);
+
+    // La section est occupée : l2 est arrêtée et son accès différé
+    section.accessAsync(l2, SharedSectionInterface::Direction::D2, [&]{ granted2 = true; });
+    ASSERT_FALSE(granted2);
+    ASSERT_EQ(l2.stops(), 1);
+
+    section.leave(l1, SharedSectionInterface::Direction::D1);
+    section.release(l1);
+    ASSERT_TRUE(granted2);
+    ASSERT_EQ(l2.starts(), 1);
+
+    section.leave(l2, SharedSectionInterface::Direction::D2);
+    section.release(l2);
+    ASSERT_EQ(section.nbErrors(), 0);
+}
+
+
+TEST(SharedSection, ReserveAsync_GrantedAheadWithoutStopping) {
+    SharedSection section;
+    Locomotive l1(1, 10, 0), l2(2, 10, 0);
+    bool reserved1 = false, reserved2 = false;
+
+    // Section libre : attribuée dès la réservation, l'accès à l'entrée est immédiat
+    section.reserveAsync(l1, SharedSectionInterface::Direction::D1, [&]{ reserved1 = true; });
+    ASSERT_TRUE(reserved1);
+
+    // Section réservée : l2 continue de rouler en attendant
+    section.reserveAsync(l2, SharedSectionInterface::Direction::D1, [&]{ reserved2 = true; });
+    ASSERT_FALSE(reserved2);
+
+    section.access(l1, SharedSectionInterface::Direction::D1);
+    ASSERT_EQ(l1.stops(), 0);
+    section.leave(l1, SharedSectionInterface::Direction::D1);
+    section.release(l1);
+
+    ASSERT_TRUE(reserved2);
+    ASSERT_EQ(l2.stops(), 0);
+    ASSERT_EQ(l2.starts(), 0);
+    section.access(l2, SharedSectionInterface::Direction::D1);
+    section.leave(l2, SharedSectionInterface::Direction::D1);
+    section.release(l2);
+    ASSERT_EQ(section.nbErrors(), 0);
+}
+
+TEST(SharedSection, ReserveAsync_ArrivalBeforeGrantStops) {
+    SharedSection section;
+    Locomotive l1(1, 10, 0), l2(2, 10, 0);
+    bool reserved2 = false, granted2 = false;
+
+    section.access(l1, SharedSectionInterface::Direction::D1);
+    section.reserveAsync(l2, SharedSectionInterface::Direction::D2, [&]{ reserved2 = true; });
+
+    // l2 atteint l'entrée avant que l1 ne libère la section : elle s'y arrête
+    section.accessAsync(l2, SharedSectionInterface::Direction::D2, [&]{ granted2 = true; });
+    ASSERT_FALSE(granted2);
+    ASSERT_EQ(l2.stops(), 1);
+
+    section.leave(l1, SharedSectionInterface::Direction::D1);
+    section.release(l1);
+    ASSERT_TRUE(reserved2);
+    ASSERT_TRUE(granted2);
+    ASSERT_EQ(l2.starts(), 1);
+
+    section.leave(l2, SharedSectionInterface::Direction::D2);
+    section.release(l2);
+    ASSERT_EQ(section.nbErrors(), 0);
+}
+
+TEST(Executor, PostFromOutsideAndInsideThePool) {
+    std::atomic<int> done{0};
+    {
+        Executor executor(4);
+        for (int i = 0; i < 100; ++i) {
+            executor.post([&] {
+                // Chaque tâche en soumet d'autres depuis le pool
+                for (int j = 0; j < 10; ++j) {
+                    executor.post([&] { done++; });
+                }
+                done++;
+            });
+        }
+    }
+    ASSERT_EQ(done.load(), 100 * 11);
+}
+
+TEST(Executor, LocalTasksRunLastInFirst) {
+    std::vector<int> order;
+    {
+        // Un seul thread : pas de vol, la file locale est traitée en LIFO
+        Executor executor(1);
+        executor.post([&] {
+            for (int i = 1; i <= 3; ++i) {
+                executor.post([&order, i] { order.push_back(i); });
+            }
+        });
+    }
+    ASSERT_EQ(order, (std::vector<int>{3, 2, 1}));
+}
+
+TEST(Executor, StolenTasksRunFirstInFirst) {
+    std::vector<int> order;
+    PcoSemaphore stolen(0);
+    {
+        Executor executor(2);
+        executor.post([&] {
+            // Ce thread reste occupé : l'autre vole ses tâches, les plus anciennes d'abord
+            for (int i = 1; i <= 3; ++i) {
+                executor.post([&order, &stolen, i] { order.push_back(i); stolen.release(); });
+            }
+            for (int i = 1; i <= 3; ++i) {
+                stolen.acquire();
+            }
+        });
+    }
+    ASSERT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(Executor, DestructorDrainsPendingTasks) {
+    std::atomic<int> done{0};
+    PcoSemaphore gate(0);
+    {
+        Executor executor(1);
+        executor.post([&] { gate.acquire(); });
+        for (int i = 0; i < 50; ++i) {
+            executor.post([&] { done++; });
+        }
+        // Les 50 tâches sont encore en attente derrière la première
+        EXPECT_EQ(done.load(), 0);
+        gate.release();
+    }
+    ASSERT_EQ(done.load(), 50);
+}
+
+static LocoTask crossSection(SharedSection& section, Locomotive& loco, std::thread::id& resumedOn) {
+    co_await sectionAccess(section, loco, SharedSectionInterface::Direction::D2);
+    resumedOn = std::this_thread::get_id();
+    section.leave(loco, SharedSectionInterface::Direction::D2);
+    section.release(loco);
+}
+
+TEST(LocoTask, ResumedFromAnotherThreadThroughSectionAccess) {
+    SharedSection section;
+    Locomotive l1(1, 10, 0), l2(2, 10, 0);
+    std::thread::id resumedOn, releasedOn;
+    PcoSemaphore finished(0);
+
+    section.access(l1, SharedSectionInterface::Direction::D1);
+
+    Executor executor(2);
+    LocoTask task = crossSection(section, l2, resumedOn);
+    task.start(executor, [&] { finished.release(); });
+
+    // La coroutine est suspendue à l'entrée, sa locomotive arrêtée
+    while (l2.stops() == 0) {
+        PcoThread::usleep(100);
+    }
+
+    PcoThread releaser([&] {
+        releasedOn = std::this_thread::get_id();
+        section.leave(l1, SharedSectionInterface::Direction::D1);
+        section.release(l1);
+    });
+    releaser.join();
+    finished.acquire();
+
+    // La reprise est soumise à l'exécuteur, elle n'a pas lieu dans le thread qui libère
+    ASSERT_NE(resumedOn, releasedOn);
+    ASSERT_EQ(l2.starts(), 1);
+    ASSERT_EQ(section.nbErrors(), 0);
+}
+
+// Maquette en anneau 1-2-3-4-5-6 ; l'aiguillage 7 est pris entre 3 et 4
+static bool ringLeg(int, int from, int to, std::vector<int>& contacts, std::vector<SwitchSetting>& switches) {
+    contacts.clear();
+    switches.clear();
+    for (int c = from; ; c = c % 6 + 1) {
+        contacts.push_back(c);
+        if (c == 3 && c != to) {
+            switches.push_back({7, 1});
+        }
+        if (c == to && contacts.size() > 1) {
+            return true;
+        }
+    }
+}
+
+TEST(RouteCompiler, ExpandsWaypointsIntoContactTables) {
+    Route route;
+    route.path = {1, 3, 5};
+    route.sharedSectionContacts = {3, 5};
+
+    ASSERT_TRUE(RouteCompiler(ringLeg).compile(route));
+    ASSERT_EQ(route.path, (std::vector<int>{1, 2, 3, 4, 5, 6}));
+    ASSERT_EQ(route.switches, (std::vector<SwitchSetting>{{7, 1}}));
+
+    // Le contact 4, entre deux contacts de la section, en fait partie ; l'entrée
+    // et la sortie dépendent du sens de parcours
+    ASSERT_EQ(route.flags, (std::vector<uint16_t>{
+        Route::PreEntryClockwise | Route::PreEntryCounterClockwise,
+        Route::ExitCounterClockwise | Route::BrakeClockwise,
+        Route::Shared | Route::SwitchAhead | Route::EntryClockwise,
+        Route::Shared,
+        Route::Shared | Route::EntryCounterClockwise,
+        Route::ExitClockwise | Route::BrakeCounterClockwise}));
+}
+
+TEST(RouteCompiler, ConflictingSwitchesAreRejected) {
+    std::vector<SwitchSetting> merged{{7, 1}};
+    ASSERT_TRUE(RouteCompiler::mergeSwitches(merged, {{7, 1}, {8, 0}}));
+    ASSERT_EQ(merged.size(), 2u);
+    ASSERT_FALSE(RouteCompiler::mergeSwitches(merged, {{8, 1}}));
+
+    // Un tronçon introuvable laisse l'itinéraire intact
+    Route route;
+    route.path = {1, 4};
+    RouteCompiler failing([](int, int, int, std::vector<int>&, std::vector<SwitchSetting>&) { return false; });
+    ASSERT_FALSE(failing.compile(route));
+    ASSERT_EQ(route.path, (std::vector<int>{1, 4}));
+}
+
+TEST(RouteCompiler, TabulatesReversalsAndStations) {
+    Route route;
+    route.path = {1, 2, 3};
+    route.directionChangePoints = {3};
+    route.stations = {2};
+    RouteCompiler::tabulate(route);
+
+    ASSERT_EQ(route.flags, (std::vector<uint16_t>{0, Route::Station, Route::Reverse}));
+}
+
+TEST(ScenarioGrid, ExpandsCartesianProductWithRepetitions) {
+    std::istringstream in("# grille\n"
+                          "vitesse 8 12   # deux vitesses\n"
+                          "reservation 0 1\n"
+                          "repetitions 2\n");
+    ScenarioGrid grid;
+    std::string error;
+    ASSERT_TRUE(grid.parse(in, error)) << error;
+    ASSERT_EQ(grid.names(), (std::vector<std::string>{"vitesse", "reservation"}));
+
+    std::vector<Scenario> scenarios = grid.expand();
+    ASSERT_EQ(scenarios.size(), 8u);
+    ASSERT_EQ(scenarios[0].value("vitesse"), "8");
+    ASSERT_EQ(scenarios[0].value("reservation"), "0");
+    ASSERT_EQ(scenarios[1].repetition, 1);
+    ASSERT_EQ(scenarios[2].value("reservation"), "1");
+    ASSERT_EQ(scenarios[7].value("vitesse"), "12");
+    ASSERT_EQ(scenarios[7].value("executeur", "0"), "0");
+
+    // Un paramètre répété est refusé, la grille précédente est conservée
+    std::istringstream invalid("vitesse 8\nvitesse 12\n");
+    ASSERT_FALSE(grid.parse(invalid, error));
+    ASSERT_EQ(grid.expand().size(), 8u);
+}
+
+TEST(FleetConfig, RejectsInvalidAndDuplicateLocos) {
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    std::string content =
+        "section 5 7\n"
+        "loco 7 10 34 5 horaire : 34 1 5\n"
+        "loco 7 12 31 1 antihoraire : 31 33 1   # numéro déjà pris\n"
+        "loco 0 10 34 5 horaire : 34 1\n"
+        "loco " + std::to_string(MAX_LOCOS + 1) + " 10 34 5 horaire : 34 1\n"
+        "loco 8 0 34 5 horaire : 34 1\n"
+        "loco 9 " + std::to_string(VITESSE_MAXIMUM + 1) + " 34 5 horaire : 34 1\n"
+        "loco 10 10 0 5 horaire : 34 1\n"
+        "loco 42 12 31 1 antihoraire : 31 33 1\n";
+    file.write(content.c_str());
+    file.close();
+
+    FleetConfig fleet;
+    ASSERT_TRUE(fleet.load(file.fileName()));
+    ASSERT_EQ(fleet.locos.size(), 2u);
+    ASSERT_EQ(fleet.locos[0].number, 7);
+    ASSERT_EQ(fleet.locos[0].speed, 10);
+    ASSERT_EQ(fleet.locos[1].number, 42);
+    ASSERT_EQ(fleet.locos[1].route.sharedSectionContacts, (std::set<int>{5, 7}));
+}
+
+TEST(SimTrace, CommandIssuedFromContactWait_Replays) {
+    // Un contact prépare l'affichage de son numéro : il lui faut une application,
+    // sans affichage réel
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    int argc = 1;
+    char name[] = "unit_tests";
+    char* argv[] = {name, nullptr};
+    QApplication app(argc, argv);
+
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    TraceEnregistreur recorder;
+    ASSERT_TRUE(recorder.demarrer(file.fileName()));
+
+    // Enregistrement de l'activation comme CommandeTrain::contactActive(), dans le thread
+    // qui active le contact. Le délai élargit la fenêtre pendant laquelle une commande
+    // du programme réveillé pourrait précéder l'activation dans la trace.
+    Contact contact(5, 1);
+    QObject::connect(&contact, &Contact::activation, [&](int numero) {
+        PcoThread::usleep(5000);
+        recorder.enregistrer(0, EvenementTrace::ACTIVATION_CONTACT, numero);
+    });
+
+    std::atomic<int> issued{0};
+    PcoThread controller([&] {
+        for (int lap = 0; lap < 3; lap++) {
+            recorder.enregistrer(0, EvenementTrace::ATTENTE_CONTACT, 5);
+            contact.attendContact();
+            recorder.enregistrer(0, EvenementTrace::VITESSE, 1, 8 + lap);
+            issued++;
+        }
+    });
+    for (int lap = 0; lap < 3; lap++) {
+        while (issued.load() < lap || contact.getNbreAttentes() == 0) {
+            PcoThread::usleep(100);
+        }
+        contact.active();
+    }
+    controller.join();
+    recorder.arreter();
+
+    TraceRejoueur replayer;
+    ASSERT_TRUE(replayer.charger(file.fileName()));
+    replayer.start();
+
+    PcoThread replayed([&] {
+        for (int lap = 0; lap < 3; lap++) {
+            replayer.attendreContact(5);
+            replayer.commande(EvenementTrace::VITESSE, 1, 8 + lap);
+        }
+    });
+
+    replayer.wait();
+    bool diverged = replayer.aDiverge();
+    // Libère le programme s'il attend encore un contact après une divergence
+    replayer.interrompre();
+    replayed.join();
+    ASSERT_FALSE(diverged);
+}